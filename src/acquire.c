@@ -0,0 +1,214 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "phase.h"
+
+static void set_message(struct acquire *acq, const char *prefix,
+                        WGPUStringView message)
+{
+    size_t len = message.length;
+    if (message.data == NULL) {
+        len = 0;
+    } else if (len == WGPU_STRLEN) {
+        len = strlen(message.data);
+    }
+    snprintf(acq->message, sizeof(acq->message), "%s: %.*s", prefix,
+             ( int )len, len ? message.data : "");
+}
+
+static void device_callback(WGPURequestDeviceStatus status, WGPUDevice device,
+                            WGPUStringView message, void *userdata1,
+                            void *userdata2)
+{
+    struct acquire *acq = userdata1;
+    (void)userdata2;
+
+    acq->device_ns = phase_now_ns() - acq->mark_ns;
+    if (status != WGPURequestDeviceStatus_Success) {
+        set_message(acq, "Request Device callback not successful", message);
+        acq->status = ACQUIRE_ERROR;
+        return;
+    }
+    acq->device = device;
+    acq->queue  = wgpuDeviceGetQueue(device);
+    acq->status = ACQUIRE_SUCCESS;
+}
+
+/* The device descriptor to request with: the caller's, or a copy carrying
+ * the heap block size stored for this adapter. */
+static const WGPUDeviceDescriptor *device_descriptor(struct acquire *acq,
+                                                     WGPUAdapter     adapter)
+{
+    if (acq->options.heap_tuner_store == NULL) {
+        return acq->options.device;
+    }
+    struct adapter_caps caps;
+    if (!caps_query(adapter, &caps)) {
+        return acq->options.device;
+    }
+    WGPUDeviceDescriptor desc = WGPU_DEVICE_DESCRIPTOR_INIT;
+    if (acq->options.device != NULL) {
+        desc = *acq->options.device;
+    }
+    bool tuned = heap_tuner_apply(acq->options.heap_tuner_store, &caps, &desc,
+                                  &acq->tuned_storage);
+    caps_free(&caps);
+    if (!tuned) {
+        return acq->options.device;
+    }
+    acq->tuned = desc;
+    return &acq->tuned;
+}
+
+static void adapter_callback(WGPURequestAdapterStatus status,
+                             WGPUAdapter adapter, WGPUStringView message,
+                             void *userdata1, void *userdata2)
+{
+    struct acquire *acq = userdata1;
+    (void)userdata2;
+
+    uint64_t now    = phase_now_ns();
+    acq->adapter_ns = now - acq->mark_ns;
+    acq->mark_ns    = now;
+    if (status != WGPURequestAdapterStatus_Success) {
+        set_message(acq, "Request Adapter callback not successful", message);
+        acq->status = ACQUIRE_ERROR;
+        return;
+    }
+    acq->adapter = adapter;
+    if (!acq->options.request_device) {
+        acq->status = ACQUIRE_SUCCESS;
+        return;
+    }
+
+    /* Chain the device request straight off the adapter so the waiter just
+     * moves on to the next future without returning to the caller. */
+    WGPURequestDeviceCallbackInfo callbackInfo =
+            WGPU_REQUEST_DEVICE_CALLBACK_INFO_INIT;
+    callbackInfo.mode      = WGPUCallbackMode_WaitAnyOnly;
+    callbackInfo.callback  = device_callback;
+    callbackInfo.userdata1 = acq;
+    acq->future = wgpuAdapterRequestDevice(
+            adapter, device_descriptor(acq, adapter), callbackInfo);
+}
+
+bool acquire_init(struct acquire *acq)
+{
+    memset(acq, 0, sizeof(*acq));
+
+    WGPUInstanceCapabilities caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    if (wgpuGetInstanceCapabilities(&caps) != WGPUStatus_Success) {
+        caps.timedWaitAnyEnable   = false;
+        caps.timedWaitAnyMaxCount = 0;
+    }
+
+    WGPUInstanceDescriptor instanceDesc = WGPU_INSTANCE_DESCRIPTOR_INIT;
+    instanceDesc.capabilities.timedWaitAnyEnable   = caps.timedWaitAnyEnable;
+    instanceDesc.capabilities.timedWaitAnyMaxCount = caps.timedWaitAnyMaxCount;
+    uint64_t start   = phase_now_ns();
+    acq->instance    = wgpuCreateInstance(&instanceDesc);
+    acq->instance_ns = phase_now_ns() - start;
+    if (acq->instance == NULL) {
+        snprintf(acq->message, sizeof(acq->message),
+                 "Unable to create WGPU instance");
+        return false;
+    }
+    acq->caps = instanceDesc.capabilities;
+    return true;
+}
+
+void acquire_begin(struct acquire *acq, const struct acquire_options *options)
+{
+    acq->options = *options;
+    acq->status  = ACQUIRE_PENDING;
+    acq->mark_ns = phase_now_ns();
+
+    WGPURequestAdapterCallbackInfo callbackInfo =
+            WGPU_REQUEST_ADAPTER_CALLBACK_INFO_INIT;
+    callbackInfo.mode      = WGPUCallbackMode_WaitAnyOnly;
+    callbackInfo.callback  = adapter_callback;
+    callbackInfo.userdata1 = acq;
+    acq->future            = wgpuInstanceRequestAdapter(
+            acq->instance, acq->options.adapter, callbackInfo);
+}
+
+acquire_status acquire_wait(struct acquire *acq, uint64_t timeout_ns)
+{
+    if (timeout_ns > 0 && !acq->caps.timedWaitAnyEnable) {
+        snprintf(acq->message, sizeof(acq->message),
+                 "Timed waits are not supported by this instance");
+        return ACQUIRE_ERROR;
+    }
+
+    uint64_t deadline = timeout_ns;
+    if (timeout_ns != ACQUIRE_TIMEOUT_INFINITE && timeout_ns > 0) {
+        deadline = phase_now_ns() + timeout_ns;
+    }
+
+    while (acq->status == ACQUIRE_PENDING) {
+        uint64_t remaining = timeout_ns;
+        if (timeout_ns != ACQUIRE_TIMEOUT_INFINITE && timeout_ns > 0) {
+            uint64_t now = phase_now_ns();
+            remaining    = now < deadline ? deadline - now : 0;
+        }
+
+        /* Each link of the chain is waited on alone, so a single future
+         * always fits within timedWaitAnyMaxCount. */
+        WGPUFutureWaitInfo waitInfo = WGPU_FUTURE_WAIT_INFO_INIT;
+        waitInfo.future             = acq->future;
+        WGPUWaitStatus waitStatus =
+                wgpuInstanceWaitAny(acq->instance, 1, &waitInfo, remaining);
+        if (waitStatus == WGPUWaitStatus_TimedOut) {
+            if (timeout_ns != ACQUIRE_TIMEOUT_INFINITE) {
+                return ACQUIRE_TIMED_OUT;
+            }
+            continue;
+        }
+        if (waitStatus != WGPUWaitStatus_Success) {
+            snprintf(acq->message, sizeof(acq->message),
+                     "Unsuccessful instance wait any call");
+            acq->status = ACQUIRE_ERROR;
+        }
+    }
+    return acq->status;
+}
+
+void acquire_release(struct acquire *acq)
+{
+    if (acq->queue != NULL) {
+        wgpuQueueRelease(acq->queue);
+    }
+    if (acq->device != NULL) {
+        wgpuDeviceRelease(acq->device);
+    }
+    if (acq->adapter != NULL) {
+        wgpuAdapterRelease(acq->adapter);
+    }
+    if (acq->instance != NULL) {
+        wgpuInstanceRelease(acq->instance);
+    }
+    memset(acq, 0, sizeof(*acq));
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
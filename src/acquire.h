@@ -0,0 +1,94 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_ACQUIRE_H
+#define WGPU_ACQUIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "heap_tuner.h"
+
+#define ACQUIRE_TIMEOUT_INFINITE UINT64_MAX
+#define ACQUIRE_MESSAGE_MAX      256
+
+typedef enum acquire_status {
+    ACQUIRE_PENDING = 0,
+    ACQUIRE_SUCCESS,
+    ACQUIRE_TIMED_OUT,
+    ACQUIRE_ERROR,
+} acquire_status;
+
+/* What to acquire: the adapter options are forwarded to
+ * wgpuInstanceRequestAdapter and, when request_device is set, the device
+ * descriptor (which may be NULL) to wgpuAdapterRequestDevice. When
+ * heap_tuner_store names a heap_tune store, the block size stored for the
+ * adapter is applied to the device request with heap_tuner_apply. */
+struct acquire_options {
+    const WGPURequestAdapterOptions *adapter;
+    const WGPUDeviceDescriptor      *device;
+    bool                             request_device;
+    const char                      *heap_tuner_store;
+};
+
+/* Adapter and device acquisition as a single chain of futures. The adapter
+ * callback issues the device request itself, so acquire_wait() only ever
+ * blocks inside wgpuInstanceWaitAny() on whichever link is outstanding. */
+struct acquire {
+    WGPUInstance             instance;
+    WGPUInstanceCapabilities caps;
+    WGPUAdapter              adapter;
+    WGPUDevice               device;
+    WGPUQueue                queue;
+
+    WGPUFuture             future;
+    struct acquire_options options;
+    acquire_status         status;
+    char                   message[ACQUIRE_MESSAGE_MAX];
+
+    /* The device descriptor as tuned by heap_tuner_apply. */
+    WGPUDeviceDescriptor     tuned;
+    struct heap_tuner_device tuned_storage;
+
+    /* How long each link took, in phase_now_ns() nanoseconds. */
+    uint64_t instance_ns;
+    uint64_t adapter_ns;
+    uint64_t device_ns;
+    uint64_t mark_ns;
+};
+
+/* Creates the instance with timed waits enabled whenever the implementation
+ * reports support for them through wgpuGetInstanceCapabilities(). */
+bool acquire_init(struct acquire *acq);
+
+/* Starts the chain; never blocks. */
+void acquire_begin(struct acquire *acq, const struct acquire_options *options);
+
+/* Waits at most timeout_ns for the whole chain to resolve. A zero timeout
+ * only polls, and any other value requires an instance with timed waits. On
+ * ACQUIRE_TIMED_OUT the chain is left intact and may be waited on again. */
+acquire_status acquire_wait(struct acquire *acq, uint64_t timeout_ns);
+
+/* Releases whatever was acquired, including the instance. */
+void acquire_release(struct acquire *acq);
+
+#endif /* ifndef WGPU_ACQUIRE_H */
@@ -17,105 +17,228 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
-#include <_time.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <dawn/webgpu.h>
 
+#include "acquire.h"
+#include "caps.h"
+#include "dump.h"
+#include "enumerate.h"
 #include "feature_names.h"
+#include "phase.h"
+#include "snapshot.h"
+#include "writer.h"
 
-void callback(WGPURequestAdapterStatus status, WGPUAdapter adapter,
-              struct WGPUStringView message, void *userdata1, void *userdata2)
+static void usage(const char *prog)
 {
-    if (status != WGPURequestAdapterStatus_Success) {
-        fprintf(stderr, "Request Adapter callback not successfull: %s\n",
-                message.data);
-        return;
-    }
-    memmove(userdata1, &adapter, sizeof(WGPUAdapter));
+    fprintf(stderr,
+            "Usage: %s [--json | --binary] [--snapshot PATH]\n"
+            "       %s --all [--json]\n"
+            "       %s --profile RUNS\n",
+            prog, prog, prog);
 }
 
-int main(int argc, char *argv[])
+static bool open_adapter(struct acquire *acq)
 {
-    WGPUInstanceDescriptor instanceDesc          = {0};
-    instanceDesc.capabilities.timedWaitAnyEnable = true;
-    WGPUInstance instance = wgpuCreateInstance(&instanceDesc);
-    if (instance == NULL) {
-        fprintf(stderr, "Unable to create WGPU instance\n");
-        return EXIT_FAILURE;
+    if (!acquire_init(acq)) {
+        fprintf(stderr, "%s\n", acq->message);
+        return false;
     }
 
     WGPURequestAdapterOptions options = {0};
-    WGPUAdapter               adapter;
-
-    WGPURequestAdapterCallbackInfo callbackInfo = {0};
-    callbackInfo.mode                           = WGPUCallbackMode_WaitAnyOnly;
-    callbackInfo.userdata1                      = &adapter;
-    callbackInfo.callback = ( WGPURequestAdapterCallback )callback;
-
-    WGPUFuture future =
-            wgpuInstanceRequestAdapter(instance, &options, callbackInfo);
-    WGPUFutureWaitInfo futureInfo = {.future = future, .completed = false};
-    WGPUWaitStatus     waitStatus =
-            wgpuInstanceWaitAny(instance, 1, &futureInfo, UINT64_MAX);
-
-    struct timespec ts;
-    ts.tv_sec  = 0;
-    ts.tv_nsec = 200 * 1000;
-    while (!futureInfo.completed) {
-        printf("Waiting for future to complete...\n");
-        nanosleep(&ts, NULL);
+    acquire_begin(acq, &(struct acquire_options){.adapter = &options});
+    if (acquire_wait(acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS) {
+        fprintf(stderr, "Unable to get adapter from instance: %s\n",
+                acq->message);
+        acquire_release(acq);
+        return false;
     }
+    return true;
+}
 
-    if (waitStatus != WGPUWaitStatus_Success) {
-        fprintf(stderr, "Unsuccessful instance wait any call\n");
+enum output_format { OUTPUT_TEXT, OUTPUT_JSON, OUTPUT_BINARY };
+
+/* All output goes through this one buffer; nothing is allocated per field. */
+static struct writer out;
+
+/* Every adapter on every backend, best scoring first. */
+static int list_all(enum output_format format)
+{
+    struct enumeration   e       = {0};
+    struct score_weights weights = SCORE_WEIGHTS_DEFAULT;
+    if (!enumerate_adapters(&e, &weights)) {
+        fprintf(stderr, "No adapters found\n");
+        enumerate_release(&e);
         return EXIT_FAILURE;
     }
-    if (callbackInfo.userdata1 == NULL) {
-        fprintf(stderr, "Unable to get adapter from instance\n");
+
+    writer_init(&out, STDOUT_FILENO);
+    for (size_t i = 0; i < e.count; ++i) {
+        if (format == OUTPUT_JSON) {
+            dump_json(&out, &e.adapters[i].caps);
+            continue;
+        }
+        char score[32];
+        snprintf(score, sizeof(score), "%.3f", e.adapters[i].score);
+        writer_str(&out, i ? "\nScore: \t\t" : "Score: \t\t");
+        writer_str(&out, score);
+        writer_str(&out, e.adapters[i].fallback ? " (fallback)\n" : "\n");
+        dump_text(&out, &e.adapters[i].caps);
+    }
+    bool written = writer_flush(&out);
+
+    enumerate_release(&e);
+    return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Times the whole bootstrap, instance through device, over repeated runs
+ * and reports per-phase percentiles as JSON. */
+static int profile(size_t runs)
+{
+    struct phase_profile p;
+    if (!phase_init(&p, runs)) {
+        fprintf(stderr, "Unable to allocate %zu profile runs\n", runs);
         return EXIT_FAILURE;
     }
+    int instance = phase_define(&p, "instance");
+    int adapter  = phase_define(&p, "adapter");
+    int device   = phase_define(&p, "device");
+    int info     = phase_define(&p, "info");
+    int total    = phase_define(&p, "total");
+
+    WGPURequestAdapterOptions options = {0};
+    for (size_t i = 0; i < runs; ++i) {
+        uint64_t       start = phase_now_ns();
+        struct acquire acq;
+        if (!acquire_init(&acq)) {
+            fprintf(stderr, "%s\n", acq.message);
+            phase_free(&p);
+            return EXIT_FAILURE;
+        }
+        acquire_begin(&acq, &(struct acquire_options){.adapter = &options,
+                                                      .request_device = true});
+        if (acquire_wait(&acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS) {
+            fprintf(stderr, "%s\n", acq.message);
+            acquire_release(&acq);
+            phase_free(&p);
+            return EXIT_FAILURE;
+        }
+
+        struct adapter_caps caps;
+        phase_begin(&p, info);
+        bool queried = caps_query(acq.adapter, &caps);
+        phase_end(&p, info);
+
+        phase_record(&p, instance, acq.instance_ns);
+        phase_record(&p, adapter, acq.adapter_ns);
+        phase_record(&p, device, acq.device_ns);
+        phase_record(&p, total, phase_now_ns() - start);
+        phase_next_run(&p);
+
+        if (queried) {
+            caps_free(&caps);
+        }
+        acquire_release(&acq);
+    }
 
-    WGPUDawnAdapterPropertiesPowerPreference power_props =
-            WGPU_DAWN_ADAPTER_PROPERTIES_POWER_PREFERENCE_INIT;
-    WGPUAdapterInfo adapterInfo = {0};
-    adapterInfo.nextInChain     = ( WGPUChainedStruct * )&power_props;
-    WGPUStatus infoStatus       = wgpuAdapterGetInfo(adapter, &adapterInfo);
-    if (infoStatus != WGPUStatus_Success) {
-        fprintf(stderr, "Unable to get adapter info\n");
+    writer_init(&out, STDOUT_FILENO);
+    phase_json(&out, &p);
+    bool written = writer_flush(&out);
+    phase_free(&p);
+    return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    const char        *snapshot_path = NULL;
+    enum output_format format        = OUTPUT_TEXT;
+    bool               all           = false;
+    long               runs          = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--all") == 0) {
+            all = true;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            runs = strtol(argv[++i], NULL, 10);
+            if (runs <= 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--json") == 0) {
+            format = OUTPUT_JSON;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            format = OUTPUT_BINARY;
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((all && (snapshot_path || format == OUTPUT_BINARY)) ||
+        (runs > 0 && (all || snapshot_path || format != OUTPUT_TEXT))) {
+        usage(argv[0]);
         return EXIT_FAILURE;
     }
+    if (all) {
+        return list_all(format);
+    }
+    if (runs > 0) {
+        return profile(( size_t )runs);
+    }
 
-    printf("VendorID: \t\t0x%02x\n", adapterInfo.vendorID);
-    char buf[adapterInfo.vendor.length + 1];
-    snprintf(buf, adapterInfo.vendor.length + 1, "%s", adapterInfo.vendor.data);
-    printf("Vendor: \t\t%s\n", buf);
-    char buf2[adapterInfo.architecture.length + 1];
-    snprintf(buf2, adapterInfo.architecture.length + 1, "%s",
-             adapterInfo.architecture.data);
-    printf("Architecture: \t\t%s\n", buf2);
-    printf("DeviceID: \t\t0x%02x\n", adapterInfo.deviceID);
-    char buf3[adapterInfo.device.length + 1];
-    snprintf(buf3, adapterInfo.device.length + 1, "%s",
-             adapterInfo.device.data);
-    printf("Device: \t\t%s\n", buf3);
-    char buf4[adapterInfo.description.length + 1];
-    snprintf(buf4, adapterInfo.description.length + 1, "%s",
-             adapterInfo.description.data);
-    printf("Description: \t\t%s\n", buf4);
-
-    WGPUSupportedFeatures features = {0};
-    wgpuAdapterGetFeatures(adapter, &features);
-    for (size_t i = 0; i < features.featureCount; ++i) {
-        printf("Supports feature: \t%s(0x%02x)\n",
-               _FEATURE_NAME_FROM_CODE(features.features[i]),
-               features.features[i]);
+    /* A valid snapshot answers without creating an instance at all. */
+    struct snapshot            snap        = {0};
+    struct adapter_caps        owned       = {0};
+    const struct adapter_caps *caps        = &owned;
+    uint64_t                   fingerprint = 0;
+    struct acquire             acq;
+    bool                       opened      = false;
+    if (snapshot_path || format == OUTPUT_BINARY) {
+        fingerprint = snapshot_fingerprint();
+    }
+    if (snapshot_path && snapshot_map(&snap, snapshot_path, fingerprint)) {
+        caps = &snap.caps;
+    } else {
+        opened = open_adapter(&acq);
+        if (!opened) {
+            return EXIT_FAILURE;
+        }
+        if (!caps_query(acq.adapter, &owned)) {
+            fprintf(stderr, "Unable to get adapter info\n");
+            acquire_release(&acq);
+            return EXIT_FAILURE;
+        }
+        if (snapshot_path &&
+            !snapshot_write(snapshot_path, fingerprint, &owned)) {
+            fprintf(stderr, "Unable to write snapshot to %s\n", snapshot_path);
+        }
     }
 
-    return EXIT_SUCCESS;
+    writer_init(&out, STDOUT_FILENO);
+    switch (format) {
+    case OUTPUT_TEXT:
+        dump_text(&out, caps);
+        break;
+    case OUTPUT_JSON:
+        dump_json(&out, caps);
+        break;
+    case OUTPUT_BINARY:
+        snapshot_encode(&out, fingerprint, caps);
+        break;
+    }
+    bool written = writer_flush(&out);
+
+    snapshot_unmap(&snap);
+    caps_free(&owned);
+    if (opened) {
+        acquire_release(&acq);
+    }
+    return written ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 // vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
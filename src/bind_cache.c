@@ -0,0 +1,557 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bind_cache.h"
+#include "hash.h"
+#include "key.h"
+
+#define MAP_CAPACITY_MIN 64
+#define SWEEP_AFTER      64
+
+/* A cached layout or bind group. Bind groups also record the generation of
+ * every resource they were built on, so a sweep can tell they went stale. */
+struct entry {
+    void     *object;
+    uint64_t  last_use;
+    size_t    resource_count;
+    uint64_t *resources; /* handle, generation pairs */
+    size_t    key_size;
+    uint8_t   key[];
+};
+
+/* Open addressing with the hash stored inline, so a probe only touches the
+ * entry when the full 64-bit hash matches. */
+struct slot {
+    uint64_t      hash;
+    struct entry *entry;
+};
+
+struct map {
+    struct slot *slots;
+    size_t       mask;
+    size_t       count;
+    size_t       used; /* count plus tombstones */
+};
+
+static struct entry tombstone;
+
+struct generation {
+    uint64_t handle;
+    uint64_t value;
+};
+
+struct bind_cache {
+    WGPUDevice device;
+    size_t     max_groups;
+
+    pthread_mutex_t lock;
+    struct map      layouts;
+    struct map      groups;
+    uint64_t        tick;
+    size_t          stale;
+
+    /* Only handles that were ever invalidated; the rest are generation 0. */
+    struct generation *generations;
+    size_t             generation_mask;
+    size_t             generation_count;
+
+    /* Scratch reused by every lookup. */
+    struct key   key;
+    const void **sorted;
+    size_t       sorted_capacity;
+    uint64_t    *resources;
+    size_t       resource_capacity;
+
+    struct bind_cache_stats stats;
+};
+
+static bool map_init(struct map *map, size_t capacity)
+{
+    map->slots = calloc(capacity, sizeof(*map->slots));
+    map->mask  = capacity - 1;
+    map->count = 0;
+    map->used  = 0;
+    return map->slots != NULL;
+}
+
+static struct slot *map_find(struct map *map, uint64_t hash,
+                             const struct key *key)
+{
+    for (size_t i = hash & map->mask;; i = (i + 1) & map->mask) {
+        struct slot *slot = &map->slots[i];
+        if (slot->entry == NULL) {
+            return NULL;
+        }
+        if (slot->hash == hash && slot->entry != &tombstone &&
+            key_equal(key, slot->entry->key, slot->entry->key_size)) {
+            return slot;
+        }
+    }
+}
+
+static void map_place(struct map *map, uint64_t hash, struct entry *entry)
+{
+    size_t i = hash & map->mask;
+    while (map->slots[i].entry != NULL && map->slots[i].entry != &tombstone) {
+        i = (i + 1) & map->mask;
+    }
+    if (map->slots[i].entry == NULL) {
+        ++map->used;
+    }
+    map->slots[i] = (struct slot){.hash = hash, .entry = entry};
+    ++map->count;
+}
+
+/* Keeps the load, tombstones included, under a half. */
+static bool map_insert(struct map *map, uint64_t hash, struct entry *entry)
+{
+    if (2 * (map->used + 1) > map->mask + 1) {
+        size_t capacity = map->mask + 1;
+        if (2 * (map->count + 1) > capacity / 2) {
+            capacity *= 2;
+        }
+        struct map grown;
+        if (!map_init(&grown, capacity)) {
+            return false;
+        }
+        for (size_t i = 0; i <= map->mask; ++i) {
+            struct slot *slot = &map->slots[i];
+            if (slot->entry != NULL && slot->entry != &tombstone) {
+                map_place(&grown, slot->hash, slot->entry);
+            }
+        }
+        free(map->slots);
+        *map = grown;
+    }
+    map_place(map, hash, entry);
+    return true;
+}
+
+static void map_remove(struct map *map, struct slot *slot)
+{
+    free(slot->entry);
+    slot->entry = &tombstone;
+    --map->count;
+}
+
+static uint64_t generation_of(struct bind_cache *cache, uint64_t h)
+{
+    if (cache->generations == NULL) {
+        return 0;
+    }
+    for (size_t i = hash_mix(h) & cache->generation_mask;;
+         i = (i + 1) & cache->generation_mask) {
+        if (cache->generations[i].handle == h) {
+            return cache->generations[i].value;
+        }
+        if (cache->generations[i].handle == 0) {
+            return 0;
+        }
+    }
+}
+
+static bool generation_bump(struct bind_cache *cache, const void *handle)
+{
+    if (2 * (cache->generation_count + 1) > cache->generation_mask + 1) {
+        size_t capacity = cache->generations
+                                  ? 2 * (cache->generation_mask + 1)
+                                  : MAP_CAPACITY_MIN;
+        struct generation *grown = calloc(capacity, sizeof(*grown));
+        if (grown == NULL) {
+            return false;
+        }
+        for (size_t i = 0; cache->generations && i <= cache->generation_mask;
+             ++i) {
+            struct generation *g = &cache->generations[i];
+            if (g->handle == 0) {
+                continue;
+            }
+            size_t j = hash_mix(g->handle) & (capacity - 1);
+            while (grown[j].handle != 0) {
+                j = (j + 1) & (capacity - 1);
+            }
+            grown[j] = *g;
+        }
+        free(cache->generations);
+        cache->generations     = grown;
+        cache->generation_mask = capacity - 1;
+    }
+
+    uint64_t h = ( uint64_t )( uintptr_t )handle;
+    size_t   i = hash_mix(h) & cache->generation_mask;
+    while (cache->generations[i].handle != 0 &&
+           cache->generations[i].handle != h) {
+        i = (i + 1) & cache->generation_mask;
+    }
+    if (cache->generations[i].handle == 0) {
+        cache->generations[i].handle = h;
+        ++cache->generation_count;
+    }
+    ++cache->generations[i].value;
+    return true;
+}
+
+static int layout_by_binding(const void *a, const void *b)
+{
+    const WGPUBindGroupLayoutEntry *x = *( const void *const * )a;
+    const WGPUBindGroupLayoutEntry *y = *( const void *const * )b;
+    return x->binding < y->binding ? -1 : x->binding > y->binding;
+}
+
+static int group_by_binding(const void *a, const void *b)
+{
+    const WGPUBindGroupEntry *x = *( const void *const * )a;
+    const WGPUBindGroupEntry *y = *( const void *const * )b;
+    return x->binding < y->binding ? -1 : x->binding > y->binding;
+}
+
+/* Points cache->sorted at the entries in binding order, so the order they
+ * were listed in doesn't change the key. */
+static bool sort_entries(struct bind_cache *cache, const void *entries,
+                         size_t count, size_t stride,
+                         int (*compare)(const void *, const void *))
+{
+    if (count > cache->sorted_capacity) {
+        const void **sorted = realloc(cache->sorted, count * sizeof(*sorted));
+        if (sorted == NULL) {
+            return false;
+        }
+        cache->sorted          = sorted;
+        cache->sorted_capacity = count;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        cache->sorted[i] = ( const uint8_t * )entries + i * stride;
+    }
+    qsort(cache->sorted, count, sizeof(*cache->sorted), compare);
+    return true;
+}
+
+static void key_layout(struct bind_cache                   *cache,
+                       const WGPUBindGroupLayoutDescriptor *desc)
+{
+    struct key *key = &cache->key;
+    key_no_chain(key, desc->nextInChain);
+    key_u64(key, desc->entryCount);
+    for (size_t i = 0; i < desc->entryCount; ++i) {
+        const WGPUBindGroupLayoutEntry *e = cache->sorted[i];
+        key_no_chain(key, e->nextInChain);
+        key_u32(key, e->binding);
+        key_u64(key, e->visibility);
+        key_no_chain(key, e->buffer.nextInChain);
+        key_u32(key, e->buffer.type);
+        key_u32(key, e->buffer.hasDynamicOffset);
+        key_u64(key, e->buffer.minBindingSize);
+        key_no_chain(key, e->sampler.nextInChain);
+        key_u32(key, e->sampler.type);
+        key_no_chain(key, e->texture.nextInChain);
+        key_u32(key, e->texture.sampleType);
+        key_u32(key, e->texture.viewDimension);
+        key_u32(key, e->texture.multisampled);
+        key_no_chain(key, e->storageTexture.nextInChain);
+        key_u32(key, e->storageTexture.access);
+        key_u32(key, e->storageTexture.format);
+        key_u32(key, e->storageTexture.viewDimension);
+    }
+}
+
+/* Adds handle and its generation to both the key and the resource list. */
+static void key_resource(struct bind_cache *cache, size_t *count,
+                         const void *handle)
+{
+    uint64_t h          = ( uint64_t )( uintptr_t )handle;
+    uint64_t generation = generation_of(cache, h);
+    key_u64(&cache->key, h);
+    key_u64(&cache->key, generation);
+    if (handle != NULL) {
+        cache->resources[2 * *count]     = h;
+        cache->resources[2 * *count + 1] = generation;
+        ++*count;
+    }
+}
+
+static size_t key_group(struct bind_cache             *cache,
+                        const WGPUBindGroupDescriptor *desc)
+{
+    struct key *key   = &cache->key;
+    size_t      count = 0;
+    key_no_chain(key, desc->nextInChain);
+    key_ptr(key, desc->layout);
+    key_u64(key, desc->entryCount);
+    for (size_t i = 0; i < desc->entryCount; ++i) {
+        const WGPUBindGroupEntry *e = cache->sorted[i];
+        key_no_chain(key, e->nextInChain);
+        key_u32(key, e->binding);
+        key_u64(key, e->offset);
+        key_u64(key, e->size);
+        key_resource(cache, &count, e->buffer);
+        key_resource(cache, &count, e->sampler);
+        key_resource(cache, &count, e->textureView);
+    }
+    return count;
+}
+
+static struct entry *entry_new(const struct key *key, void *object,
+                               const uint64_t *resources, size_t count)
+{
+    size_t        key_size = (key->size + 7) & ~( size_t )7;
+    struct entry *e =
+            malloc(sizeof(*e) + key_size + 2 * count * sizeof(*resources));
+    if (e == NULL) {
+        return NULL;
+    }
+    e->object         = object;
+    e->last_use       = 0;
+    e->resource_count = count;
+    e->resources      = ( uint64_t * )(e->key + key_size);
+    e->key_size       = key->size;
+    memcpy(e->key, key->data, key->size);
+    if (count > 0) {
+        memcpy(e->resources, resources, 2 * count * sizeof(*resources));
+    }
+    return e;
+}
+
+static bool entry_stale(struct bind_cache *cache, const struct entry *e)
+{
+    for (size_t i = 0; i < e->resource_count; ++i) {
+        if (generation_of(cache, e->resources[2 * i]) !=
+            e->resources[2 * i + 1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Drops bind groups built on invalidated resources and, once over budget,
+ * those unused for the last max_groups / 2 lookups. */
+static void sweep(struct bind_cache *cache, bool evict)
+{
+    uint64_t horizon = cache->tick > cache->max_groups / 2
+                               ? cache->tick - cache->max_groups / 2
+                               : 0;
+    for (size_t i = 0; i <= cache->groups.mask; ++i) {
+        struct slot *slot = &cache->groups.slots[i];
+        if (slot->entry == NULL || slot->entry == &tombstone) {
+            continue;
+        }
+        if (entry_stale(cache, slot->entry)) {
+            ++cache->stats.invalidated;
+        } else if (evict && slot->entry->last_use < horizon) {
+            ++cache->stats.evicted;
+        } else {
+            continue;
+        }
+        wgpuBindGroupRelease(slot->entry->object);
+        map_remove(&cache->groups, slot);
+    }
+    cache->stale = 0;
+}
+
+struct bind_cache *bind_cache_create(WGPUDevice                       device,
+                                     const struct bind_cache_options *opts)
+{
+    struct bind_cache *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->device     = device;
+    cache->max_groups = opts && opts->max_groups ? opts->max_groups
+                                                 : BIND_CACHE_GROUPS_DEFAULT;
+    if (!map_init(&cache->layouts, MAP_CAPACITY_MIN) ||
+        !map_init(&cache->groups, MAP_CAPACITY_MIN)) {
+        free(cache->layouts.slots);
+        free(cache);
+        return NULL;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    wgpuDeviceAddRef(device);
+    return cache;
+}
+
+WGPUBindGroupLayout
+bind_cache_layout(struct bind_cache                   *cache,
+                  const WGPUBindGroupLayoutDescriptor *desc)
+{
+    pthread_mutex_lock(&cache->lock);
+    key_reset(&cache->key);
+    if (!sort_entries(cache, desc->entries, desc->entryCount,
+                      sizeof(*desc->entries), layout_by_binding)) {
+        cache->key.failed = true;
+    } else {
+        key_layout(cache, desc);
+    }
+
+    WGPUBindGroupLayout layout = NULL;
+    if (cache->key.failed) {
+        ++cache->stats.uncacheable;
+        pthread_mutex_unlock(&cache->lock);
+        return wgpuDeviceCreateBindGroupLayout(cache->device, desc);
+    }
+
+    uint64_t     hash = key_hash(&cache->key);
+    struct slot *slot = map_find(&cache->layouts, hash, &cache->key);
+    if (slot != NULL) {
+        ++cache->stats.layout_hits;
+        layout = slot->entry->object;
+    } else {
+        ++cache->stats.layout_misses;
+        layout = wgpuDeviceCreateBindGroupLayout(cache->device, desc);
+        struct entry *e = layout ? entry_new(&cache->key, layout, NULL, 0)
+                                 : NULL;
+        if (e == NULL || !map_insert(&cache->layouts, hash, e)) {
+            /* Not cached; the caller gets the only reference. */
+            free(e);
+            pthread_mutex_unlock(&cache->lock);
+            return layout;
+        }
+    }
+    wgpuBindGroupLayoutAddRef(layout);
+    pthread_mutex_unlock(&cache->lock);
+    return layout;
+}
+
+WGPUBindGroup bind_cache_group(struct bind_cache             *cache,
+                               const WGPUBindGroupDescriptor *desc)
+{
+    pthread_mutex_lock(&cache->lock);
+    key_reset(&cache->key);
+
+    size_t count = 0;
+    if (3 * desc->entryCount > cache->resource_capacity) {
+        uint64_t *resources =
+                realloc(cache->resources,
+                        2 * 3 * desc->entryCount * sizeof(*resources));
+        if (resources != NULL) {
+            cache->resources         = resources;
+            cache->resource_capacity = 3 * desc->entryCount;
+        }
+    }
+    if (3 * desc->entryCount > cache->resource_capacity ||
+        !sort_entries(cache, desc->entries, desc->entryCount,
+                      sizeof(*desc->entries), group_by_binding)) {
+        cache->key.failed = true;
+    } else {
+        count = key_group(cache, desc);
+    }
+
+    if (cache->key.failed) {
+        ++cache->stats.uncacheable;
+        pthread_mutex_unlock(&cache->lock);
+        return wgpuDeviceCreateBindGroup(cache->device, desc);
+    }
+
+    uint64_t      hash  = key_hash(&cache->key);
+    struct slot  *slot  = map_find(&cache->groups, hash, &cache->key);
+    WGPUBindGroup group = NULL;
+    ++cache->tick;
+    if (slot != NULL) {
+        ++cache->stats.group_hits;
+        slot->entry->last_use = cache->tick;
+        group                 = slot->entry->object;
+    } else {
+        ++cache->stats.group_misses;
+        if (cache->groups.count >= cache->max_groups) {
+            sweep(cache, true);
+        }
+        group = wgpuDeviceCreateBindGroup(cache->device, desc);
+        struct entry *e =
+                group ? entry_new(&cache->key, group, cache->resources, count)
+                      : NULL;
+        if (e == NULL || !map_insert(&cache->groups, hash, e)) {
+            free(e);
+            pthread_mutex_unlock(&cache->lock);
+            return group;
+        }
+        e->last_use = cache->tick;
+    }
+    wgpuBindGroupAddRef(group);
+    pthread_mutex_unlock(&cache->lock);
+    return group;
+}
+
+void bind_cache_invalidate(struct bind_cache *cache, const void *resource)
+{
+    pthread_mutex_lock(&cache->lock);
+    if (!generation_bump(cache, resource)) {
+        /* Without a new generation the only safe option is to drop every
+         * bind group. */
+        for (size_t i = 0; i <= cache->groups.mask; ++i) {
+            struct slot *slot = &cache->groups.slots[i];
+            if (slot->entry != NULL && slot->entry != &tombstone) {
+                ++cache->stats.invalidated;
+                wgpuBindGroupRelease(slot->entry->object);
+                map_remove(&cache->groups, slot);
+            }
+        }
+    } else if (++cache->stale >= SWEEP_AFTER) {
+        sweep(cache, false);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void bind_cache_stats(struct bind_cache *cache, struct bind_cache_stats *out)
+{
+    pthread_mutex_lock(&cache->lock);
+    *out         = cache->stats;
+    out->layouts = cache->layouts.count;
+    out->groups  = cache->groups.count;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static void release_all(struct map *map, void (*release)(void *))
+{
+    for (size_t i = 0; i <= map->mask; ++i) {
+        struct slot *slot = &map->slots[i];
+        if (slot->entry != NULL && slot->entry != &tombstone) {
+            release(slot->entry->object);
+            free(slot->entry);
+        }
+    }
+    free(map->slots);
+}
+
+static void release_layout(void *object)
+{
+    wgpuBindGroupLayoutRelease(object);
+}
+
+static void release_group(void *object)
+{
+    wgpuBindGroupRelease(object);
+}
+
+void bind_cache_destroy(struct bind_cache *cache)
+{
+    release_all(&cache->groups, release_group);
+    release_all(&cache->layouts, release_layout);
+    pthread_mutex_destroy(&cache->lock);
+    wgpuDeviceRelease(cache->device);
+    key_free(&cache->key);
+    free(cache->sorted);
+    free(cache->resources);
+    free(cache->generations);
+    free(cache);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
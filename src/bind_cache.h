@@ -0,0 +1,74 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_BIND_CACHE_H
+#define WGPU_BIND_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define BIND_CACHE_GROUPS_DEFAULT 4096
+
+struct bind_cache_options {
+    /* Bind groups not used in the last max_groups / 2 lookups are evicted
+     * once the cache holds this many. 0 picks the default. */
+    size_t max_groups;
+};
+
+struct bind_cache_stats {
+    uint64_t layout_hits;
+    uint64_t layout_misses;
+    uint64_t group_hits;
+    uint64_t group_misses;
+    uint64_t uncacheable;
+    uint64_t invalidated; /* bind groups dropped for a destroyed resource */
+    uint64_t evicted;
+    size_t   layouts;
+    size_t   groups;
+};
+
+struct bind_cache;
+
+struct bind_cache *bind_cache_create(WGPUDevice                       device,
+                                     const struct bind_cache_options *opts);
+
+/* Structurally interned: descriptors that only differ in label or entry
+ * order share one layout, which lives as long as the cache. The caller owns
+ * one reference to the result. */
+WGPUBindGroupLayout
+bind_cache_layout(struct bind_cache                   *cache,
+                  const WGPUBindGroupLayoutDescriptor *desc);
+
+/* Cached by layout and each entry's binding, resource, offset and size. The
+ * caller owns one reference to the result. */
+WGPUBindGroup bind_cache_group(struct bind_cache             *cache,
+                               const WGPUBindGroupDescriptor *desc);
+
+/* Call before a buffer, texture view or sampler used in cached bind groups
+ * is destroyed or released. Bumps its generation so no later lookup can hit
+ * a group built on it, even if the handle's address is reused. */
+void bind_cache_invalidate(struct bind_cache *cache, const void *resource);
+
+void bind_cache_stats(struct bind_cache *cache, struct bind_cache_stats *out);
+
+void bind_cache_destroy(struct bind_cache *cache);
+
+#endif /* ifndef WGPU_BIND_CACHE_H */
@@ -0,0 +1,444 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "blob_cache.h"
+#include "hash.h"
+
+#define BLOB_MAGIC     0x424F4C4255504757ull /* "WGPUBLOB" */
+#define BLOB_SEED      0x626C6F6263616368ull
+#define SLOT_EMPTY     0
+#define SLOT_TOMBSTONE 1
+#define NAME_MAX_LEN   4096
+
+struct blob_header {
+    uint64_t magic;
+    uint64_t key_size;
+    uint64_t value_size;
+};
+
+/* Readers only ever probe and bump tick; key and size change under the
+ * writer lock. */
+struct blob_slot {
+    _Atomic uint64_t key;
+    _Atomic uint64_t size;
+    _Atomic uint64_t tick;
+};
+
+struct blob_cache {
+    char    *dir;
+    uint64_t budget;
+    size_t   mask;
+
+    _Atomic uint64_t clock;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t stores;
+    _Atomic uint64_t evictions;
+    _Atomic uint64_t entries;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t temp_serial;
+
+    pthread_mutex_t   write_lock;
+    struct blob_slot *slots;
+    size_t            tombstones; /* under write_lock */
+};
+
+static uint64_t key_hash(const void *key, size_t key_size)
+{
+    uint64_t h = hash_bytes(key, key_size, BLOB_SEED);
+    return h <= SLOT_TOMBSTONE ? h + 2 : h;
+}
+
+static void blob_path(const struct blob_cache *cache, uint64_t h, char *out)
+{
+    snprintf(out, NAME_MAX_LEN, "%s/%016" PRIx64 ".blob", cache->dir, h);
+}
+
+static struct blob_slot *find(struct blob_cache *cache, uint64_t h)
+{
+    for (size_t i = 0; i <= cache->mask; ++i) {
+        struct blob_slot *slot = &cache->slots[(h + i) & cache->mask];
+        uint64_t          key  = atomic_load(&slot->key);
+        if (key == h) {
+            return slot;
+        }
+        if (key == SLOT_EMPTY) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/* Caller holds write_lock. */
+static void remove_slot(struct blob_cache *cache, struct blob_slot *slot)
+{
+    char path[NAME_MAX_LEN];
+    blob_path(cache, atomic_load(&slot->key), path);
+    unlink(path);
+    atomic_fetch_sub(&cache->bytes, atomic_load(&slot->size));
+    atomic_fetch_sub(&cache->entries, 1);
+    atomic_store(&slot->key, SLOT_TOMBSTONE);
+    ++cache->tombstones;
+}
+
+/* Caller holds write_lock. */
+static bool evict_one(struct blob_cache *cache, uint64_t keep)
+{
+    struct blob_slot *victim = NULL;
+    for (size_t i = 0; i <= cache->mask; ++i) {
+        struct blob_slot *slot = &cache->slots[i];
+        uint64_t          key  = atomic_load(&slot->key);
+        if (key <= SLOT_TOMBSTONE || key == keep) {
+            continue;
+        }
+        if (victim == NULL ||
+            atomic_load(&slot->tick) < atomic_load(&victim->tick)) {
+            victim = slot;
+        }
+    }
+    if (victim == NULL) {
+        return false;
+    }
+    remove_slot(cache, victim);
+    atomic_fetch_add(&cache->evictions, 1);
+    return true;
+}
+
+/* Caller holds write_lock. Places a live entry without touching the
+ * counters. */
+static struct blob_slot *place(struct blob_cache *cache, uint64_t h,
+                               uint64_t size, uint64_t tick)
+{
+    for (size_t i = 0; i <= cache->mask; ++i) {
+        struct blob_slot *slot = &cache->slots[(h + i) & cache->mask];
+        uint64_t          key  = atomic_load(&slot->key);
+        if (key <= SLOT_TOMBSTONE) {
+            if (key == SLOT_TOMBSTONE) {
+                --cache->tombstones;
+            }
+            atomic_store(&slot->size, size);
+            atomic_store(&slot->tick, tick);
+            atomic_store(&slot->key, h);
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/* Caller holds write_lock. Clears every tombstone by placing the live
+ * entries afresh, in place so lock free readers never see freed memory; a
+ * load racing the rebuild may miss and is answered by Dawn recompiling. */
+static bool rebuild(struct blob_cache *cache)
+{
+    size_t            count = ( size_t )atomic_load(&cache->entries);
+    struct blob_slot *live  = malloc((count ? count : 1) * sizeof(*live));
+    if (live == NULL) {
+        return false;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i <= cache->mask && n < count; ++i) {
+        struct blob_slot *slot = &cache->slots[i];
+        uint64_t          key  = atomic_load(&slot->key);
+        if (key > SLOT_TOMBSTONE) {
+            atomic_store(&live[n].key, key);
+            atomic_store(&live[n].size, atomic_load(&slot->size));
+            atomic_store(&live[n].tick, atomic_load(&slot->tick));
+            ++n;
+        }
+    }
+    for (size_t i = 0; i <= cache->mask; ++i) {
+        atomic_store(&cache->slots[i].key, SLOT_EMPTY);
+    }
+    cache->tombstones = 0;
+    for (size_t i = 0; i < n; ++i) {
+        place(cache, atomic_load(&live[i].key), atomic_load(&live[i].size),
+              atomic_load(&live[i].tick));
+    }
+    free(live);
+    return true;
+}
+
+/* Caller holds write_lock. */
+static void insert(struct blob_cache *cache, uint64_t h, uint64_t size,
+                   uint64_t tick)
+{
+    struct blob_slot *slot = find(cache, h);
+    if (slot != NULL) {
+        atomic_fetch_sub(&cache->bytes, atomic_load(&slot->size));
+        atomic_fetch_add(&cache->bytes, size);
+        atomic_store(&slot->size, size);
+        atomic_store(&slot->tick, tick);
+        return;
+    }
+
+    /* Probes only stop at an empty slot, so tombstones count toward the
+     * load. Entries are held to three quarters of the table and, once the
+     * two together reach that, tombstones are cleared whenever they exceed
+     * an eighth, which always leaves an eighth of the slots empty. */
+    size_t limit = (cache->mask + 1) / 4 * 3;
+    if (atomic_load(&cache->entries) + cache->tombstones >= limit &&
+        cache->tombstones >= (cache->mask + 1) / 8) {
+        rebuild(cache);
+    }
+    while (atomic_load(&cache->entries) >= limit && evict_one(cache, h)) {
+    }
+    if (place(cache, h, size, tick) != NULL) {
+        atomic_fetch_add(&cache->entries, 1);
+        atomic_fetch_add(&cache->bytes, size);
+    }
+}
+
+static void scan(struct blob_cache *cache)
+{
+    DIR *dir = opendir(cache->dir);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        uint64_t h;
+        char     suffix[8];
+        if (sscanf(entry->d_name, "%16" SCNx64 "%7s", &h, suffix) != 2 ||
+            strcmp(suffix, ".blob") != 0 || h <= SLOT_TOMBSTONE) {
+            continue;
+        }
+        char        path[NAME_MAX_LEN];
+        struct stat st;
+        blob_path(cache, h, path);
+        if (stat(path, &st) == 0) {
+            insert(cache, h, ( uint64_t )st.st_size, ( uint64_t )st.st_mtime);
+        }
+    }
+    closedir(dir);
+}
+
+struct blob_cache *blob_cache_open(const struct blob_cache_options *opts)
+{
+    if (mkdir(opts->dir, 0755) != 0 && errno != EEXIST) {
+        return NULL;
+    }
+
+    size_t capacity = 16;
+    size_t wanted   = opts->max_entries ? opts->max_entries
+                                        : BLOB_CACHE_ENTRIES_DEFAULT;
+    while (capacity < wanted) {
+        capacity <<= 1;
+    }
+
+    struct blob_cache *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->dir    = malloc(strlen(opts->dir) + 1);
+    cache->slots  = calloc(capacity, sizeof(struct blob_slot));
+    cache->budget = opts->budget_bytes ? opts->budget_bytes : UINT64_MAX;
+    cache->mask   = capacity - 1;
+    if (cache->dir == NULL || cache->slots == NULL) {
+        free(cache->slots);
+        free(cache->dir);
+        free(cache);
+        return NULL;
+    }
+    strcpy(cache->dir, opts->dir);
+    pthread_mutex_init(&cache->write_lock, NULL);
+
+    /* Existing blobs start in write-time order; every later access ticks
+     * past them. */
+    atomic_store(&cache->clock, ( uint64_t )time(NULL));
+    pthread_mutex_lock(&cache->write_lock);
+    scan(cache);
+    while (atomic_load(&cache->bytes) > cache->budget &&
+           evict_one(cache, SLOT_EMPTY)) {
+    }
+    pthread_mutex_unlock(&cache->write_lock);
+    return cache;
+}
+
+void blob_cache_close(struct blob_cache *cache)
+{
+    pthread_mutex_destroy(&cache->write_lock);
+    free(cache->slots);
+    free(cache->dir);
+    free(cache);
+}
+
+size_t blob_cache_load(struct blob_cache *cache, const void *key,
+                       size_t key_size, void *value, size_t value_size)
+{
+    uint64_t          h    = key_hash(key, key_size);
+    struct blob_slot *slot = find(cache, h);
+    if (slot == NULL) {
+        atomic_fetch_add(&cache->misses, 1);
+        return 0;
+    }
+
+    /* An evicted file stays readable through an open descriptor, so no
+     * lock is needed against concurrent stores. */
+    char path[NAME_MAX_LEN];
+    blob_path(cache, h, path);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        atomic_fetch_add(&cache->misses, 1);
+        return 0;
+    }
+    struct stat st;
+    void       *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 &&
+        ( size_t )st.st_size >= sizeof(struct blob_header)) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        atomic_fetch_add(&cache->misses, 1);
+        return 0;
+    }
+
+    const struct blob_header *header  = addr;
+    const uint8_t            *data    = ( const uint8_t * )(header + 1);
+    uint64_t                  payload = ( uint64_t )st.st_size - sizeof(*header);
+    size_t                    found   = 0;
+    if (header->magic == BLOB_MAGIC && header->key_size == key_size &&
+        key_size <= payload && header->value_size <= payload - key_size &&
+        memcmp(data, key, key_size) == 0) {
+        found = header->value_size;
+    }
+
+    if (found == 0) {
+        atomic_fetch_add(&cache->misses, 1);
+    } else if (value != NULL && value_size >= found) {
+        memcpy(value, data + key_size, found);
+        atomic_store(&slot->tick, atomic_fetch_add(&cache->clock, 1) + 1);
+        atomic_fetch_add(&cache->hits, 1);
+    }
+    munmap(addr, st.st_size);
+    return found;
+}
+
+static bool write_all(int fd, const void *data, size_t length)
+{
+    const uint8_t *p = data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= ( size_t )n;
+    }
+    return true;
+}
+
+void blob_cache_store(struct blob_cache *cache, const void *key,
+                      size_t key_size, const void *value, size_t value_size)
+{
+    uint64_t h    = key_hash(key, key_size);
+    uint64_t size = sizeof(struct blob_header) + key_size + value_size;
+    if (value_size == 0 || size > cache->budget) {
+        return;
+    }
+
+    char path[NAME_MAX_LEN];
+    char tmp[NAME_MAX_LEN];
+    blob_path(cache, h, path);
+    snprintf(tmp, sizeof(tmp), "%s/.%ld.%" PRIu64 ".tmp", cache->dir,
+             ( long )getpid(), atomic_fetch_add(&cache->temp_serial, 1));
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    struct blob_header header = {.magic      = BLOB_MAGIC,
+                                 .key_size   = key_size,
+                                 .value_size = value_size};
+    bool ok = write_all(fd, &header, sizeof(header)) &&
+              write_all(fd, key, key_size) && write_all(fd, value, value_size);
+    ok      = close(fd) == 0 && ok;
+
+    /* The rename happens under the lock, so an eviction of the same key
+     * cannot unlink the new file between the rename and the insert. */
+    pthread_mutex_lock(&cache->write_lock);
+    if (!ok || rename(tmp, path) != 0) {
+        pthread_mutex_unlock(&cache->write_lock);
+        unlink(tmp);
+        return;
+    }
+    insert(cache, h, size, atomic_fetch_add(&cache->clock, 1) + 1);
+    while (atomic_load(&cache->bytes) > cache->budget && evict_one(cache, h)) {
+    }
+    pthread_mutex_unlock(&cache->write_lock);
+    atomic_fetch_add(&cache->stores, 1);
+}
+
+static size_t load_data(const void *key, size_t key_size, void *value,
+                        size_t value_size, void *userdata)
+{
+    return blob_cache_load(userdata, key, key_size, value, value_size);
+}
+
+static void store_data(const void *key, size_t key_size, const void *value,
+                       size_t value_size, void *userdata)
+{
+    blob_cache_store(userdata, key, key_size, value, value_size);
+}
+
+void blob_cache_descriptor(struct blob_cache             *cache,
+                           WGPUDawnCacheDeviceDescriptor *desc,
+                           WGPUStringView                 isolation_key)
+{
+    /* WGPU_DAWN_CACHE_DEVICE_DESCRIPTOR_INIT uses nullptr, so it is spelled
+     * out here for C. */
+    memset(desc, 0, sizeof(*desc));
+    desc->chain.sType       = WGPUSType_DawnCacheDeviceDescriptor;
+    desc->isolationKey      = isolation_key;
+    desc->loadDataFunction  = load_data;
+    desc->storeDataFunction = store_data;
+    desc->functionUserdata  = cache;
+}
+
+void blob_cache_stats(struct blob_cache *cache, struct blob_cache_stats *out)
+{
+    out->hits      = atomic_load(&cache->hits);
+    out->misses    = atomic_load(&cache->misses);
+    out->stores    = atomic_load(&cache->stores);
+    out->evictions = atomic_load(&cache->evictions);
+    out->entries   = atomic_load(&cache->entries);
+    out->bytes     = atomic_load(&cache->bytes);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,69 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_BLOB_CACHE_H
+#define WGPU_BLOB_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define BLOB_CACHE_ENTRIES_DEFAULT 4096
+
+struct blob_cache_options {
+    const char *dir;
+    uint64_t    budget_bytes;
+    size_t      max_entries; /* rounded up to a power of two */
+};
+
+struct blob_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t entries;
+    uint64_t bytes;
+};
+
+struct blob_cache;
+
+/* Opens, creating if needed, a directory of content-addressed blobs and
+ * indexes what is already there. Returns NULL on failure. */
+struct blob_cache *blob_cache_open(const struct blob_cache_options *opts);
+void               blob_cache_close(struct blob_cache *cache);
+
+/* Same contract as WGPUDawnLoadCacheDataFunction: returns the stored size,
+ * copying the value only when it fits in value_size. Lock free. */
+size_t blob_cache_load(struct blob_cache *cache, const void *key,
+                       size_t key_size, void *value, size_t value_size);
+
+/* Writes through a temporary file and rename, then evicts least recently
+ * used blobs until the cache is back under budget. */
+void blob_cache_store(struct blob_cache *cache, const void *key,
+                      size_t key_size, const void *value, size_t value_size);
+
+/* Fills desc so it can be chained into a WGPUDeviceDescriptor. */
+void blob_cache_descriptor(struct blob_cache             *cache,
+                           WGPUDawnCacheDeviceDescriptor *desc,
+                           WGPUStringView                 isolation_key);
+
+void blob_cache_stats(struct blob_cache *cache, struct blob_cache_stats *out);
+
+#endif /* ifndef WGPU_BLOB_CACHE_H */
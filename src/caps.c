@@ -0,0 +1,274 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "caps.h"
+
+static size_t view_length(WGPUStringView view)
+{
+    if (view.data == NULL) {
+        return 0;
+    }
+    return view.length == WGPU_STRLEN ? strlen(view.data) : view.length;
+}
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static WGPUStringView copy_view(char **cursor, WGPUStringView view)
+{
+    size_t length = view_length(view);
+    char  *dst    = *cursor;
+    if (length > 0) {
+        memcpy(dst, view.data, length);
+    }
+    dst[length] = '\0';
+    *cursor += length + 1;
+    return (WGPUStringView){.data = dst, .length = length};
+}
+
+/* The structs filled by the driver queries, freed together once copied. */
+struct caps_source {
+    WGPUAdapterInfo                            info;
+    WGPUDawnAdapterPropertiesPowerPreference   power;
+    WGPUAdapterPropertiesMemoryHeaps           heaps;
+    WGPUAdapterPropertiesSubgroupMatrixConfigs configs;
+    WGPUSupportedFeatures                      features;
+};
+
+static bool copy_caps(struct adapter_caps *caps, WGPUAdapter adapter,
+                      const struct caps_source *src)
+{
+    WGPULimits limits = WGPU_LIMITS_INIT;
+    if (wgpuAdapterGetLimits(adapter, &limits) != WGPUStatus_Success) {
+        return false;
+    }
+    caps->limits             = limits;
+    caps->limits.nextInChain = NULL;
+
+    caps->vendor_id         = src->info.vendorID;
+    caps->device_id         = src->info.deviceID;
+    caps->backend_type      = src->info.backendType;
+    caps->adapter_type      = src->info.adapterType;
+    caps->subgroup_min_size = src->info.subgroupMinSize;
+    caps->subgroup_max_size = src->info.subgroupMaxSize;
+    caps->power_preference  = src->power.powerPreference;
+
+    /* One block holds every array and string, widest alignment first. */
+    size_t heaps_size    = src->heaps.heapCount * sizeof(WGPUMemoryHeapInfo);
+    size_t configs_size  = src->configs.configCount *
+                          sizeof(WGPUSubgroupMatrixConfig);
+    size_t features_size = src->features.featureCount * sizeof(WGPUFeatureName);
+    size_t strings_size  = view_length(src->info.vendor) +
+                          view_length(src->info.architecture) +
+                          view_length(src->info.device) +
+                          view_length(src->info.description) + 4;
+
+    size_t configs_offset  = align_up(heaps_size, sizeof(uint64_t));
+    size_t features_offset = align_up(configs_offset + configs_size,
+                                      sizeof(uint64_t));
+    size_t strings_offset  = features_offset + features_size;
+
+    char *storage = malloc(strings_offset + strings_size);
+    if (storage == NULL) {
+        return false;
+    }
+    caps->storage = storage;
+
+    if (heaps_size > 0) {
+        memcpy(storage, src->heaps.heapInfo, heaps_size);
+    }
+    caps->heap_count = src->heaps.heapCount;
+    caps->heaps      = ( const WGPUMemoryHeapInfo * )storage;
+
+    if (configs_size > 0) {
+        memcpy(storage + configs_offset, src->configs.configs, configs_size);
+    }
+    caps->config_count = src->configs.configCount;
+    caps->configs =
+            ( const WGPUSubgroupMatrixConfig * )(storage + configs_offset);
+
+    if (features_size > 0) {
+        memcpy(storage + features_offset, src->features.features, features_size);
+    }
+    caps->feature_count = src->features.featureCount;
+    caps->features = ( const WGPUFeatureName * )(storage + features_offset);
+
+    char *cursor       = storage + strings_offset;
+    caps->vendor       = copy_view(&cursor, src->info.vendor);
+    caps->architecture = copy_view(&cursor, src->info.architecture);
+    caps->device       = copy_view(&cursor, src->info.device);
+    caps->description  = copy_view(&cursor, src->info.description);
+
+    return true;
+}
+
+bool caps_query(WGPUAdapter adapter, struct adapter_caps *caps)
+{
+    memset(caps, 0, sizeof(*caps));
+
+    struct caps_source src = {
+            .info     = WGPU_ADAPTER_INFO_INIT,
+            .power    = WGPU_DAWN_ADAPTER_PROPERTIES_POWER_PREFERENCE_INIT,
+            .heaps    = WGPU_ADAPTER_PROPERTIES_MEMORY_HEAPS_INIT,
+            .configs  = WGPU_ADAPTER_PROPERTIES_SUBGROUP_MATRIX_CONFIGS_INIT,
+            .features = WGPU_SUPPORTED_FEATURES_INIT,
+    };
+    wgpuAdapterGetFeatures(adapter, &src.features);
+
+    /* Chaining either property struct without its feature is a validation
+     * error, so only ask for what the adapter advertises. */
+    bool want_heaps = wgpuAdapterHasFeature(
+            adapter, WGPUFeatureName_AdapterPropertiesMemoryHeaps);
+    bool want_configs = wgpuAdapterHasFeature(
+            adapter, WGPUFeatureName_ChromiumExperimentalSubgroupMatrix);
+
+    WGPUChainedStruct *chain = NULL;
+    if (want_heaps) {
+        src.heaps.chain.next = chain;
+        chain                = &src.heaps.chain;
+    }
+    if (want_configs) {
+        src.configs.chain.next = chain;
+        chain                  = &src.configs.chain;
+    }
+    src.power.chain.next = chain;
+    src.info.nextInChain = &src.power.chain;
+
+    if (wgpuAdapterGetInfo(adapter, &src.info) != WGPUStatus_Success) {
+        wgpuSupportedFeaturesFreeMembers(src.features);
+        return false;
+    }
+
+    bool ok = copy_caps(caps, adapter, &src);
+    if (want_heaps) {
+        wgpuAdapterPropertiesMemoryHeapsFreeMembers(src.heaps);
+    }
+    if (want_configs) {
+        wgpuAdapterPropertiesSubgroupMatrixConfigsFreeMembers(src.configs);
+    }
+    wgpuAdapterInfoFreeMembers(src.info);
+    wgpuSupportedFeaturesFreeMembers(src.features);
+    return ok;
+}
+
+bool caps_has_feature(const struct adapter_caps *caps, WGPUFeatureName feature)
+{
+    for (size_t i = 0; i < caps->feature_count; ++i) {
+        if (caps->features[i] == feature) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t caps_hash(uint64_t h, const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+uint64_t caps_fingerprint(const struct adapter_caps *caps)
+{
+    uint32_t ids[4] = {caps->vendor_id, caps->device_id,
+                       ( uint32_t )caps->backend_type,
+                       ( uint32_t )caps->adapter_type};
+
+    uint64_t h = caps_hash(CAPS_HASH_INIT, ids, sizeof(ids));
+    h = caps_hash(h, caps->architecture.data, caps->architecture.length);
+    h = caps_hash(h, caps->device.data, caps->device.length);
+    /* Dawn reports the driver version in the description. */
+    h = caps_hash(h, caps->description.data, caps->description.length);
+    return h;
+}
+
+#define NAME_AT(table, index)                                                  \
+    (( size_t )(index) < sizeof(table) / sizeof(table[0]) &&                   \
+                     table[index] != NULL                                      \
+             ? table[index]                                                    \
+             : "")
+
+const char *caps_backend_name(WGPUBackendType type)
+{
+    static const char *const names[] = {
+            [WGPUBackendType_Undefined] = "Undefined",
+            [WGPUBackendType_Null]      = "Null",
+            [WGPUBackendType_WebGPU]    = "WebGPU",
+            [WGPUBackendType_D3D11]     = "D3D11",
+            [WGPUBackendType_D3D12]     = "D3D12",
+            [WGPUBackendType_Metal]     = "Metal",
+            [WGPUBackendType_Vulkan]    = "Vulkan",
+            [WGPUBackendType_OpenGL]    = "OpenGL",
+            [WGPUBackendType_OpenGLES]  = "OpenGLES",
+    };
+    return NAME_AT(names, type);
+}
+
+const char *caps_adapter_type_name(WGPUAdapterType type)
+{
+    static const char *const names[] = {
+            [WGPUAdapterType_DiscreteGPU]   = "DiscreteGPU",
+            [WGPUAdapterType_IntegratedGPU] = "IntegratedGPU",
+            [WGPUAdapterType_CPU]           = "CPU",
+            [WGPUAdapterType_Unknown]       = "Unknown",
+    };
+    return NAME_AT(names, type);
+}
+
+const char *caps_power_preference_name(WGPUPowerPreference preference)
+{
+    static const char *const names[] = {
+            [WGPUPowerPreference_Undefined]       = "Undefined",
+            [WGPUPowerPreference_LowPower]        = "LowPower",
+            [WGPUPowerPreference_HighPerformance] = "HighPerformance",
+    };
+    return NAME_AT(names, preference);
+}
+
+const char *caps_component_type_name(WGPUSubgroupMatrixComponentType type)
+{
+    static const char *const names[] = {
+            [WGPUSubgroupMatrixComponentType_F32] = "F32",
+            [WGPUSubgroupMatrixComponentType_F16] = "F16",
+            [WGPUSubgroupMatrixComponentType_U32] = "U32",
+            [WGPUSubgroupMatrixComponentType_I32] = "I32",
+    };
+    return NAME_AT(names, type);
+}
+
+const char *const caps_heap_property_names[CAPS_HEAP_PROPERTY_COUNT] = {
+        "DeviceLocal", "HostVisible", "HostCoherent", "HostUncached",
+        "HostCached",
+};
+
+void caps_free(struct adapter_caps *caps)
+{
+    free(caps->storage);
+    memset(caps, 0, sizeof(*caps));
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
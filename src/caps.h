@@ -0,0 +1,132 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_CAPS_H
+#define WGPU_CAPS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Every WGPULimits member, for code that walks the limits generically. */
+#define CAPS_LIMITS(X)                                                         \
+    X(maxTextureDimension1D)                                                   \
+    X(maxTextureDimension2D)                                                   \
+    X(maxTextureDimension3D)                                                   \
+    X(maxTextureArrayLayers)                                                   \
+    X(maxBindGroups)                                                           \
+    X(maxBindGroupsPlusVertexBuffers)                                          \
+    X(maxBindingsPerBindGroup)                                                 \
+    X(maxDynamicUniformBuffersPerPipelineLayout)                               \
+    X(maxDynamicStorageBuffersPerPipelineLayout)                               \
+    X(maxSampledTexturesPerShaderStage)                                        \
+    X(maxSamplersPerShaderStage)                                               \
+    X(maxStorageBuffersPerShaderStage)                                         \
+    X(maxStorageTexturesPerShaderStage)                                        \
+    X(maxUniformBuffersPerShaderStage)                                         \
+    X(maxUniformBufferBindingSize)                                             \
+    X(maxStorageBufferBindingSize)                                             \
+    X(minUniformBufferOffsetAlignment)                                         \
+    X(minStorageBufferOffsetAlignment)                                         \
+    X(maxVertexBuffers)                                                        \
+    X(maxBufferSize)                                                           \
+    X(maxVertexAttributes)                                                     \
+    X(maxVertexBufferArrayStride)                                              \
+    X(maxInterStageShaderVariables)                                            \
+    X(maxColorAttachments)                                                     \
+    X(maxColorAttachmentBytesPerSample)                                        \
+    X(maxComputeWorkgroupStorageSize)                                          \
+    X(maxComputeInvocationsPerWorkgroup)                                       \
+    X(maxComputeWorkgroupSizeX)                                                \
+    X(maxComputeWorkgroupSizeY)                                                \
+    X(maxComputeWorkgroupSizeZ)                                                \
+    X(maxComputeWorkgroupsPerDimension)                                        \
+    X(maxStorageBuffersInVertexStage)                                          \
+    X(maxStorageTexturesInVertexStage)                                         \
+    X(maxStorageBuffersInFragmentStage)                                        \
+    X(maxStorageTexturesInFragmentStage)
+
+/* Everything adapter_info knows about an adapter, flattened so it can be
+ * held either in one heap block (caps_query) or inside a mapped snapshot.
+ * Strings are NUL terminated and their views exclude the terminator. */
+struct adapter_caps {
+    uint32_t            vendor_id;
+    uint32_t            device_id;
+    WGPUBackendType     backend_type;
+    WGPUAdapterType     adapter_type;
+    uint32_t            subgroup_min_size;
+    uint32_t            subgroup_max_size;
+    WGPUPowerPreference power_preference;
+
+    WGPUStringView vendor;
+    WGPUStringView architecture;
+    WGPUStringView device;
+    WGPUStringView description;
+
+    size_t                 feature_count;
+    const WGPUFeatureName *features;
+
+    WGPULimits limits;
+
+    size_t                    heap_count;
+    const WGPUMemoryHeapInfo *heaps;
+
+    size_t                          config_count;
+    const WGPUSubgroupMatrixConfig *configs;
+
+    void *storage;
+};
+
+/* Queries info, features, limits and, when the adapter exposes the matching
+ * features, memory heaps and subgroup matrix configs. */
+bool caps_query(WGPUAdapter adapter, struct adapter_caps *caps);
+
+bool caps_has_feature(const struct adapter_caps *caps, WGPUFeatureName feature);
+
+/* Identity of the adapter and the driver behind it, stable across runs. */
+uint64_t caps_fingerprint(const struct adapter_caps *caps);
+
+void caps_free(struct adapter_caps *caps);
+
+/* Display names for the enums held above; "" when out of range. */
+const char *caps_backend_name(WGPUBackendType type);
+const char *caps_adapter_type_name(WGPUAdapterType type);
+const char *caps_power_preference_name(WGPUPowerPreference preference);
+const char *caps_component_type_name(WGPUSubgroupMatrixComponentType type);
+
+/* Names of the WGPUHeapProperty bits, lowest bit first. */
+#define CAPS_HEAP_PROPERTY_COUNT 5
+extern const char *const caps_heap_property_names[CAPS_HEAP_PROPERTY_COUNT];
+
+/* FNV-1a, behind caps_fingerprint() and the snapshot fingerprint. */
+uint64_t caps_hash(uint64_t h, const void *data, size_t length);
+
+#define CAPS_HASH_INIT 0xCBF29CE484222325ull
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_CAPS_H */
@@ -0,0 +1,519 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "device_pool.h"
+#include "heap_tuner.h"
+
+#define NO_SLOT                  UINT32_MAX
+#define MONITOR_INTERVAL_DEFAULT (50ull * 1000 * 1000)
+#define MAX_ERROR_SCOPES         64
+
+enum slot_state {
+    SLOT_IDLE,      /* on the free stack */
+    SLOT_OUT,       /* held by a caller */
+    SLOT_REPLACING, /* device being recreated, fields owned by one thread */
+    SLOT_DEAD,      /* replacement failed, retried by the monitor */
+    SLOT_RETIRED,   /* destroyed by its user, never handed out again */
+};
+
+/* device, queue and lost_future only change under the pool lock. The lost
+ * callback tells the devices of a slot apart by generation, so the late
+ * callback of a device the pool released itself is ignored. */
+struct slot {
+    WGPUDevice      device;
+    WGPUQueue       queue;
+    WGPUFuture      lost_future;
+    atomic_bool     lost;
+    atomic_bool     destroyed;
+    atomic_uint     generation;
+    enum slot_state state;
+    uint32_t        next;
+};
+
+struct device_pool {
+    struct acquire           acq;
+    WGPUDeviceDescriptor     desc;
+    WGPUFeatureName         *features;
+    WGPULimits               limits;
+    struct heap_tuner_device tuned;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  returned;
+    pthread_cond_t  wake;
+    uint32_t        free_head;
+    size_t          available;
+    uint64_t        checkouts;
+    uint64_t        replaced;
+    size_t          retired;
+
+    pthread_t           monitor;
+    bool                stopping;
+    uint64_t            interval_ns;
+    WGPUFutureWaitInfo *waits;
+    uint32_t           *wait_slots;
+    uint32_t           *replace; /* slots in SLOT_REPLACING, for the monitor */
+    size_t              replace_count;
+
+    size_t      size;
+    struct slot slots[];
+};
+
+static struct timespec deadline_after(uint64_t ns)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ns += ( uint64_t )ts.tv_nsec;
+    ts.tv_sec += ( time_t )(ns / 1000000000ull);
+    ts.tv_nsec = ( long )(ns % 1000000000ull);
+    return ts;
+}
+
+static void lost_callback(const WGPUDevice *device, WGPUDeviceLostReason reason,
+                          WGPUStringView message, void *userdata1,
+                          void *userdata2)
+{
+    struct slot *slot = userdata1;
+    (void)device;
+    (void)message;
+
+    /* A device the pool released itself, or instance teardown. */
+    if (( uintptr_t )userdata2 != atomic_load(&slot->generation) ||
+        reason == WGPUDeviceLostReason_CallbackCancelled) {
+        return;
+    }
+    if (reason == WGPUDeviceLostReason_Destroyed) {
+        atomic_store(&slot->destroyed, true);
+    }
+    atomic_store(&slot->lost, true);
+}
+
+static bool create_device(struct device_pool *pool, struct slot *slot)
+{
+    unsigned generation = atomic_fetch_add(&slot->generation, 1) + 1;
+    atomic_store(&slot->lost, false);
+    atomic_store(&slot->destroyed, false);
+
+    WGPUDeviceDescriptor desc             = pool->desc;
+    desc.deviceLostCallbackInfo.mode      = WGPUCallbackMode_WaitAnyOnly;
+    desc.deviceLostCallbackInfo.callback  = lost_callback;
+    desc.deviceLostCallbackInfo.userdata1 = slot;
+    desc.deviceLostCallbackInfo.userdata2 = ( void * )( uintptr_t )generation;
+
+    WGPUDevice device = wgpuAdapterCreateDevice(pool->acq.adapter, &desc);
+    WGPUQueue  queue  = NULL;
+    WGPUFuture future = {0};
+    if (device != NULL) {
+        queue  = wgpuDeviceGetQueue(device);
+        future = wgpuDeviceGetLostFuture(device);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    slot->device      = device;
+    slot->queue       = queue;
+    slot->lost_future = future;
+    pthread_mutex_unlock(&pool->lock);
+    return device != NULL;
+}
+
+static void release_device(struct device_pool *pool, struct slot *slot)
+{
+    pthread_mutex_lock(&pool->lock);
+    WGPUDevice device = slot->device;
+    WGPUQueue  queue  = slot->queue;
+    slot->device      = NULL;
+    slot->queue       = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Releasing the last reference destroys the device; that loss is ours,
+     * not the user's. */
+    atomic_fetch_add(&slot->generation, 1);
+    if (queue != NULL) {
+        wgpuQueueRelease(queue);
+    }
+    if (device != NULL) {
+        wgpuDeviceRelease(device);
+    }
+}
+
+/* Caller holds the lock. */
+static void push_idle(struct device_pool *pool, uint32_t index)
+{
+    pool->slots[index].state = SLOT_IDLE;
+    pool->slots[index].next  = pool->free_head;
+    pool->free_head          = index;
+    ++pool->available;
+    pthread_cond_signal(&pool->returned);
+}
+
+/* Caller holds the lock. Only used for slots lost while idle, which is rare
+ * enough that the linear unlink does not matter. */
+static void unlink_idle(struct device_pool *pool, uint32_t index)
+{
+    uint32_t *link = &pool->free_head;
+    while (*link != index) {
+        link = &pool->slots[*link].next;
+    }
+    *link = pool->slots[index].next;
+    --pool->available;
+}
+
+/* Caller holds the lock and has taken the slot off the free stack. The
+ * destroyed device is kept until the pool goes. */
+static void retire(struct device_pool *pool, uint32_t index)
+{
+    pool->slots[index].state = SLOT_RETIRED;
+    ++pool->retired;
+    /* Checkouts waiting on a pool that has nothing left give up. */
+    pthread_cond_broadcast(&pool->returned);
+}
+
+static void replace_device(struct device_pool *pool, uint32_t index)
+{
+    struct slot *slot = &pool->slots[index];
+    release_device(pool, slot);
+    bool ok = create_device(pool, slot);
+
+    pthread_mutex_lock(&pool->lock);
+    if (ok) {
+        ++pool->replaced;
+        push_idle(pool, index);
+    } else {
+        slot->state = SLOT_DEAD;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Called and returns with the lock held, dropping it around each
+ * replacement. */
+static void replace_queued(struct device_pool *pool)
+{
+    while (pool->replace_count > 0) {
+        uint32_t index = pool->replace[--pool->replace_count];
+        pthread_mutex_unlock(&pool->lock);
+        replace_device(pool, index);
+        pthread_mutex_lock(&pool->lock);
+    }
+}
+
+static void *monitor_main(void *arg)
+{
+    struct device_pool *pool = arg;
+
+    size_t chunk = pool->acq.caps.timedWaitAnyMaxCount;
+    if (chunk == 0 || chunk > pool->size) {
+        chunk = pool->size;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stopping) {
+        /* Devices found lost at checkin, queued since the last pass. */
+        replace_queued(pool);
+
+        size_t count = 0;
+        for (uint32_t i = 0; i < pool->size; ++i) {
+            struct slot *slot = &pool->slots[i];
+            if ((slot->state == SLOT_IDLE || slot->state == SLOT_OUT) &&
+                !atomic_load(&slot->lost)) {
+                pool->waits[count].future    = slot->lost_future;
+                pool->waits[count].completed = false;
+                pool->wait_slots[count++]    = i;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        bool   waited = count > 0;
+        size_t chunks = (count + chunk - 1) / chunk;
+        for (size_t c = 0; waited && c < chunks; ++c) {
+            size_t first = c * chunk;
+            size_t n     = count - first < chunk ? count - first : chunk;
+            WGPUWaitStatus status =
+                    wgpuInstanceWaitAny(pool->acq.instance, n,
+                                        pool->waits + first,
+                                        pool->interval_ns / chunks);
+            waited = status != WGPUWaitStatus_Error;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        for (size_t k = 0; k < count; ++k) {
+            struct slot *slot = &pool->slots[pool->wait_slots[k]];
+            if (!pool->waits[k].completed ||
+                slot->lost_future.id != pool->waits[k].future.id) {
+                continue;
+            }
+            /* Lost while out: checkin queues it. */
+            if (slot->state != SLOT_IDLE) {
+                continue;
+            }
+            unlink_idle(pool, pool->wait_slots[k]);
+            if (atomic_load(&slot->destroyed)) {
+                retire(pool, pool->wait_slots[k]);
+            } else {
+                slot->state                          = SLOT_REPLACING;
+                pool->replace[pool->replace_count++] = pool->wait_slots[k];
+            }
+        }
+        for (uint32_t i = 0; i < pool->size; ++i) {
+            if (pool->slots[i].state == SLOT_DEAD) {
+                pool->slots[i].state                 = SLOT_REPLACING;
+                pool->replace[pool->replace_count++] = i;
+            }
+        }
+        replace_queued(pool);
+
+        /* Nothing to wait on or waits unsupported: sleep the interval
+         * instead of spinning. */
+        if (!waited && !pool->stopping) {
+            struct timespec deadline = deadline_after(pool->interval_ns);
+            pthread_cond_timedwait(&pool->wake, &pool->lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void pop_callback(WGPUPopErrorScopeStatus status, WGPUErrorType type,
+                         WGPUStringView message, void *userdata1,
+                         void *userdata2)
+{
+    (void)type;
+    (void)message;
+    (void)userdata2;
+    *( WGPUPopErrorScopeStatus * )userdata1 = status;
+}
+
+static void reset_error_scopes(struct device_pool *pool, WGPUDevice device)
+{
+    for (size_t i = 0; i < MAX_ERROR_SCOPES; ++i) {
+        WGPUPopErrorScopeStatus status = WGPUPopErrorScopeStatus_Error;
+
+        WGPUPopErrorScopeCallbackInfo callbackInfo =
+                WGPU_POP_ERROR_SCOPE_CALLBACK_INFO_INIT;
+        callbackInfo.mode      = WGPUCallbackMode_WaitAnyOnly;
+        callbackInfo.callback  = pop_callback;
+        callbackInfo.userdata1 = &status;
+
+        WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+        wait.future             = wgpuDevicePopErrorScope(device, callbackInfo);
+        if (wgpuInstanceWaitAny(pool->acq.instance, 1, &wait, UINT64_MAX) !=
+                    WGPUWaitStatus_Success ||
+            status != WGPUPopErrorScopeStatus_Success) {
+            /* An empty stack fails the pop, which is where we stop. */
+            return;
+        }
+    }
+}
+
+struct device_pool *device_pool_create(const struct device_pool_options *opts)
+{
+    if (opts->size == 0 || opts->size >= NO_SLOT) {
+        return NULL;
+    }
+    struct device_pool *pool =
+            calloc(1, sizeof(*pool) + opts->size * sizeof(struct slot));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->size        = opts->size;
+    pool->free_head   = NO_SLOT;
+    pool->interval_ns = opts->monitor_interval_ns ? opts->monitor_interval_ns
+                                                  : MONITOR_INTERVAL_DEFAULT;
+    pool->waits      = calloc(opts->size, sizeof(*pool->waits));
+    pool->wait_slots = calloc(opts->size, sizeof(*pool->wait_slots));
+    pool->replace    = calloc(opts->size, sizeof(*pool->replace));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->returned, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    if (pool->waits == NULL || pool->wait_slots == NULL ||
+        pool->replace == NULL || !acquire_init(&pool->acq)) {
+        goto fail;
+    }
+    /* The monitor and the error scope reset both block in WaitAny. */
+    if (!pool->acq.caps.timedWaitAnyEnable) {
+        goto fail;
+    }
+
+    acquire_begin(&pool->acq,
+                  &(struct acquire_options){.adapter = opts->adapter});
+    if (acquire_wait(&pool->acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS) {
+        goto fail;
+    }
+
+    WGPUDeviceDescriptor desc = WGPU_DEVICE_DESCRIPTOR_INIT;
+    if (opts->device != NULL) {
+        desc = *opts->device;
+    }
+    pool->desc = desc;
+    pool->desc.label = (WGPUStringView){.data = "device_pool", .length = 11};
+    if (pool->desc.requiredFeatureCount > 0) {
+        pool->features = malloc(pool->desc.requiredFeatureCount *
+                                sizeof(WGPUFeatureName));
+        if (pool->features == NULL) {
+            goto fail;
+        }
+        memcpy(pool->features, pool->desc.requiredFeatures,
+               pool->desc.requiredFeatureCount * sizeof(WGPUFeatureName));
+        pool->desc.requiredFeatures = pool->features;
+    }
+    if (pool->desc.requiredLimits != NULL) {
+        pool->limits              = *pool->desc.requiredLimits;
+        pool->desc.requiredLimits = &pool->limits;
+    }
+    struct adapter_caps caps;
+    if (opts->heap_tuner_store != NULL &&
+        caps_query(pool->acq.adapter, &caps)) {
+        heap_tuner_apply(opts->heap_tuner_store, &caps, &pool->desc,
+                         &pool->tuned);
+        caps_free(&caps);
+    }
+
+    for (uint32_t i = 0; i < pool->size; ++i) {
+        if (!create_device(pool, &pool->slots[i])) {
+            goto fail;
+        }
+        push_idle(pool, i);
+    }
+
+    if (pthread_create(&pool->monitor, NULL, monitor_main, pool) != 0) {
+        goto fail;
+    }
+    return pool;
+
+fail:
+    for (uint32_t i = 0; i < pool->size; ++i) {
+        release_device(pool, &pool->slots[i]);
+    }
+    acquire_release(&pool->acq);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->returned);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->features);
+    free(pool->replace);
+    free(pool->wait_slots);
+    free(pool->waits);
+    free(pool);
+    return NULL;
+}
+
+bool device_pool_checkout(struct device_pool *pool, struct pooled_device *out,
+                          uint64_t timeout_ns)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (pool->free_head == NO_SLOT && timeout_ns > 0) {
+        struct timespec deadline = deadline_after(
+                timeout_ns == DEVICE_POOL_WAIT_FOREVER ? 0 : timeout_ns);
+        while (pool->free_head == NO_SLOT && pool->retired < pool->size) {
+            if (timeout_ns == DEVICE_POOL_WAIT_FOREVER) {
+                pthread_cond_wait(&pool->returned, &pool->lock);
+            } else if (pthread_cond_timedwait(&pool->returned, &pool->lock,
+                                              &deadline) != 0) {
+                break;
+            }
+        }
+    }
+
+    uint32_t index = pool->free_head;
+    if (index == NO_SLOT) {
+        pthread_mutex_unlock(&pool->lock);
+        return false;
+    }
+    struct slot *slot = &pool->slots[index];
+    pool->free_head   = slot->next;
+    slot->state       = SLOT_OUT;
+    --pool->available;
+    ++pool->checkouts;
+    out->device = slot->device;
+    out->queue  = slot->queue;
+    out->slot   = index;
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+void device_pool_checkin(struct device_pool *pool, struct pooled_device *dev)
+{
+    struct slot *slot = &pool->slots[dev->slot];
+    if (!atomic_load(&slot->lost)) {
+        reset_error_scopes(pool, slot->device);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (!atomic_load(&slot->lost)) {
+        push_idle(pool, dev->slot);
+        pthread_mutex_unlock(&pool->lock);
+    } else if (atomic_load(&slot->destroyed)) {
+        retire(pool, dev->slot);
+        pthread_mutex_unlock(&pool->lock);
+    } else {
+        /* Recreating the device blocks on the adapter; leave that to the
+         * monitor rather than the caller. */
+        slot->state                          = SLOT_REPLACING;
+        pool->replace[pool->replace_count++] = dev->slot;
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    memset(dev, 0, sizeof(*dev));
+}
+
+void device_pool_stats(struct device_pool *pool, struct device_pool_stats *out)
+{
+    pthread_mutex_lock(&pool->lock);
+    out->size      = pool->size;
+    out->available = pool->available;
+    out->checkouts = pool->checkouts;
+    out->replaced  = pool->replaced;
+    out->retired   = pool->retired;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void device_pool_destroy(struct device_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_join(pool->monitor, NULL);
+
+    for (uint32_t i = 0; i < pool->size; ++i) {
+        release_device(pool, &pool->slots[i]);
+    }
+    /* Pending lost callbacks still point at the slots; dropping the
+     * instance flushes them before the slots are freed. */
+    acquire_release(&pool->acq);
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->returned);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->features);
+    free(pool->replace);
+    free(pool->wait_slots);
+    free(pool->waits);
+    free(pool);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,81 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_DEVICE_POOL_H
+#define WGPU_DEVICE_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define DEVICE_POOL_WAIT_FOREVER UINT64_MAX
+
+struct device_pool_options {
+    size_t                           size;
+    const WGPURequestAdapterOptions *adapter;
+    /* Required features and limits are copied; any nextInChain must outlive
+     * the pool. The device lost callback is owned by the pool. */
+    const WGPUDeviceDescriptor *device;
+    /* How often the monitor thread re-arms its wait on the lost futures. */
+    uint64_t monitor_interval_ns;
+    /* When set, the heap_tune store whose block size for the adapter every
+     * device is created with, through heap_tuner_apply. */
+    const char *heap_tuner_store;
+};
+
+struct pooled_device {
+    WGPUDevice device;
+    WGPUQueue  queue;
+    uint32_t   slot;
+};
+
+struct device_pool_stats {
+    size_t   size;
+    size_t   available;
+    uint64_t checkouts;
+    uint64_t replaced;
+    size_t   retired; /* slots whose device the caller destroyed */
+};
+
+struct device_pool;
+
+/* Creates size devices up front on one adapter. Returns NULL on failure. */
+struct device_pool *device_pool_create(const struct device_pool_options *opts);
+
+/* Pops an idle device in O(1), waiting up to timeout_ns for one to come
+ * back; a zero timeout only tries. Fails at once when every slot has been
+ * retired. */
+bool device_pool_checkout(struct device_pool *pool, struct pooled_device *out,
+                          uint64_t timeout_ns);
+
+/* Pops every error scope the caller left pushed, then returns the device to
+ * the pool in O(1). A device lost while out is handed to the monitor thread
+ * to replace, so checkin never waits on device creation. A device the
+ * caller destroyed with wgpuDeviceDestroy is not replaced: its slot is
+ * retired and the pool shrinks by one. */
+void device_pool_checkin(struct device_pool *pool, struct pooled_device *dev);
+
+void device_pool_stats(struct device_pool *pool, struct device_pool_stats *out);
+
+/* Every device must have been checked back in. */
+void device_pool_destroy(struct device_pool *pool);
+
+#endif /* ifndef WGPU_DEVICE_POOL_H */
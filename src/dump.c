@@ -0,0 +1,208 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <string.h>
+
+#include "dump.h"
+#include "feature_names.h"
+
+static void text_field(struct writer *w, const char *label, const char *value)
+{
+    writer_str(w, label);
+    writer_str(w, value);
+    writer_bytes(w, "\n", 1);
+}
+
+static void text_hex(struct writer *w, const char *label, uint64_t value)
+{
+    writer_str(w, label);
+    writer_hex(w, value);
+    writer_bytes(w, "\n", 1);
+}
+
+static void heap_properties(struct writer *w, WGPUHeapProperty properties,
+                            const char *separator, bool quoted)
+{
+    const char *sep = "";
+    for (size_t bit = 0; bit < CAPS_HEAP_PROPERTY_COUNT; ++bit) {
+        if ((properties & (1ull << bit)) == 0) {
+            continue;
+        }
+        writer_str(w, sep);
+        if (quoted) {
+            writer_json_string(w, caps_heap_property_names[bit],
+                               strlen(caps_heap_property_names[bit]));
+        } else {
+            writer_str(w, caps_heap_property_names[bit]);
+        }
+        sep = separator;
+    }
+}
+
+void dump_text(struct writer *w, const struct adapter_caps *caps)
+{
+    text_hex(w, "VendorID: \t\t", caps->vendor_id);
+    text_field(w, "Vendor: \t\t", caps->vendor.data);
+    text_field(w, "Architecture: \t\t", caps->architecture.data);
+    text_hex(w, "DeviceID: \t\t", caps->device_id);
+    text_field(w, "Device: \t\t", caps->device.data);
+    text_field(w, "Description: \t\t", caps->description.data);
+    text_field(w, "Backend: \t\t", caps_backend_name(caps->backend_type));
+    text_field(w, "AdapterType: \t\t",
+               caps_adapter_type_name(caps->adapter_type));
+    text_field(w, "PowerPreference: \t",
+               caps_power_preference_name(caps->power_preference));
+
+    for (size_t i = 0; i < caps->feature_count; ++i) {
+        writer_str(w, "Supports feature: \t");
+        writer_str(w, feature_name(caps->features[i]));
+        writer_bytes(w, "(", 1);
+        writer_hex(w, caps->features[i]);
+        writer_bytes(w, ")\n", 2);
+    }
+
+#define X(name)                                                                \
+    writer_str(w, "Limit: \t\t\t" #name " = ");                                \
+    writer_u64(w, caps->limits.name);                                          \
+    writer_bytes(w, "\n", 1);
+    CAPS_LIMITS(X)
+#undef X
+
+    for (size_t i = 0; i < caps->heap_count; ++i) {
+        writer_str(w, "Memory heap: \t\t");
+        writer_u64(w, caps->heaps[i].size);
+        writer_str(w, " bytes (");
+        heap_properties(w, caps->heaps[i].properties, "|", false);
+        writer_bytes(w, ")\n", 2);
+    }
+
+    for (size_t i = 0; i < caps->config_count; ++i) {
+        const WGPUSubgroupMatrixConfig *config = &caps->configs[i];
+        writer_str(w, "Subgroup matrix: \t");
+        writer_str(w, caps_component_type_name(config->componentType));
+        writer_str(w, " -> ");
+        writer_str(w, caps_component_type_name(config->resultComponentType));
+        writer_bytes(w, " ", 1);
+        writer_u64(w, config->M);
+        writer_bytes(w, "x", 1);
+        writer_u64(w, config->N);
+        writer_bytes(w, "x", 1);
+        writer_u64(w, config->K);
+        writer_bytes(w, "\n", 1);
+    }
+}
+
+static void json_key(struct writer *w, const char *key)
+{
+    writer_json_string(w, key, strlen(key));
+    writer_bytes(w, ":", 1);
+}
+
+static void json_string(struct writer *w, const char *key, WGPUStringView value)
+{
+    json_key(w, key);
+    writer_json_string(w, value.data, value.length);
+    writer_bytes(w, ",", 1);
+}
+
+static void json_name(struct writer *w, const char *key, const char *value)
+{
+    json_key(w, key);
+    writer_json_string(w, value, strlen(value));
+    writer_bytes(w, ",", 1);
+}
+
+static void json_u64(struct writer *w, const char *key, uint64_t value)
+{
+    json_key(w, key);
+    writer_u64(w, value);
+    writer_bytes(w, ",", 1);
+}
+
+void dump_json(struct writer *w, const struct adapter_caps *caps)
+{
+    writer_bytes(w, "{", 1);
+    json_u64(w, "vendorID", caps->vendor_id);
+    json_string(w, "vendor", caps->vendor);
+    json_string(w, "architecture", caps->architecture);
+    json_u64(w, "deviceID", caps->device_id);
+    json_string(w, "device", caps->device);
+    json_string(w, "description", caps->description);
+    json_name(w, "backendType", caps_backend_name(caps->backend_type));
+    json_name(w, "adapterType", caps_adapter_type_name(caps->adapter_type));
+    json_name(w, "powerPreference",
+              caps_power_preference_name(caps->power_preference));
+    json_u64(w, "subgroupMinSize", caps->subgroup_min_size);
+    json_u64(w, "subgroupMaxSize", caps->subgroup_max_size);
+
+    json_key(w, "features");
+    writer_bytes(w, "[", 1);
+    for (size_t i = 0; i < caps->feature_count; ++i) {
+        const char *name = feature_name(caps->features[i]);
+        writer_str(w, i ? ",{" : "{");
+        json_name(w, "name", name);
+        json_key(w, "code");
+        writer_u64(w, caps->features[i]);
+        writer_bytes(w, "}", 1);
+    }
+    writer_bytes(w, "],", 2);
+
+    json_key(w, "limits");
+    writer_bytes(w, "{", 1);
+    const char *sep = "";
+#define X(name)                                                                \
+    writer_str(w, sep);                                                        \
+    json_key(w, #name);                                                        \
+    writer_u64(w, caps->limits.name);                                          \
+    sep = ",";
+    CAPS_LIMITS(X)
+#undef X
+    writer_bytes(w, "},", 2);
+
+    json_key(w, "memoryHeaps");
+    writer_bytes(w, "[", 1);
+    for (size_t i = 0; i < caps->heap_count; ++i) {
+        writer_str(w, i ? ",{" : "{");
+        json_u64(w, "size", caps->heaps[i].size);
+        json_key(w, "properties");
+        writer_bytes(w, "[", 1);
+        heap_properties(w, caps->heaps[i].properties, ",", true);
+        writer_bytes(w, "]}", 2);
+    }
+    writer_bytes(w, "],", 2);
+
+    json_key(w, "subgroupMatrixConfigs");
+    writer_bytes(w, "[", 1);
+    for (size_t i = 0; i < caps->config_count; ++i) {
+        const WGPUSubgroupMatrixConfig *config = &caps->configs[i];
+        writer_str(w, i ? ",{" : "{");
+        json_name(w, "componentType",
+                  caps_component_type_name(config->componentType));
+        json_name(w, "resultComponentType",
+                  caps_component_type_name(config->resultComponentType));
+        json_u64(w, "M", config->M);
+        json_u64(w, "N", config->N);
+        json_key(w, "K");
+        writer_u64(w, config->K);
+        writer_bytes(w, "}", 1);
+    }
+    writer_bytes(w, "]}\n", 3);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,32 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_DUMP_H
+#define WGPU_DUMP_H
+
+#include "caps.h"
+#include "writer.h"
+
+/* Human readable listing, as adapter_info has always printed it. */
+void dump_text(struct writer *w, const struct adapter_caps *caps);
+
+/* A single JSON object terminated by a newline. */
+void dump_json(struct writer *w, const struct adapter_caps *caps);
+
+#endif /* ifndef WGPU_DUMP_H */
@@ -0,0 +1,164 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <dawn/native/DawnNative.h>
+
+#include "enumerate.h"
+
+namespace {
+
+constexpr WGPUBackendType kBackends[] = {
+        WGPUBackendType_D3D12,  WGPUBackendType_D3D11,  WGPUBackendType_Metal,
+        WGPUBackendType_Vulkan, WGPUBackendType_OpenGL, WGPUBackendType_OpenGLES,
+};
+
+struct Discovered {
+    WGPUAdapter         adapter;
+    struct adapter_caps caps;
+};
+
+struct Job {
+    WGPUBackendType                          backend;
+    bool                                     fallback;
+    std::unique_ptr<dawn::native::Instance> instance;
+    std::vector<Discovered>                  found;
+};
+
+void Discover(Job *job)
+{
+    WGPUInstanceCapabilities caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    if (wgpuGetInstanceCapabilities(&caps) != WGPUStatus_Success) {
+        caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    }
+    WGPUInstanceDescriptor desc = WGPU_INSTANCE_DESCRIPTOR_INIT;
+    desc.capabilities.timedWaitAnyEnable   = caps.timedWaitAnyEnable;
+    desc.capabilities.timedWaitAnyMaxCount = caps.timedWaitAnyMaxCount;
+    job->instance = std::make_unique<dawn::native::Instance>(&desc);
+
+    WGPURequestAdapterOptions options = WGPU_REQUEST_ADAPTER_OPTIONS_INIT;
+    options.backendType               = job->backend;
+    options.forceFallbackAdapter      = job->fallback;
+    for (const dawn::native::Adapter &adapter :
+         job->instance->EnumerateAdapters(&options)) {
+        Discovered found = {adapter.Get(), {}};
+        if (!caps_query(found.adapter, &found.caps)) {
+            continue;
+        }
+        wgpuAdapterAddRef(found.adapter);
+        job->found.push_back(found);
+    }
+}
+
+/* The fallback job lists CPU adapters the backend jobs already returned; an
+ * adapter is the same one when vendor, device and backend all match. Only
+ * used on the fallback job's results, so identical GPUs that one backend
+ * lists twice both stay listed. */
+enumerated_adapter *FindListed(struct enumeration *e, const adapter_caps &caps)
+{
+    for (size_t i = 0; i < e->count; ++i) {
+        const adapter_caps &listed = e->adapters[i].caps;
+        if (listed.vendor_id == caps.vendor_id &&
+            listed.device_id == caps.device_id &&
+            listed.backend_type == caps.backend_type) {
+            return &e->adapters[i];
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+struct enumeration_impl {
+    std::vector<Job> jobs;
+};
+
+extern "C" bool enumerate_adapters(struct enumeration         *e,
+                                   const struct score_weights *weights)
+{
+    *e = {};
+
+    auto impl = std::make_unique<enumeration_impl>();
+    for (WGPUBackendType backend : kBackends) {
+        impl->jobs.push_back({backend, false, nullptr, {}});
+    }
+    impl->jobs.push_back({WGPUBackendType_Undefined, true, nullptr, {}});
+
+    std::vector<std::thread> threads;
+    for (Job &job : impl->jobs) {
+        threads.emplace_back(Discover, &job);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (Job &job : impl->jobs) {
+        for (Discovered &found : job.found) {
+            enumerated_adapter *listed =
+                    job.fallback ? FindListed(e, found.caps) : nullptr;
+            if (listed != nullptr) {
+                listed->fallback = listed->fallback || job.fallback;
+                wgpuAdapterRelease(found.adapter);
+                caps_free(&found.caps);
+                continue;
+            }
+            if (e->count == ENUMERATE_MAX_ADAPTERS) {
+                wgpuAdapterRelease(found.adapter);
+                caps_free(&found.caps);
+                continue;
+            }
+            struct enumerated_adapter *slot = &e->adapters[e->count++];
+            slot->instance                  = job.instance->Get();
+            slot->adapter                   = found.adapter;
+            slot->fallback                  = job.fallback;
+            slot->caps                      = found.caps;
+        }
+        job.found.clear();
+    }
+
+    /* Scored only once duplicates are gone. */
+    for (size_t i = 0; i < e->count; ++i) {
+        e->adapters[i].score = score_adapter(&e->adapters[i].caps, weights);
+    }
+
+    std::stable_sort(e->adapters, e->adapters + e->count,
+                     [](const enumerated_adapter &a,
+                        const enumerated_adapter &b) {
+                         return a.score > b.score;
+                     });
+
+    e->impl = impl.release();
+    return e->count > 0;
+}
+
+extern "C" void enumerate_release(struct enumeration *e)
+{
+    for (size_t i = 0; i < e->count; ++i) {
+        wgpuAdapterRelease(e->adapters[i].adapter);
+        caps_free(&e->adapters[i].caps);
+    }
+    delete static_cast<enumeration_impl *>(e->impl);
+    *e = {};
+}
+
+// vim: set ft=cpp ts=4 sts=4 sw=4 et cin ai nospell
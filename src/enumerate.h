@@ -0,0 +1,64 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_ENUMERATE_H
+#define WGPU_ENUMERATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <dawn/webgpu.h>
+
+#include "caps.h"
+#include "score.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ENUMERATE_MAX_ADAPTERS 32
+
+struct enumerated_adapter {
+    WGPUInstance        instance; /* borrowed, owned by the enumeration */
+    WGPUAdapter         adapter;
+    bool                fallback;
+    double              score;
+    struct adapter_caps caps;
+};
+
+/* Adapters sorted best first. Each backend is discovered on its own thread
+ * and its own instance, so a slow driver only delays its own adapters. An
+ * adapter the fallback search finds again is listed once, from its backend,
+ * with fallback set. */
+struct enumeration {
+    size_t                    count;
+    struct enumerated_adapter adapters[ENUMERATE_MAX_ADAPTERS];
+    void                     *impl;
+};
+
+bool enumerate_adapters(struct enumeration         *e,
+                        const struct score_weights *weights);
+
+void enumerate_release(struct enumeration *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_ENUMERATE_H */
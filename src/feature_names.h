@@ -17,87 +17,249 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+/* Generated by tools/gen_feature_names.py; do not edit. */
+
 #ifndef WGPU_FEATURES_H
 #define WGPU_FEATURES_H
 
-#define _FEATURE_NAME_FROM_CODE(code)                                          \
-    ((code == 0x00000001)   ? "DepthClipControl"                               \
-     : (code == 0x00000002) ? "Depth32FloatStencil8"                           \
-     : (code == 0x00000003) ? "TimestampQuery"                                 \
-     : (code == 0x00000004) ? "TextureCompressionBC"                           \
-     : (code == 0x00000005) ? "TextureCompressionBCSliced3D"                   \
-     : (code == 0x00000006) ? "TextureCompressionETC2"                         \
-     : (code == 0x00000007) ? "TextureCompressionASTC"                         \
-     : (code == 0x00000008) ? "TextureCompressionASTCSliced3D"                 \
-     : (code == 0x00000009) ? "IndirectFirstInstance"                          \
-     : (code == 0x0000000A) ? "ShaderF16"                                      \
-     : (code == 0x0000000B) ? "RG11B10UfloatRenderable"                        \
-     : (code == 0x0000000C) ? "BGRA8UnormStorage"                              \
-     : (code == 0x0000000D) ? "Float32Filterable"                              \
-     : (code == 0x0000000E) ? "Float32Blendable"                               \
-     : (code == 0x0000000F) ? "ClipDistances"                                  \
-     : (code == 0x00000010) ? "DualSourceBlending"                             \
-     : (code == 0x00000011) ? "Subgroups"                                      \
-     : (code == 0x00000012) ? "CoreFeaturesAndLimits"                          \
-     : (code == 0x00050000) ? "DawnInternalUsages"                             \
-     : (code == 0x00050001) ? "DawnMultiPlanarFormats"                         \
-     : (code == 0x00050002) ? "DawnNative"                                     \
-     : (code == 0x00050003) ? "ChromiumExperimentalTimestampQueryInsidePasses" \
-     : (code == 0x00050004) ? "ImplicitDeviceSynchronization"                  \
-     : (code == 0x00050005) ? "ChromiumExperimentalImmediateData"              \
-     : (code == 0x00050006) ? "TransientAttachments"                           \
-     : (code == 0x00050007) ? "MSAARenderToSingleSampled"                      \
-     : (code == 0x00050008) ? "D3D11MultithreadProtected"                      \
-     : (code == 0x00050009) ? "ANGLETextureSharing"                            \
-     : (code == 0x0005000A) ? "PixelLocalStorageCoherent"                      \
-     : (code == 0x0005000B) ? "PixelLocalStorageNonCoherent"                   \
-     : (code == 0x0005000C) ? "Unorm16TextureFormats"                          \
-     : (code == 0x0005000D) ? "Snorm16TextureFormats"                          \
-     : (code == 0x0005000E) ? "MultiPlanarFormatExtendedUsages"                \
-     : (code == 0x0005000F) ? "MultiPlanarFormatP010"                          \
-     : (code == 0x00050010) ? "HostMappedPointer"                              \
-     : (code == 0x00050011) ? "MultiPlanarRenderTargets"                       \
-     : (code == 0x00050012) ? "MultiPlanarFormatNv12a"                         \
-     : (code == 0x00050013) ? "FramebufferFetch"                               \
-     : (code == 0x00050014) ? "BufferMapExtendedUsages"                        \
-     : (code == 0x00050015) ? "AdapterPropertiesMemoryHeaps"                   \
-     : (code == 0x00050016) ? "AdapterPropertiesD3D"                           \
-     : (code == 0x00050017) ? "AdapterPropertiesVk"                            \
-     : (code == 0x00050018) ? "R8UnormStorage"                                 \
-     : (code == 0x00050019) ? "DawnFormatCapabilities"                         \
-     : (code == 0x0005001A) ? "DawnDrmFormatCapabilities"                      \
-     : (code == 0x0005001B) ? "Norm16TextureFormats"                           \
-     : (code == 0x0005001C) ? "MultiPlanarFormatNv16"                          \
-     : (code == 0x0005001D) ? "MultiPlanarFormatNv24"                          \
-     : (code == 0x0005001E) ? "MultiPlanarFormatP210"                          \
-     : (code == 0x0005001F) ? "MultiPlanarFormatP410"                          \
-     : (code == 0x00050020) ? "SharedTextureMemoryVkDedicatedAllocation"       \
-     : (code == 0x00050021) ? "SharedTextureMemoryAHardwareBuffer"             \
-     : (code == 0x00050022) ? "SharedTextureMemoryDmaBuf"                      \
-     : (code == 0x00050023) ? "SharedTextureMemoryOpaqueFD"                    \
-     : (code == 0x00050024) ? "SharedTextureMemoryZirconHandle"                \
-     : (code == 0x00050025) ? "SharedTextureMemoryDXGISharedHandle"            \
-     : (code == 0x00050026) ? "SharedTextureMemoryD3D11Texture2D"              \
-     : (code == 0x00050027) ? "SharedTextureMemoryIOSurface"                   \
-     : (code == 0x00050028) ? "SharedTextureMemoryEGLImage"                    \
-     : (code == 0x00050029) ? "SharedFenceVkSemaphoreOpaqueFD"                 \
-     : (code == 0x0005002A) ? "SharedFenceSyncFD"                              \
-     : (code == 0x0005002B) ? "SharedFenceVkSemaphoreZirconHandle"             \
-     : (code == 0x0005002C) ? "SharedFenceDXGISharedHandle"                    \
-     : (code == 0x0005002D) ? "SharedFenceMTLSharedEvent"                      \
-     : (code == 0x0005002E) ? "SharedBufferMemoryD3D12Resource"                \
-     : (code == 0x0005002F) ? "StaticSamplers"                                 \
-     : (code == 0x00050030) ? "YCbCrVulkanSamplers"                            \
-     : (code == 0x00050031) ? "ShaderModuleCompilationOptions"                 \
-     : (code == 0x00050032) ? "DawnLoadResolveTexture"                         \
-     : (code == 0x00050033) ? "DawnPartialLoadResolveTexture"                  \
-     : (code == 0x00050034) ? "MultiDrawIndirect"                              \
-     : (code == 0x00050035) ? "DawnTexelCopyBufferRowAlignment"                \
-     : (code == 0x00050036) ? "FlexibleTextureViews"                           \
-     : (code == 0x00050037) ? "ChromiumExperimentalSubgroupMatrix"             \
-     : (code == 0x00050038) ? "SharedFenceEGLSync"                             \
-     : (code == 0x00050039) ? "DawnDeviceAllocatorControl"                     \
-     : (code == 0x7FFFFFFF) ? "Force3"                                         \
-                            : "")
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dawn/webgpu.h>
+
+#define FEATURE_CORE_BASE  0x00000000u
+#define FEATURE_CORE_COUNT 19
+#define FEATURE_DAWN_BASE  0x00050000u
+#define FEATURE_DAWN_COUNT 58
+#define FEATURE_COUNT      76
+#define FEATURE_HASH_SEED  0x00000073u
+#define FEATURE_HASH_BITS  9
+
+/* Forward tables, indexed by code - base; gaps are NULL. */
+static const char *const feature_names_core[FEATURE_CORE_COUNT] = {
+    [0x01] = "DepthClipControl",
+    [0x02] = "Depth32FloatStencil8",
+    [0x03] = "TimestampQuery",
+    [0x04] = "TextureCompressionBC",
+    [0x05] = "TextureCompressionBCSliced3D",
+    [0x06] = "TextureCompressionETC2",
+    [0x07] = "TextureCompressionASTC",
+    [0x08] = "TextureCompressionASTCSliced3D",
+    [0x09] = "IndirectFirstInstance",
+    [0x0A] = "ShaderF16",
+    [0x0B] = "RG11B10UfloatRenderable",
+    [0x0C] = "BGRA8UnormStorage",
+    [0x0D] = "Float32Filterable",
+    [0x0E] = "Float32Blendable",
+    [0x0F] = "ClipDistances",
+    [0x10] = "DualSourceBlending",
+    [0x11] = "Subgroups",
+    [0x12] = "CoreFeaturesAndLimits",
+};
+
+static const char *const feature_names_dawn[FEATURE_DAWN_COUNT] = {
+    [0x00] = "DawnInternalUsages",
+    [0x01] = "DawnMultiPlanarFormats",
+    [0x02] = "DawnNative",
+    [0x03] = "ChromiumExperimentalTimestampQueryInsidePasses",
+    [0x04] = "ImplicitDeviceSynchronization",
+    [0x05] = "ChromiumExperimentalImmediateData",
+    [0x06] = "TransientAttachments",
+    [0x07] = "MSAARenderToSingleSampled",
+    [0x08] = "D3D11MultithreadProtected",
+    [0x09] = "ANGLETextureSharing",
+    [0x0A] = "PixelLocalStorageCoherent",
+    [0x0B] = "PixelLocalStorageNonCoherent",
+    [0x0C] = "Unorm16TextureFormats",
+    [0x0D] = "Snorm16TextureFormats",
+    [0x0E] = "MultiPlanarFormatExtendedUsages",
+    [0x0F] = "MultiPlanarFormatP010",
+    [0x10] = "HostMappedPointer",
+    [0x11] = "MultiPlanarRenderTargets",
+    [0x12] = "MultiPlanarFormatNv12a",
+    [0x13] = "FramebufferFetch",
+    [0x14] = "BufferMapExtendedUsages",
+    [0x15] = "AdapterPropertiesMemoryHeaps",
+    [0x16] = "AdapterPropertiesD3D",
+    [0x17] = "AdapterPropertiesVk",
+    [0x18] = "R8UnormStorage",
+    [0x19] = "DawnFormatCapabilities",
+    [0x1A] = "DawnDrmFormatCapabilities",
+    [0x1B] = "Norm16TextureFormats",
+    [0x1C] = "MultiPlanarFormatNv16",
+    [0x1D] = "MultiPlanarFormatNv24",
+    [0x1E] = "MultiPlanarFormatP210",
+    [0x1F] = "MultiPlanarFormatP410",
+    [0x20] = "SharedTextureMemoryVkDedicatedAllocation",
+    [0x21] = "SharedTextureMemoryAHardwareBuffer",
+    [0x22] = "SharedTextureMemoryDmaBuf",
+    [0x23] = "SharedTextureMemoryOpaqueFD",
+    [0x24] = "SharedTextureMemoryZirconHandle",
+    [0x25] = "SharedTextureMemoryDXGISharedHandle",
+    [0x26] = "SharedTextureMemoryD3D11Texture2D",
+    [0x27] = "SharedTextureMemoryIOSurface",
+    [0x28] = "SharedTextureMemoryEGLImage",
+    [0x29] = "SharedFenceVkSemaphoreOpaqueFD",
+    [0x2A] = "SharedFenceSyncFD",
+    [0x2B] = "SharedFenceVkSemaphoreZirconHandle",
+    [0x2C] = "SharedFenceDXGISharedHandle",
+    [0x2D] = "SharedFenceMTLSharedEvent",
+    [0x2E] = "SharedBufferMemoryD3D12Resource",
+    [0x2F] = "StaticSamplers",
+    [0x30] = "YCbCrVulkanSamplers",
+    [0x31] = "ShaderModuleCompilationOptions",
+    [0x32] = "DawnLoadResolveTexture",
+    [0x33] = "DawnPartialLoadResolveTexture",
+    [0x34] = "MultiDrawIndirect",
+    [0x35] = "DawnTexelCopyBufferRowAlignment",
+    [0x36] = "FlexibleTextureViews",
+    [0x37] = "ChromiumExperimentalSubgroupMatrix",
+    [0x38] = "SharedFenceEGLSync",
+    [0x39] = "DawnDeviceAllocatorControl",
+};
+
+struct feature_entry {
+    const char     *name;
+    uint8_t         length;
+    WGPUFeatureName code;
+};
+
+static const struct feature_entry feature_entries[FEATURE_COUNT] = {
+    {"DepthClipControl", 16, WGPUFeatureName_DepthClipControl},
+    {"Depth32FloatStencil8", 20, WGPUFeatureName_Depth32FloatStencil8},
+    {"TimestampQuery", 14, WGPUFeatureName_TimestampQuery},
+    {"TextureCompressionBC", 20, WGPUFeatureName_TextureCompressionBC},
+    {"TextureCompressionBCSliced3D", 28, WGPUFeatureName_TextureCompressionBCSliced3D},
+    {"TextureCompressionETC2", 22, WGPUFeatureName_TextureCompressionETC2},
+    {"TextureCompressionASTC", 22, WGPUFeatureName_TextureCompressionASTC},
+    {"TextureCompressionASTCSliced3D", 30, WGPUFeatureName_TextureCompressionASTCSliced3D},
+    {"IndirectFirstInstance", 21, WGPUFeatureName_IndirectFirstInstance},
+    {"ShaderF16", 9, WGPUFeatureName_ShaderF16},
+    {"RG11B10UfloatRenderable", 23, WGPUFeatureName_RG11B10UfloatRenderable},
+    {"BGRA8UnormStorage", 17, WGPUFeatureName_BGRA8UnormStorage},
+    {"Float32Filterable", 17, WGPUFeatureName_Float32Filterable},
+    {"Float32Blendable", 16, WGPUFeatureName_Float32Blendable},
+    {"ClipDistances", 13, WGPUFeatureName_ClipDistances},
+    {"DualSourceBlending", 18, WGPUFeatureName_DualSourceBlending},
+    {"Subgroups", 9, WGPUFeatureName_Subgroups},
+    {"CoreFeaturesAndLimits", 21, WGPUFeatureName_CoreFeaturesAndLimits},
+    {"DawnInternalUsages", 18, WGPUFeatureName_DawnInternalUsages},
+    {"DawnMultiPlanarFormats", 22, WGPUFeatureName_DawnMultiPlanarFormats},
+    {"DawnNative", 10, WGPUFeatureName_DawnNative},
+    {"ChromiumExperimentalTimestampQueryInsidePasses", 46, WGPUFeatureName_ChromiumExperimentalTimestampQueryInsidePasses},
+    {"ImplicitDeviceSynchronization", 29, WGPUFeatureName_ImplicitDeviceSynchronization},
+    {"ChromiumExperimentalImmediateData", 33, WGPUFeatureName_ChromiumExperimentalImmediateData},
+    {"TransientAttachments", 20, WGPUFeatureName_TransientAttachments},
+    {"MSAARenderToSingleSampled", 25, WGPUFeatureName_MSAARenderToSingleSampled},
+    {"D3D11MultithreadProtected", 25, WGPUFeatureName_D3D11MultithreadProtected},
+    {"ANGLETextureSharing", 19, WGPUFeatureName_ANGLETextureSharing},
+    {"PixelLocalStorageCoherent", 25, WGPUFeatureName_PixelLocalStorageCoherent},
+    {"PixelLocalStorageNonCoherent", 28, WGPUFeatureName_PixelLocalStorageNonCoherent},
+    {"Unorm16TextureFormats", 21, WGPUFeatureName_Unorm16TextureFormats},
+    {"Snorm16TextureFormats", 21, WGPUFeatureName_Snorm16TextureFormats},
+    {"MultiPlanarFormatExtendedUsages", 31, WGPUFeatureName_MultiPlanarFormatExtendedUsages},
+    {"MultiPlanarFormatP010", 21, WGPUFeatureName_MultiPlanarFormatP010},
+    {"HostMappedPointer", 17, WGPUFeatureName_HostMappedPointer},
+    {"MultiPlanarRenderTargets", 24, WGPUFeatureName_MultiPlanarRenderTargets},
+    {"MultiPlanarFormatNv12a", 22, WGPUFeatureName_MultiPlanarFormatNv12a},
+    {"FramebufferFetch", 16, WGPUFeatureName_FramebufferFetch},
+    {"BufferMapExtendedUsages", 23, WGPUFeatureName_BufferMapExtendedUsages},
+    {"AdapterPropertiesMemoryHeaps", 28, WGPUFeatureName_AdapterPropertiesMemoryHeaps},
+    {"AdapterPropertiesD3D", 20, WGPUFeatureName_AdapterPropertiesD3D},
+    {"AdapterPropertiesVk", 19, WGPUFeatureName_AdapterPropertiesVk},
+    {"R8UnormStorage", 14, WGPUFeatureName_R8UnormStorage},
+    {"DawnFormatCapabilities", 22, WGPUFeatureName_DawnFormatCapabilities},
+    {"DawnDrmFormatCapabilities", 25, WGPUFeatureName_DawnDrmFormatCapabilities},
+    {"Norm16TextureFormats", 20, WGPUFeatureName_Norm16TextureFormats},
+    {"MultiPlanarFormatNv16", 21, WGPUFeatureName_MultiPlanarFormatNv16},
+    {"MultiPlanarFormatNv24", 21, WGPUFeatureName_MultiPlanarFormatNv24},
+    {"MultiPlanarFormatP210", 21, WGPUFeatureName_MultiPlanarFormatP210},
+    {"MultiPlanarFormatP410", 21, WGPUFeatureName_MultiPlanarFormatP410},
+    {"SharedTextureMemoryVkDedicatedAllocation", 40, WGPUFeatureName_SharedTextureMemoryVkDedicatedAllocation},
+    {"SharedTextureMemoryAHardwareBuffer", 34, WGPUFeatureName_SharedTextureMemoryAHardwareBuffer},
+    {"SharedTextureMemoryDmaBuf", 25, WGPUFeatureName_SharedTextureMemoryDmaBuf},
+    {"SharedTextureMemoryOpaqueFD", 27, WGPUFeatureName_SharedTextureMemoryOpaqueFD},
+    {"SharedTextureMemoryZirconHandle", 31, WGPUFeatureName_SharedTextureMemoryZirconHandle},
+    {"SharedTextureMemoryDXGISharedHandle", 35, WGPUFeatureName_SharedTextureMemoryDXGISharedHandle},
+    {"SharedTextureMemoryD3D11Texture2D", 33, WGPUFeatureName_SharedTextureMemoryD3D11Texture2D},
+    {"SharedTextureMemoryIOSurface", 28, WGPUFeatureName_SharedTextureMemoryIOSurface},
+    {"SharedTextureMemoryEGLImage", 27, WGPUFeatureName_SharedTextureMemoryEGLImage},
+    {"SharedFenceVkSemaphoreOpaqueFD", 30, WGPUFeatureName_SharedFenceVkSemaphoreOpaqueFD},
+    {"SharedFenceSyncFD", 17, WGPUFeatureName_SharedFenceSyncFD},
+    {"SharedFenceVkSemaphoreZirconHandle", 34, WGPUFeatureName_SharedFenceVkSemaphoreZirconHandle},
+    {"SharedFenceDXGISharedHandle", 27, WGPUFeatureName_SharedFenceDXGISharedHandle},
+    {"SharedFenceMTLSharedEvent", 25, WGPUFeatureName_SharedFenceMTLSharedEvent},
+    {"SharedBufferMemoryD3D12Resource", 31, WGPUFeatureName_SharedBufferMemoryD3D12Resource},
+    {"StaticSamplers", 14, WGPUFeatureName_StaticSamplers},
+    {"YCbCrVulkanSamplers", 19, WGPUFeatureName_YCbCrVulkanSamplers},
+    {"ShaderModuleCompilationOptions", 30, WGPUFeatureName_ShaderModuleCompilationOptions},
+    {"DawnLoadResolveTexture", 22, WGPUFeatureName_DawnLoadResolveTexture},
+    {"DawnPartialLoadResolveTexture", 29, WGPUFeatureName_DawnPartialLoadResolveTexture},
+    {"MultiDrawIndirect", 17, WGPUFeatureName_MultiDrawIndirect},
+    {"DawnTexelCopyBufferRowAlignment", 31, WGPUFeatureName_DawnTexelCopyBufferRowAlignment},
+    {"FlexibleTextureViews", 20, WGPUFeatureName_FlexibleTextureViews},
+    {"ChromiumExperimentalSubgroupMatrix", 34, WGPUFeatureName_ChromiumExperimentalSubgroupMatrix},
+    {"SharedFenceEGLSync", 18, WGPUFeatureName_SharedFenceEGLSync},
+    {"DawnDeviceAllocatorControl", 26, WGPUFeatureName_DawnDeviceAllocatorControl},
+};
+
+/* Perfect hash over the names above: slot -> entry index + 1. */
+static const uint8_t feature_slots[1u << FEATURE_HASH_BITS] = {
+    [1] = 6, [14] = 64, [24] = 10, [27] = 69, [30] = 40, [32] = 28, [35] = 67,
+    [40] = 14, [47] = 71, [49] = 50, [55] = 47, [59] = 13, [60] = 2, [61] = 34,
+    [62] = 37, [64] = 59, [66] = 46, [78] = 48, [83] = 49, [85] = 23, [86] = 4,
+    [99] = 57, [111] = 41, [117] = 26, [118] = 53, [128] = 55, [131] = 36,
+    [132] = 45, [136] = 74, [147] = 21, [159] = 32, [161] = 9, [188] = 17,
+    [189] = 31, [198] = 52, [201] = 8, [212] = 7, [217] = 24, [218] = 70,
+    [232] = 35, [235] = 18, [238] = 73, [239] = 63, [242] = 72, [275] = 75,
+    [276] = 16, [282] = 65, [287] = 42, [288] = 29, [299] = 39, [312] = 58,
+    [318] = 60, [322] = 1, [326] = 56, [344] = 15, [345] = 44, [346] = 43,
+    [359] = 5, [365] = 19, [366] = 12, [381] = 61, [386] = 27, [403] = 30,
+    [410] = 25, [413] = 11, [433] = 51, [434] = 62, [440] = 68, [444] = 76,
+    [457] = 33, [463] = 20, [469] = 66, [482] = 3, [500] = 54, [505] = 22,
+    [507] = 38,
+};
+
+static inline uint32_t feature_hash(const char *name, size_t length)
+{
+    uint32_t h = 0x811C9DC5u ^ FEATURE_HASH_SEED;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= ( uint8_t )name[i];
+        h *= 0x01000193u;
+    }
+    return h;
+}
+
+/* Returns the feature name for code, or "" when the code is unknown. */
+static inline const char *feature_name(uint32_t code)
+{
+    const char *name = NULL;
+    if (code - FEATURE_CORE_BASE < FEATURE_CORE_COUNT) {
+        name = feature_names_core[code - FEATURE_CORE_BASE];
+    } else if (code - FEATURE_DAWN_BASE < FEATURE_DAWN_COUNT) {
+        name = feature_names_dawn[code - FEATURE_DAWN_BASE];
+    }
+    return name != NULL ? name : "";
+}
+
+/* Returns the code for the length bytes at name, or 0 when there is none. */
+static inline WGPUFeatureName feature_from_name(const char *name,
+                                                size_t      length)
+{
+    uint32_t slot = feature_hash(name, length) &
+                    ((1u << FEATURE_HASH_BITS) - 1);
+    uint8_t  index = feature_slots[slot];
+    if (index == 0) {
+        return ( WGPUFeatureName )0;
+    }
+    const struct feature_entry *entry = &feature_entries[index - 1];
+    if (entry->length != length || memcmp(entry->name, name, length) != 0) {
+        return ( WGPUFeatureName )0;
+    }
+    return entry->code;
+}
+
+#define _FEATURE_NAME_FROM_CODE(code) feature_name(code)
 
 #endif /* ifndef WGPU_FEATURES_H */
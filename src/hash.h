@@ -0,0 +1,65 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_HASH_H
+#define WGPU_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Murmur3's 64-bit finaliser. */
+static inline uint64_t hash_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Fast non-cryptographic hash for cache keys: eight bytes per step, so
+ * large inputs such as WGSL sources or pipeline keys stay cheap. */
+static inline uint64_t hash_bytes(const void *data, size_t length,
+                                  uint64_t seed)
+{
+    const uint8_t *p = data;
+    uint64_t       h = seed ^ (length * 0x9E3779B97F4A7C15ull);
+    while (length >= 8) {
+        uint64_t k;
+        memcpy(&k, p, sizeof(k));
+        h = (h ^ hash_mix(k)) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 29;
+        p += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, length);
+    h ^= hash_mix(tail ^ length);
+    return hash_mix(h);
+}
+
+/* Order-dependent combination of two hashes. */
+static inline uint64_t hash_combine(uint64_t h, uint64_t v)
+{
+    return hash_mix(h ^ (v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2)));
+}
+
+#endif /* ifndef WGPU_HASH_H */
@@ -0,0 +1,153 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dawn/webgpu.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "heap_tuner.h"
+
+#define MAX_CANDIDATES 32
+
+/* Dawn's default first, then power-of-two block sizes. */
+static const uint64_t default_mib[] = {0, 4, 8, 16, 32, 64, 128, 256};
+
+static bool replay(const WGPURequestAdapterOptions *options,
+                   const struct heap_trace *trace, uint64_t block_size,
+                   struct heap_tune_result *out)
+{
+    WGPUFeatureName      feature = WGPUFeatureName_DawnDeviceAllocatorControl;
+    WGPUDawnDeviceAllocatorControl control =
+            WGPU_DAWN_DEVICE_ALLOCATOR_CONTROL_INIT;
+    control.allocatorHeapBlockSize = ( size_t )block_size;
+    WGPUDeviceDescriptor device    = WGPU_DEVICE_DESCRIPTOR_INIT;
+    if (block_size > 0) {
+        device.nextInChain          = &control.chain;
+        device.requiredFeatureCount = 1;
+        device.requiredFeatures     = &feature;
+    }
+
+    /* A fresh device per candidate, so no heap outlives its replay. */
+    struct acquire acq;
+    if (!acquire_init(&acq)) {
+        fprintf(stderr, "%s\n", acq.message);
+        return false;
+    }
+    acquire_begin(&acq, &(struct acquire_options){.adapter = options,
+                                                  .device  = &device,
+                                                  .request_device = true});
+    bool ok = acquire_wait(&acq, ACQUIRE_TIMEOUT_INFINITE) == ACQUIRE_SUCCESS;
+    if (!ok) {
+        fprintf(stderr, "%s\n", acq.message);
+    } else {
+        heap_tuner_replay(acq.instance, acq.device, trace, out);
+    }
+    out->block_size = block_size;
+    acquire_release(&acq);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 3 + MAX_CANDIDATES) {
+        fprintf(stderr, "Usage: %s TRACE STORE [BLOCK_MIB...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    struct heap_trace trace;
+    if (!heap_trace_load(argv[1], &trace)) {
+        fprintf(stderr, "Unable to load the trace %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    struct acquire acq;
+    if (!acquire_init(&acq)) {
+        fprintf(stderr, "%s\n", acq.message);
+        return EXIT_FAILURE;
+    }
+    WGPURequestAdapterOptions options = {0};
+    acquire_begin(&acq, &(struct acquire_options){.adapter = &options});
+    struct adapter_caps caps;
+    if (acquire_wait(&acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        !caps_query(acq.adapter, &caps)) {
+        fprintf(stderr, "%s\n", acq.message);
+        acquire_release(&acq);
+        return EXIT_FAILURE;
+    }
+    acquire_release(&acq);
+    uint64_t fingerprint = caps_fingerprint(&caps);
+    bool     tunable     = caps_has_feature(
+            &caps, WGPUFeatureName_DawnDeviceAllocatorControl);
+    caps_free(&caps);
+
+    uint64_t candidates[MAX_CANDIDATES];
+    size_t   count = 0;
+    if (argc > 3) {
+        candidates[count++] = 0;
+        for (int i = 3; i < argc && count < MAX_CANDIDATES; ++i) {
+            candidates[count++] = strtoull(argv[i], NULL, 10) << 20;
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(default_mib) / sizeof(*default_mib);
+             ++i) {
+            candidates[count++] = default_mib[i] << 20;
+        }
+    }
+    if (!tunable) {
+        /* Only the default can be measured. */
+        count = 1;
+    }
+
+    struct heap_tune_result results[MAX_CANDIDATES];
+    size_t                  done = 0;
+    for (size_t i = 0; i < count; ++i) {
+        done += replay(&options, &trace, candidates[i], &results[done]);
+    }
+    const struct heap_tune_result *best = heap_tuner_pick(results, done);
+
+    printf("{\"fingerprint\":\"%016llx\",\"events\":%zu,\"tunable\":%s,"
+           "\"results\":[",
+           ( unsigned long long )fingerprint, trace.count,
+           tunable ? "true" : "false");
+    for (size_t i = 0; i < done; ++i) {
+        const struct heap_tune_result *r = &results[i];
+        printf("%s{\"block_size\":%llu,\"alloc_mean_ns\":%llu,"
+               "\"alloc_max_ns\":%llu,\"peak_allocated\":%llu,"
+               "\"peak_waste\":%llu,\"failed\":%llu}",
+               i ? "," : "", ( unsigned long long )r->block_size,
+               ( unsigned long long )r->alloc_mean_ns,
+               ( unsigned long long )r->alloc_max_ns,
+               ( unsigned long long )r->peak_allocated,
+               ( unsigned long long )r->peak_waste,
+               ( unsigned long long )r->failed);
+    }
+    printf("],\"best\":%lld}\n",
+           best ? ( long long )best->block_size : -1ll);
+
+    bool ok = best != NULL &&
+              (!tunable || heap_tuner_store(argv[2], fingerprint,
+                                            best->block_size));
+    heap_trace_free(&trace);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
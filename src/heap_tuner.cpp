@@ -0,0 +1,296 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dawn/native/DawnNative.h>
+
+#include "heap_tuner.h"
+#include "phase.h"
+
+extern "C" bool heap_trace_load(const char *path, heap_trace *out)
+{
+    *out    = {};
+    FILE *f = std::fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+
+    std::vector<heap_trace_event> events;
+    char                          line[256];
+    bool                          ok = true;
+    while (ok && std::fgets(line, sizeof(line), f) != nullptr) {
+        const char *c = line + std::strspn(line, " \t");
+        if (*c == '#' || *c == '\n' || *c == '\0') {
+            continue;
+        }
+        char              *end;
+        unsigned long long size  = std::strtoull(c, &end, 0);
+        unsigned long long life  = std::strtoull(end, &end, 0);
+        unsigned long long usage = std::strtoull(end, &end, 0);
+        ok = size > 0 && usage > 0 && life <= UINT32_MAX;
+        events.push_back({size, static_cast<uint32_t>(life),
+                          static_cast<WGPUBufferUsage>(usage)});
+    }
+    std::fclose(f);
+    if (!ok || events.empty()) {
+        return false;
+    }
+
+    out->events = static_cast<heap_trace_event *>(
+            std::malloc(events.size() * sizeof(heap_trace_event)));
+    if (out->events == nullptr) {
+        return false;
+    }
+    std::copy(events.begin(), events.end(), out->events);
+    out->count = events.size();
+    return true;
+}
+
+extern "C" void heap_trace_free(heap_trace *trace)
+{
+    std::free(trace->events);
+    *trace = {};
+}
+
+namespace {
+
+/* Error scope pops still outstanding during a replay, and how many of them
+ * reported an error. */
+struct ReplayScopes {
+    uint64_t pending;
+    uint64_t failed;
+};
+
+void PopCallback(WGPUPopErrorScopeStatus status, WGPUErrorType type,
+                 WGPUStringView message, void *userdata1, void *userdata2)
+{
+    (void)message;
+    (void)userdata2;
+    auto *scopes = static_cast<ReplayScopes *>(userdata1);
+    --scopes->pending;
+    scopes->failed += status != WGPUPopErrorScopeStatus_Success ||
+                      type != WGPUErrorType_NoError;
+}
+
+void PopScope(WGPUDevice device, ReplayScopes *scopes)
+{
+    WGPUPopErrorScopeCallbackInfo callbackInfo =
+            WGPU_POP_ERROR_SCOPE_CALLBACK_INFO_INIT;
+    callbackInfo.mode      = WGPUCallbackMode_AllowProcessEvents;
+    callbackInfo.callback  = PopCallback;
+    callbackInfo.userdata1 = scopes;
+    ++scopes->pending;
+    wgpuDevicePopErrorScope(device, callbackInfo);
+}
+
+}  // namespace
+
+extern "C" bool heap_tuner_replay(WGPUInstance instance, WGPUDevice device,
+                                  const heap_trace *trace,
+                                  heap_tune_result *out)
+{
+    *out = {};
+
+    /* Allocation i is freed right before allocation i + 1 + lifetime, so
+     * frees are bucketed by that step up front. */
+    size_t                  count = trace->count;
+    std::vector<WGPUBuffer> buffers(count, nullptr);
+    std::vector<size_t>     head(count + 1, SIZE_MAX);
+    std::vector<size_t>     next(count, SIZE_MAX);
+    for (size_t i = 0; i < count; ++i) {
+        size_t step = std::min<uint64_t>(
+                count, i + 1 + uint64_t{trace->events[i].lifetime});
+        next[i]    = head[step];
+        head[step] = i;
+    }
+
+    /* Dawn hands back an error buffer rather than NULL, so failures are
+     * caught with an error scope around each allocation. */
+    ReplayScopes scopes   = {};
+    uint64_t     total_ns = 0;
+    for (size_t step = 0; step <= count; ++step) {
+        for (size_t i = head[step]; i != SIZE_MAX; i = next[i]) {
+            if (buffers[i] != nullptr) {
+                wgpuBufferDestroy(buffers[i]);
+                wgpuBufferRelease(buffers[i]);
+            }
+        }
+        /* Let Dawn retire the freed memory as an application would between
+         * frames, so the next allocation can reuse it. */
+        wgpuDeviceTick(device);
+        wgpuInstanceProcessEvents(instance);
+        if (step == count) {
+            break;
+        }
+
+        WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+        desc.usage                = trace->events[step].usage;
+        desc.size                 = trace->events[step].size;
+        wgpuDevicePushErrorScope(device, WGPUErrorFilter_OutOfMemory);
+        wgpuDevicePushErrorScope(device, WGPUErrorFilter_Validation);
+        uint64_t start   = phase_now_ns();
+        buffers[step]    = wgpuDeviceCreateBuffer(device, &desc);
+        uint64_t elapsed = phase_now_ns() - start;
+        PopScope(device, &scopes);
+        PopScope(device, &scopes);
+        total_ns += elapsed;
+        out->alloc_max_ns = std::max(out->alloc_max_ns, elapsed);
+
+        dawn::native::AllocatorMemoryInfo info =
+                dawn::native::GetAllocatorMemoryInfo(device);
+        out->peak_allocated =
+                std::max(out->peak_allocated, info.totalAllocatedMemory);
+        if (info.totalAllocatedMemory > info.totalUsedMemory) {
+            out->peak_waste = std::max(
+                    out->peak_waste,
+                    info.totalAllocatedMemory - info.totalUsedMemory);
+        }
+    }
+    while (scopes.pending > 0) {
+        wgpuDeviceTick(device);
+        wgpuInstanceProcessEvents(instance);
+    }
+    out->failed        = scopes.failed;
+    out->alloc_mean_ns = count ? total_ns / count : 0;
+    return out->failed == 0;
+}
+
+extern "C" const heap_tune_result *
+heap_tuner_pick(const heap_tune_result *results, size_t count)
+{
+    uint64_t fastest = UINT64_MAX;
+    for (size_t i = 0; i < count; ++i) {
+        if (results[i].failed == 0) {
+            fastest = std::min(fastest, results[i].alloc_mean_ns);
+        }
+    }
+
+    const heap_tune_result *best = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        const heap_tune_result &r = results[i];
+        if (r.failed > 0 || 4 * r.alloc_mean_ns > 5 * fastest) {
+            continue;
+        }
+        if (best == nullptr || r.peak_waste < best->peak_waste ||
+            (r.peak_waste == best->peak_waste &&
+             r.alloc_mean_ns < best->alloc_mean_ns)) {
+            best = &r;
+        }
+    }
+    return best;
+}
+
+namespace {
+
+/* Lines of "<fingerprint as 16 hex digits> <block size>". */
+std::vector<std::pair<uint64_t, uint64_t>> ReadStore(const char *path)
+{
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    FILE *f = std::fopen(path, "r");
+    if (f == nullptr) {
+        return entries;
+    }
+    uint64_t fingerprint;
+    uint64_t block_size;
+    while (std::fscanf(f, "%" SCNx64 " %" SCNu64, &fingerprint,
+                       &block_size) == 2) {
+        entries.emplace_back(fingerprint, block_size);
+    }
+    std::fclose(f);
+    return entries;
+}
+
+}  // namespace
+
+extern "C" bool heap_tuner_store(const char *path, uint64_t fingerprint,
+                                 uint64_t block_size)
+{
+    auto entries = ReadStore(path);
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const auto &e) {
+        return e.first == fingerprint;
+    });
+    if (it != entries.end()) {
+        it->second = block_size;
+    } else {
+        entries.emplace_back(fingerprint, block_size);
+    }
+
+    std::string tmp = std::string(path) + ".tmp";
+    FILE       *f   = std::fopen(tmp.c_str(), "w");
+    if (f == nullptr) {
+        return false;
+    }
+    for (const auto &[key, value] : entries) {
+        std::fprintf(f, "%016" PRIx64 " %" PRIu64 "\n", key, value);
+    }
+    bool ok = std::fclose(f) == 0;
+    if (!ok || std::rename(tmp.c_str(), path) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+extern "C" uint64_t heap_tuner_lookup(const char *path, uint64_t fingerprint)
+{
+    for (const auto &[key, value] : ReadStore(path)) {
+        if (key == fingerprint) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+extern "C" bool heap_tuner_apply(const char *path, const adapter_caps *caps,
+                                 WGPUDeviceDescriptor *desc,
+                                 heap_tuner_device    *storage)
+{
+    WGPUFeatureName feature = WGPUFeatureName_DawnDeviceAllocatorControl;
+    uint64_t        block   = heap_tuner_lookup(path, caps_fingerprint(caps));
+    size_t          count   = desc->requiredFeatureCount;
+    if (block == 0 || block > SIZE_MAX || !caps_has_feature(caps, feature) ||
+        count + 1 > HEAP_TUNER_MAX_FEATURES) {
+        return false;
+    }
+
+    std::copy(desc->requiredFeatures, desc->requiredFeatures + count,
+              storage->features);
+    if (std::find(storage->features, storage->features + count, feature) ==
+        storage->features + count) {
+        storage->features[count++] = feature;
+    }
+    storage->control = WGPU_DAWN_DEVICE_ALLOCATOR_CONTROL_INIT;
+    storage->control.allocatorHeapBlockSize = static_cast<size_t>(block);
+    storage->control.chain.next             = desc->nextInChain;
+    desc->nextInChain                       = &storage->control.chain;
+    desc->requiredFeatureCount              = count;
+    desc->requiredFeatures                  = storage->features;
+    return true;
+}
+
+// vim: set ft=cpp ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,103 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_HEAP_TUNER_H
+#define WGPU_HEAP_TUNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEAP_TUNER_MAX_FEATURES 64
+
+/* One buffer allocation. It is freed after lifetime further allocations. */
+struct heap_trace_event {
+    uint64_t        size;
+    uint32_t        lifetime;
+    WGPUBufferUsage usage;
+};
+
+struct heap_trace {
+    size_t                   count;
+    struct heap_trace_event *events;
+};
+
+struct heap_tune_result {
+    uint64_t block_size; /* 0 for Dawn's default */
+    uint64_t alloc_mean_ns;
+    uint64_t alloc_max_ns;
+    uint64_t peak_allocated; /* GetAllocatorMemoryInfo totalAllocatedMemory */
+    uint64_t peak_waste;     /* allocated minus used, at its largest */
+    uint64_t failed;
+};
+
+/* Text, one "size lifetime usage" event per line; usage takes C integer
+ * syntax, so 0x hex works. Blank lines and lines starting with # are
+ * skipped. */
+bool heap_trace_load(const char *path, struct heap_trace *out);
+void heap_trace_free(struct heap_trace *trace);
+
+/* Replays trace on device, which should have been created from instance
+ * with the block size under test, and releases every buffer it created.
+ * The device is ticked and instance events processed at every step, and an
+ * allocation fails when its error scopes report an error. */
+bool heap_tuner_replay(WGPUInstance instance, WGPUDevice device,
+                       const struct heap_trace *trace,
+                       struct heap_tune_result *out);
+
+/* The result with the least waste among those allocating within 25% of the
+ * fastest mean latency, or NULL when every replay failed. */
+const struct heap_tune_result *
+heap_tuner_pick(const struct heap_tune_result *results, size_t count);
+
+/* Records block_size for the adapter fingerprint in a small text file,
+ * replacing any earlier value, through a temporary file and rename. */
+bool heap_tuner_store(const char *path, uint64_t fingerprint,
+                      uint64_t block_size);
+
+/* The stored block size for fingerprint, or 0. */
+uint64_t heap_tuner_lookup(const char *path, uint64_t fingerprint);
+
+/* What heap_tuner_apply points a device descriptor at. */
+struct heap_tuner_device {
+    WGPUDawnDeviceAllocatorControl control;
+    WGPUFeatureName                features[HEAP_TUNER_MAX_FEATURES];
+};
+
+/* When a block size is stored for the adapter and it has
+ * DawnDeviceAllocatorControl, chains the control struct into desc and adds
+ * the feature to its required features. desc then points into storage,
+ * which must outlive the device request. */
+bool heap_tuner_apply(const char *path, const struct adapter_caps *caps,
+                      WGPUDeviceDescriptor     *desc,
+                      struct heap_tuner_device *storage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_HEAP_TUNER_H */
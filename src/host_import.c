@@ -0,0 +1,247 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "host_import.h"
+
+/* Handed to Dawn as the dispose userdata, so the caller's callback outlives
+ * the import call. */
+struct pin {
+    host_dispose_fn dispose;
+    void           *userdata;
+    void           *data;
+    uint64_t        size;
+};
+
+static void pin_dispose(void *userdata)
+{
+    struct pin *pin = userdata;
+    if (pin->dispose) {
+        pin->dispose(pin->data, pin->size, pin->userdata);
+    }
+    free(pin);
+}
+
+static void unmap_dispose(void *data, uint64_t size, void *userdata)
+{
+    (void)userdata;
+    munmap(data, ( size_t )size);
+}
+
+size_t host_page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? ( size_t )size : 4096;
+}
+
+uint64_t host_align_size(uint64_t size)
+{
+    uint64_t page = host_page_size();
+    return (size + page - 1) / page * page;
+}
+
+void *host_alloc(uint64_t size)
+{
+    void *data = NULL;
+    if (posix_memalign(&data, host_page_size(),
+                       ( size_t )host_align_size(size)) != 0) {
+        return NULL;
+    }
+    return data;
+}
+
+void host_free(void *data)
+{
+    free(data);
+}
+
+void host_free_dispose(void *data, uint64_t size, void *userdata)
+{
+    (void)size;
+    (void)userdata;
+    host_free(data);
+}
+
+struct scope {
+    WGPUPopErrorScopeStatus status;
+    WGPUErrorType           type;
+};
+
+static void pop_callback(WGPUPopErrorScopeStatus status, WGPUErrorType type,
+                         WGPUStringView message, void *userdata1,
+                         void *userdata2)
+{
+    struct scope *scope = userdata1;
+    (void)message;
+    (void)userdata2;
+    scope->status = status;
+    scope->type   = type;
+}
+
+/* Dawn hands back an error buffer, never NULL, when it rejects the pointer,
+ * e.g. for an alignment it does not support, so the import is checked
+ * through a validation error scope. */
+static bool import_zero_copy(WGPUInstance instance, WGPUDevice device,
+                             void *data, uint64_t size, WGPUBufferUsage usage,
+                             host_dispose_fn dispose, void *userdata,
+                             struct host_import *out)
+{
+    struct pin *pin = malloc(sizeof(*pin));
+    if (pin == NULL) {
+        return false;
+    }
+    *pin = (struct pin){dispose, userdata, data, size};
+
+    WGPUBufferHostMappedPointer host = WGPU_BUFFER_HOST_MAPPED_POINTER_INIT;
+    host.pointer                     = data;
+    host.disposeCallback             = pin_dispose;
+    host.userdata                    = pin;
+
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.nextInChain          = &host.chain;
+    desc.label = (WGPUStringView){.data = "host_import", .length = 11};
+    desc.usage = usage;
+    desc.size  = size;
+    wgpuDevicePushErrorScope(device, WGPUErrorFilter_Validation);
+    WGPUBuffer buffer = wgpuDeviceCreateBuffer(device, &desc);
+
+    struct scope scope = {WGPUPopErrorScopeStatus_Error, WGPUErrorType_Unknown};
+    WGPUPopErrorScopeCallbackInfo callbackInfo =
+            WGPU_POP_ERROR_SCOPE_CALLBACK_INFO_INIT;
+    callbackInfo.mode      = WGPUCallbackMode_WaitAnyOnly;
+    callbackInfo.callback  = pop_callback;
+    callbackInfo.userdata1 = &scope;
+
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future             = wgpuDevicePopErrorScope(device, callbackInfo);
+    bool imported = wgpuInstanceWaitAny(instance, 1, &wait, UINT64_MAX) ==
+                            WGPUWaitStatus_Success &&
+                    scope.status == WGPUPopErrorScopeStatus_Success &&
+                    scope.type == WGPUErrorType_NoError && buffer != NULL;
+    if (!imported) {
+        /* The caller's memory goes to the copy path instead. Whether Dawn
+         * still runs the dispose callback of a rejected import is not
+         * specified, so the pin is left to it with nothing to dispose. */
+        if (buffer != NULL) {
+            pin->dispose = NULL;
+            wgpuBufferRelease(buffer);
+        } else {
+            free(pin);
+        }
+        return false;
+    }
+    out->buffer    = buffer;
+    out->size      = size;
+    out->zero_copy = true;
+    return true;
+}
+
+/* wgpuQueueWriteBuffer wants multiples of 4, so a ragged tail goes through
+ * a padded copy rather than reading past the caller's memory. */
+static bool import_copy(WGPUDevice device, WGPUQueue queue, void *data,
+                        uint64_t size, WGPUBufferUsage usage,
+                        host_dispose_fn dispose, void *userdata,
+                        struct host_import *out)
+{
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.label = (WGPUStringView){.data = "host_import", .length = 11};
+    desc.usage = usage | WGPUBufferUsage_CopyDst;
+    desc.size  = (size + 3) & ~( uint64_t )3;
+    out->buffer    = wgpuDeviceCreateBuffer(device, &desc);
+    out->size      = desc.size;
+    out->zero_copy = false;
+    if (out->buffer == NULL) {
+        return false;
+    }
+
+    uint64_t body = size & ~( uint64_t )3;
+    if (body > 0) {
+        wgpuQueueWriteBuffer(queue, out->buffer, 0, data, ( size_t )body);
+    }
+    if (body < size) {
+        uint8_t tail[4] = {0};
+        memcpy(tail, ( const uint8_t * )data + body, ( size_t )(size - body));
+        wgpuQueueWriteBuffer(queue, out->buffer, body, tail, sizeof(tail));
+    }
+    /* The queue copied the data, so it can go right away. */
+    if (dispose) {
+        dispose(data, size, userdata);
+    }
+    return true;
+}
+
+bool host_import_memory(WGPUInstance instance, WGPUDevice device,
+                        WGPUQueue queue, void *data, uint64_t size,
+                        WGPUBufferUsage usage, host_dispose_fn dispose,
+                        void *userdata, struct host_import *out)
+{
+    /* Page alignment is only a cheap first filter: the device's import
+     * alignment may be coarser, which the import itself reports. */
+    size_t page    = host_page_size();
+    bool   aligned = (( uintptr_t )data % page) == 0 && size % page == 0;
+    if (aligned && size > 0 &&
+        wgpuDeviceHasFeature(device, WGPUFeatureName_HostMappedPointer) &&
+        import_zero_copy(instance, device, data, size, usage, dispose,
+                         userdata, out)) {
+        return true;
+    }
+    return import_copy(device, queue, data, size, usage, dispose, userdata,
+                       out);
+}
+
+bool host_import_file(WGPUInstance instance, WGPUDevice device,
+                      WGPUQueue queue, const char *path, WGPUBufferUsage usage,
+                      struct host_import *out)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    /* Private and writable, since some drivers only import memory they may
+     * write; the pages past the end of the file read as zeros. */
+    uint64_t size = host_align_size(( uint64_t )st.st_size);
+    void    *data = mmap(NULL, ( size_t )size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    if (!host_import_memory(instance, device, queue, data, size, usage,
+                            unmap_dispose, NULL, out)) {
+        munmap(data, ( size_t )size);
+        return false;
+    }
+    return true;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,69 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_HOST_IMPORT_H
+#define WGPU_HOST_IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Called once the memory is no longer needed: when Dawn disposes of an
+ * imported buffer, or straight after the copy on the fallback path. */
+typedef void (*host_dispose_fn)(void *data, uint64_t size, void *userdata);
+
+struct host_import {
+    WGPUBuffer buffer;
+    uint64_t   size;
+    bool       zero_copy; /* false when the data was copied in */
+};
+
+size_t host_page_size(void);
+
+/* size rounded up to a whole number of pages. */
+uint64_t host_align_size(uint64_t size);
+
+/* Page-aligned memory of host_align_size(size) bytes, ready for import.
+ * Free with host_free, or pass host_free_dispose as the dispose callback. */
+void *host_alloc(uint64_t size);
+void  host_free(void *data);
+void  host_free_dispose(void *data, uint64_t size, void *userdata);
+
+/* Wraps size bytes at data as a buffer with usage, through HostMappedPointer
+ * when the device has it, data and size are page aligned and the device
+ * accepts the pointer, so the GPU reads the memory in place. The memory
+ * stays pinned until dispose runs, which is after the buffer is released
+ * and the GPU is done with it. Otherwise the buffer gets CopyDst and is
+ * filled by wgpuQueueWriteBuffer. The import is checked through an error
+ * scope waited on with instance, which needs timed waits enabled. */
+bool host_import_memory(WGPUInstance instance, WGPUDevice device,
+                        WGPUQueue queue, void *data, uint64_t size,
+                        WGPUBufferUsage usage, host_dispose_fn dispose,
+                        void *userdata, struct host_import *out);
+
+/* Maps the file privately and imports it; the mapping lasts as long as the
+ * buffer. out->size is the page-aligned size, zero-filled past the end of
+ * the file. */
+bool host_import_file(WGPUInstance instance, WGPUDevice device,
+                      WGPUQueue queue, const char *path, WGPUBufferUsage usage,
+                      struct host_import *out);
+
+#endif /* ifndef WGPU_HOST_IMPORT_H */
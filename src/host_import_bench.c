@@ -0,0 +1,181 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dawn/webgpu.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "host_import.h"
+#include "phase.h"
+
+struct bench {
+    struct acquire acq;
+    uint64_t       size;
+    long           iterations;
+    void          *host;
+    WGPUBuffer     dst;
+};
+
+static void work_done(WGPUQueueWorkDoneStatus status, void *userdata1,
+                      void *userdata2)
+{
+    (void)status;
+    (void)userdata1;
+    (void)userdata2;
+}
+
+static void wait_idle(struct bench *b)
+{
+    WGPUQueueWorkDoneCallbackInfo info =
+            WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+    info.mode     = WGPUCallbackMode_WaitAnyOnly;
+    info.callback = work_done;
+
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future             = wgpuQueueOnSubmittedWorkDone(b->acq.queue, info);
+    wgpuInstanceWaitAny(b->acq.instance, 1, &wait, UINT64_MAX);
+}
+
+/* Both paths end with the data in a device buffer, so each one pays for
+ * the GPU actually reading the host memory. */
+static uint64_t run(struct bench *b, bool import, bool *zero_copy)
+{
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations; ++i) {
+        WGPUBuffer src = NULL;
+        if (import) {
+            struct host_import imported;
+            if (!host_import_memory(b->acq.instance, b->acq.device,
+                                    b->acq.queue, b->host, b->size,
+                                    WGPUBufferUsage_CopySrc, NULL, NULL,
+                                    &imported)) {
+                return 0;
+            }
+            src        = imported.buffer;
+            *zero_copy = imported.zero_copy;
+        }
+
+        WGPUCommandEncoder encoder =
+                wgpuDeviceCreateCommandEncoder(b->acq.device, NULL);
+        if (src != NULL) {
+            wgpuCommandEncoderCopyBufferToBuffer(encoder, src, 0, b->dst, 0,
+                                                 b->size);
+        } else {
+            wgpuQueueWriteBuffer(b->acq.queue, b->dst, 0, b->host,
+                                 ( size_t )b->size);
+        }
+        WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(encoder, NULL);
+        wgpuQueueSubmit(b->acq.queue, 1, &cmd);
+        wgpuCommandBufferRelease(cmd);
+        wgpuCommandEncoderRelease(encoder);
+        wait_idle(b);
+        if (src != NULL) {
+            wgpuBufferRelease(src);
+        }
+    }
+    return phase_now_ns() - start;
+}
+
+static double mib_per_second(const struct bench *b, uint64_t ns)
+{
+    if (ns == 0) {
+        return 0;
+    }
+    return ( double )b->size * ( double )b->iterations / (1024.0 * 1024.0) /
+           (( double )ns / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    long mib        = argc > 1 ? strtol(argv[1], NULL, 10) : 64;
+    long iterations = argc > 2 ? strtol(argv[2], NULL, 10) : 16;
+    if (mib <= 0 || iterations <= 0) {
+        fprintf(stderr, "Usage: %s [MIB [ITERATIONS]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* The adapter is probed first so the device can be asked for
+     * HostMappedPointer only where it exists. */
+    struct bench b = {.size       = host_align_size(( uint64_t )mib << 20),
+                      .iterations = iterations};
+    if (!acquire_init(&b.acq)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        return EXIT_FAILURE;
+    }
+    WGPURequestAdapterOptions options = {0};
+    acquire_begin(&b.acq, &(struct acquire_options){.adapter = &options});
+    struct adapter_caps caps;
+    if (acquire_wait(&b.acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        !caps_query(b.acq.adapter, &caps)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        acquire_release(&b.acq);
+        return EXIT_FAILURE;
+    }
+    WGPUFeatureName      feature = WGPUFeatureName_HostMappedPointer;
+    WGPUDeviceDescriptor device  = WGPU_DEVICE_DESCRIPTOR_INIT;
+    if (caps_has_feature(&caps, feature)) {
+        device.requiredFeatureCount = 1;
+        device.requiredFeatures     = &feature;
+    }
+    caps_free(&caps);
+    acquire_release(&b.acq);
+    if (!acquire_init(&b.acq)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        return EXIT_FAILURE;
+    }
+    acquire_begin(&b.acq, &(struct acquire_options){.adapter = &options,
+                                                    .device  = &device,
+                                                    .request_device = true});
+    b.host = host_alloc(b.size);
+    if (acquire_wait(&b.acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        b.host == NULL) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        acquire_release(&b.acq);
+        host_free(b.host);
+        return EXIT_FAILURE;
+    }
+    memset(b.host, 0xa5, ( size_t )b.size);
+
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
+    desc.size  = b.size;
+    b.dst      = wgpuDeviceCreateBuffer(b.acq.device, &desc);
+
+    bool   zero_copy    = false;
+    double write_buffer = mib_per_second(&b, run(&b, false, &zero_copy));
+    double imported     = mib_per_second(&b, run(&b, true, &zero_copy));
+
+    printf("{\"mib\":%ld,\"iterations\":%ld,\"page_size\":%zu,"
+           "\"zero_copy\":%s,\"write_buffer_mibps\":%.1f,"
+           "\"import_mibps\":%.1f}\n",
+           mib, iterations, host_page_size(), zero_copy ? "true" : "false",
+           write_buffer, imported);
+
+    wgpuBufferRelease(b.dst);
+    acquire_release(&b.acq);
+    host_free(b.host);
+    return EXIT_SUCCESS;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
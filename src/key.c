@@ -0,0 +1,111 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+#include "key.h"
+
+#define KEY_SEED 0x6465736372697074ull
+
+void key_reset(struct key *key)
+{
+    key->size   = 0;
+    key->failed = false;
+}
+
+void key_free(struct key *key)
+{
+    free(key->data);
+    memset(key, 0, sizeof(*key));
+}
+
+void key_bytes(struct key *key, const void *data, size_t size)
+{
+    if (key->failed || size == 0) {
+        return;
+    }
+    if (key->size + size > key->capacity) {
+        size_t capacity = key->capacity ? key->capacity : 256;
+        while (capacity < key->size + size) {
+            capacity *= 2;
+        }
+        uint8_t *data = realloc(key->data, capacity);
+        if (data == NULL) {
+            key->failed = true;
+            return;
+        }
+        key->data     = data;
+        key->capacity = capacity;
+    }
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+}
+
+void key_u32(struct key *key, uint32_t value)
+{
+    key_bytes(key, &value, sizeof(value));
+}
+
+void key_u64(struct key *key, uint64_t value)
+{
+    key_bytes(key, &value, sizeof(value));
+}
+
+void key_f64(struct key *key, double value)
+{
+    key_bytes(key, &value, sizeof(value));
+}
+
+void key_ptr(struct key *key, const void *handle)
+{
+    key_u64(key, ( uint64_t )( uintptr_t )handle);
+}
+
+void key_string(struct key *key, WGPUStringView view)
+{
+    size_t length = view.length;
+    if (length == WGPU_STRLEN) {
+        length = view.data ? strlen(view.data) : 0;
+    }
+    /* A null view and an empty one mean different things to Dawn. */
+    key_u64(key, view.data ? length : UINT64_MAX);
+    key_bytes(key, view.data, length);
+}
+
+void key_no_chain(struct key *key, const WGPUChainedStruct *chain)
+{
+    if (chain != NULL) {
+        key->failed = true;
+    }
+}
+
+uint64_t key_hash(const struct key *key)
+{
+    return hash_bytes(key->data, key->size, KEY_SEED);
+}
+
+bool key_equal(const struct key *a, const void *data, size_t size)
+{
+    return !a->failed && a->size == size &&
+           (size == 0 || memcmp(a->data, data, size) == 0);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,56 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_KEY_H
+#define WGPU_KEY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* Growable byte string that descriptors are flattened into, so that caches
+ * can hash and compare them without knowing their shape. Handles are keyed
+ * by address. A failed key (out of memory, or a chained struct the caller
+ * can't flatten) never compares equal to anything. */
+struct key {
+    uint8_t *data;
+    size_t   size;
+    size_t   capacity;
+    bool     failed;
+};
+
+void key_reset(struct key *key);
+void key_free(struct key *key);
+
+void key_bytes(struct key *key, const void *data, size_t size);
+void key_u32(struct key *key, uint32_t value);
+void key_u64(struct key *key, uint64_t value);
+void key_f64(struct key *key, double value);
+void key_ptr(struct key *key, const void *handle);
+/* Length prefixed, so adjacent strings can't run into each other. */
+void key_string(struct key *key, WGPUStringView view);
+/* Marks the key failed unless chain is NULL. */
+void key_no_chain(struct key *key, const WGPUChainedStruct *chain);
+
+uint64_t key_hash(const struct key *key);
+bool     key_equal(const struct key *a, const void *data, size_t size);
+
+#endif /* ifndef WGPU_KEY_H */
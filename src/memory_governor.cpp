@@ -0,0 +1,215 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <dawn/native/DawnNative.h>
+#include <dawn/webgpu_cpp.h>
+
+#include "memory_governor.h"
+
+struct memory_governor {
+    wgpu::Device device;
+    double       high_water;
+    double       low_water;
+    uint64_t     interval_ns;
+
+    std::mutex                   lock;
+    memory_usage                 usage;
+    struct memory_governor_stats stats;
+    bool                         reducing;
+
+    /* Serializes the calls into Dawn between the thread and callers. */
+    std::mutex tick_lock;
+
+    std::condition_variable wake;
+    bool                    woken;
+    bool                    stopping;
+    std::thread             thread;
+};
+
+namespace {
+
+uint64_t HeapBudget(const adapter_caps *caps)
+{
+    uint64_t local = 0;
+    uint64_t total = 0;
+    for (size_t i = 0; caps != nullptr && i < caps->heap_count; ++i) {
+        total += caps->heaps[i].size;
+        if (caps->heaps[i].properties & WGPUHeapProperty_DeviceLocal) {
+            local += caps->heaps[i].size;
+        }
+    }
+    return local > 0 ? local : total;
+}
+
+void Run(memory_governor *g)
+{
+    std::unique_lock<std::mutex> guard(g->lock);
+    while (!g->stopping) {
+        g->wake.wait_for(guard, std::chrono::nanoseconds(g->interval_ns),
+                         [g] { return g->woken || g->stopping; });
+        if (g->stopping) {
+            break;
+        }
+        g->woken = false;
+        guard.unlock();
+        memory_governor_tick(g);
+        guard.lock();
+    }
+}
+
+}  // namespace
+
+extern "C" memory_governor *
+memory_governor_create(const memory_governor_options *opts)
+{
+    uint64_t budget = opts->budget ? opts->budget : HeapBudget(opts->caps);
+    if (budget == 0 ||
+        (opts->interval_ns > 0 &&
+         !wgpuDeviceHasFeature(
+                 opts->device,
+                 WGPUFeatureName_ImplicitDeviceSynchronization))) {
+        return nullptr;
+    }
+
+    auto *g         = new memory_governor();
+    g->device       = wgpu::Device(opts->device);
+    g->high_water   = opts->high_water > 0 ? opts->high_water
+                                           : MEMORY_HIGH_WATER_DEFAULT;
+    g->low_water    = opts->low_water > 0 ? opts->low_water
+                                          : MEMORY_LOW_WATER_DEFAULT;
+    g->low_water    = std::min(g->low_water, g->high_water);
+    g->interval_ns  = opts->interval_ns;
+    g->usage        = {};
+    g->usage.budget = budget;
+    g->stats        = {};
+    g->reducing     = false;
+    g->woken        = false;
+    g->stopping     = false;
+
+    memory_governor_tick(g);
+    if (g->interval_ns > 0) {
+        g->thread = std::thread(Run, g);
+    }
+    return g;
+}
+
+extern "C" memory_admission memory_governor_admit(memory_governor *g,
+                                                  uint64_t         size)
+{
+    std::lock_guard<std::mutex> guard(g->lock);
+    uint64_t projected = g->usage.usage + g->usage.admitted + size;
+    if (projected > g->usage.budget) {
+        ++g->stats.denied;
+        g->woken = true;
+        g->wake.notify_one();
+        return MEMORY_DENY;
+    }
+    if (projected > g->high_water * g->usage.budget) {
+        ++g->stats.deferred;
+        g->woken = true;
+        g->wake.notify_one();
+        return MEMORY_DEFER;
+    }
+    ++g->stats.admitted;
+    g->usage.admitted += size;
+    return MEMORY_ADMIT;
+}
+
+extern "C" void memory_governor_tick(memory_governor *g)
+{
+    std::lock_guard<std::mutex> serial(g->tick_lock);
+    WGPUDevice                  device = g->device.Get();
+
+    dawn::native::MemoryUsageInfo estimate =
+            dawn::native::ComputeEstimatedMemoryUsageInfo(device);
+    dawn::native::AllocatorMemoryInfo allocator =
+            dawn::native::GetAllocatorMemoryInfo(device);
+    uint64_t usage = std::max(estimate.totalUsage,
+                              allocator.totalAllocatedMemory);
+
+    bool reduce;
+    {
+        std::lock_guard<std::mutex> guard(g->lock);
+        g->usage.usage               = usage;
+        g->usage.admitted            = 0;
+        g->usage.estimated           = estimate.totalUsage;
+        g->usage.buffers             = estimate.buffersUsage;
+        g->usage.textures            = estimate.texturesUsage;
+        g->usage.allocator_used      = allocator.totalUsedMemory;
+        g->usage.allocator_allocated = allocator.totalAllocatedMemory;
+        g->stats.peak_usage = std::max(g->stats.peak_usage, usage);
+        ++g->stats.samples;
+
+        /* Hysteresis: start above high water, keep going until low. */
+        if (usage > g->high_water * g->usage.budget) {
+            g->reducing = true;
+        } else if (usage <= g->low_water * g->usage.budget) {
+            g->reducing = false;
+        }
+        reduce = g->reducing;
+    }
+    if (!reduce) {
+        return;
+    }
+
+    /* ReduceMemoryUsage returning true means more is freed once submitted
+     * work completes, which the next tick picks up. */
+    bool more = dawn::native::ReduceMemoryUsage(device);
+    dawn::native::PerformIdleTasks(g->device);
+
+    std::lock_guard<std::mutex> guard(g->lock);
+    ++g->stats.reductions;
+    if (!more) {
+        g->reducing = false;
+    }
+}
+
+extern "C" void memory_governor_usage(memory_governor *g, memory_usage *out)
+{
+    std::lock_guard<std::mutex> guard(g->lock);
+    *out = g->usage;
+}
+
+extern "C" void memory_governor_stats(memory_governor              *g,
+                                      struct memory_governor_stats *out)
+{
+    std::lock_guard<std::mutex> guard(g->lock);
+    *out = g->stats;
+}
+
+extern "C" void memory_governor_destroy(memory_governor *g)
+{
+    {
+        std::lock_guard<std::mutex> guard(g->lock);
+        g->stopping = true;
+    }
+    g->wake.notify_one();
+    if (g->thread.joinable()) {
+        g->thread.join();
+    }
+    delete g;
+}
+
+// vim: set ft=cpp ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,105 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_MEMORY_GOVERNOR_H
+#define WGPU_MEMORY_GOVERNOR_H
+
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMORY_HIGH_WATER_DEFAULT 0.85
+#define MEMORY_LOW_WATER_DEFAULT  0.70
+
+typedef enum memory_admission {
+    MEMORY_ADMIT = 0,
+    MEMORY_DEFER, /* would cross the high-water mark, retry after reclaim */
+    MEMORY_DENY,  /* would exceed the budget */
+} memory_admission;
+
+struct memory_governor_options {
+    WGPUDevice device;
+    /* The budget is the sum of the DeviceLocal heaps, or of every heap when
+     * none is marked DeviceLocal. A non-zero budget overrides it. */
+    const struct adapter_caps *caps;
+    uint64_t                   budget;
+    double                     high_water;
+    double                     low_water;
+    /* Sampling period of the background thread, which needs a device with
+     * ImplicitDeviceSynchronization. Zero leaves sampling to
+     * memory_governor_tick on the device's thread. */
+    uint64_t interval_ns;
+};
+
+struct memory_usage {
+    uint64_t budget;
+    uint64_t usage; /* the larger of the estimate and the allocators */
+    uint64_t admitted; /* admitted since the sample, not yet counted */
+    uint64_t estimated;
+    uint64_t buffers;
+    uint64_t textures;
+    uint64_t allocator_used;
+    uint64_t allocator_allocated;
+};
+
+struct memory_governor_stats {
+    uint64_t samples;
+    uint64_t admitted;
+    uint64_t deferred;
+    uint64_t denied;
+    uint64_t reductions;
+    uint64_t peak_usage;
+};
+
+struct memory_governor;
+
+/* Fails without a budget, or with a background thread on a device lacking
+ * ImplicitDeviceSynchronization. */
+struct memory_governor *
+memory_governor_create(const struct memory_governor_options *opts);
+
+/* Admission control for a new allocation of size bytes, against the last
+ * sample plus what was admitted since. Deferring wakes the background
+ * thread so memory is reclaimed right away. */
+memory_admission memory_governor_admit(struct memory_governor *g,
+                                       uint64_t                size);
+
+/* Samples usage and, above the high-water mark, calls ReduceMemoryUsage and
+ * PerformIdleTasks until usage falls under the low-water mark or nothing is
+ * left to free. */
+void memory_governor_tick(struct memory_governor *g);
+
+void memory_governor_usage(struct memory_governor *g, struct memory_usage *out);
+
+void memory_governor_stats(struct memory_governor       *g,
+                           struct memory_governor_stats *out);
+
+void memory_governor_destroy(struct memory_governor *g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_MEMORY_GOVERNOR_H */
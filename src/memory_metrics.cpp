@@ -0,0 +1,480 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dawn/native/DawnNative.h>
+
+#include "memory_metrics.h"
+#include "writer.h"
+
+namespace {
+
+/* How long a scraper gets to take the export before it is dropped, so a
+ * stalled client cannot hold up the periodic export. */
+constexpr int kSendTimeoutMs = 250;
+
+/* Nodes are keyed by their path cut to the configured depth, so repeated
+ * dumps reuse the same entries and per-object detail folds into totals. A
+ * node not touched by the latest dump is left out of the export and pruned
+ * by the next one. */
+class Collector : public dawn::native::MemoryDump {
+  public:
+    explicit Collector(unsigned depth) : mDepth(depth) {}
+
+    void AddScalar(const char *name, const char *key, const char *units,
+                   uint64_t value) override
+    {
+        Node &node = Touch(name);
+        for (Scalar &scalar : node.scalars) {
+            if (scalar.key == key && scalar.units == units) {
+                scalar.value += value;
+                return;
+            }
+        }
+        node.scalars.push_back({key, units, value});
+    }
+
+    void AddString(const char *name, const char *key,
+                   const std::string &value) override
+    {
+        /* Strings do not sum, so only nodes at the kept depth have them. */
+        if (Depth(name) > mDepth) {
+            return;
+        }
+        Touch(name).strings.emplace_back(key, value);
+    }
+
+    void Begin()
+    {
+        for (auto it = mNodes.begin(); it != mNodes.end();) {
+            it = it->second.seen == mGeneration ? std::next(it)
+                                                : mNodes.erase(it);
+        }
+        ++mGeneration;
+    }
+
+    void Render(std::string *out) const;
+
+  private:
+    struct Scalar {
+        std::string key;
+        std::string units;
+        uint64_t    value;
+    };
+
+    struct Node {
+        uint64_t                                         seen = 0;
+        std::vector<Scalar>                              scalars;
+        std::vector<std::pair<std::string, std::string>> strings;
+    };
+
+    static unsigned Depth(const char *name)
+    {
+        unsigned depth = 1;
+        for (const char *c = name; *c != '\0'; ++c) {
+            depth += *c == '/';
+        }
+        return depth;
+    }
+
+    Node &Touch(const char *name)
+    {
+        const char *end = name;
+        for (unsigned depth = 0; *end != '\0'; ++end) {
+            if (*end == '/' && ++depth == mDepth) {
+                break;
+            }
+        }
+        mPath.assign(name, end);
+        Node &node = mNodes[mPath];
+        if (node.seen != mGeneration) {
+            node.seen = mGeneration;
+            node.scalars.clear();
+            node.strings.clear();
+        }
+        return node;
+    }
+
+    unsigned                    mDepth;
+    uint64_t                    mGeneration = 1;
+    std::string                 mPath;
+    std::map<std::string, Node> mNodes;
+};
+
+void AppendName(std::string *out, const std::string &part)
+{
+    for (char c : part) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '_';
+        out->push_back(ok ? c : '_');
+    }
+}
+
+void AppendLabel(std::string *out, const std::string &value)
+{
+    out->push_back('"');
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out->push_back('\\');
+            out->push_back(c);
+        } else if (c == '\n') {
+            out->append("\\n");
+        } else {
+            out->push_back(c);
+        }
+    }
+    out->push_back('"');
+}
+
+/* dawn_memory_<key>_<units>, with the unit as the suffix OpenMetrics wants
+ * and not repeated when the key already ends with it. */
+std::string FamilyName(const std::string &key, const std::string &units)
+{
+    std::string name = "dawn_memory_";
+    AppendName(&name, key);
+    std::string suffix = "_";
+    AppendName(&suffix, units);
+    if (!units.empty() &&
+        (name.size() < suffix.size() ||
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix))) {
+        name += suffix;
+    }
+    return name;
+}
+
+void Collector::Render(std::string *out) const
+{
+    out->clear();
+
+    std::set<std::pair<std::string, std::string>> families;
+    std::set<std::string>                         infos;
+    for (const auto &[path, node] : mNodes) {
+        if (node.seen != mGeneration) {
+            continue;
+        }
+        for (const Scalar &scalar : node.scalars) {
+            families.emplace(scalar.key, scalar.units);
+        }
+        for (const auto &string : node.strings) {
+            infos.insert(string.first);
+        }
+    }
+
+    /* Every sample of a family has to be contiguous. */
+    for (const auto &[key, units] : families) {
+        std::string name = FamilyName(key, units);
+        *out += "# TYPE " + name + " gauge\n";
+        if (!units.empty()) {
+            *out += "# UNIT " + name + " ";
+            AppendName(out, units);
+            out->push_back('\n');
+        }
+        for (const auto &[path, node] : mNodes) {
+            if (node.seen != mGeneration) {
+                continue;
+            }
+            for (const Scalar &scalar : node.scalars) {
+                if (scalar.key != key || scalar.units != units) {
+                    continue;
+                }
+                *out += name + "{path=";
+                AppendLabel(out, path);
+                *out += "} " + std::to_string(scalar.value) + "\n";
+            }
+        }
+    }
+    for (const std::string &key : infos) {
+        std::string name = "dawn_memory_";
+        AppendName(&name, key);
+        *out += "# TYPE " + name + " info\n";
+        for (const auto &[path, node] : mNodes) {
+            if (node.seen != mGeneration) {
+                continue;
+            }
+            for (const auto &[string_key, value] : node.strings) {
+                if (string_key != key) {
+                    continue;
+                }
+                *out += name + "_info{path=";
+                AppendLabel(out, path);
+                *out += ",value=";
+                AppendLabel(out, value);
+                *out += "} 1\n";
+            }
+        }
+    }
+    *out += "# EOF\n";
+}
+
+bool WriteAll(int fd, const std::string &text)
+{
+    auto w = std::make_unique<writer>();
+    writer_init(w.get(), fd);
+    writer_bytes(w.get(), text.data(), text.size());
+    return writer_flush(w.get());
+}
+
+/* Sends without raising SIGPIPE on a client that hung up, and gives up
+ * once the client has not drained its socket for kSendTimeoutMs. */
+bool Serve(int client, const std::string &text)
+{
+    int flags = fcntl(client, F_GETFL);
+    if (flags < 0 || fcntl(client, F_SETFL, flags | O_NONBLOCK) != 0) {
+        return false;
+    }
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#ifdef MSG_NOSIGNAL
+    const int send_flags = MSG_NOSIGNAL;
+#else
+    const int send_flags = 0;
+#endif
+
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = send(client, text.data() + sent, text.size() - sent,
+                         send_flags);
+        if (n >= 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        pollfd fd = {client, POLLOUT, 0};
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) ||
+            poll(&fd, 1, kSendTimeoutMs) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+struct memory_metrics {
+    WGPUDevice  device;
+    uint64_t    interval_ns;
+    std::string path;
+    std::string socket_path;
+    int         listener = -1;
+    int         wake[2]  = {-1, -1};
+
+    /* Guards the collector and the latest export. */
+    std::mutex  lock;
+    Collector   collector;
+    std::string text;
+
+    std::thread thread;
+
+    explicit memory_metrics(unsigned depth) : collector(depth) {}
+};
+
+namespace {
+
+void Snapshot(memory_metrics *m)
+{
+    m->collector.Begin();
+    dawn::native::DumpMemoryStatistics(m->device, &m->collector);
+    m->collector.Render(&m->text);
+}
+
+/* Written next to the target and renamed over it, so a reader never sees
+ * a partial export. */
+void Export(memory_metrics *m, const std::string &text)
+{
+    std::string tmp = m->path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    bool ok = WriteAll(fd, text);
+    ok      = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), m->path.c_str()) != 0) {
+        unlink(tmp.c_str());
+    }
+}
+
+void Run(memory_metrics *m)
+{
+    using clock   = std::chrono::steady_clock;
+    auto interval = std::chrono::nanoseconds(m->interval_ns);
+    auto next     = clock::now();
+    for (;;) {
+        auto now = clock::now();
+        if (now >= next) {
+            std::string text;
+            {
+                std::lock_guard<std::mutex> guard(m->lock);
+                Snapshot(m);
+                text = m->text;
+            }
+            if (!m->path.empty()) {
+                Export(m, text);
+            }
+            next = now + interval;
+            continue;
+        }
+
+        pollfd fds[2] = {{m->wake[0], POLLIN, 0}, {m->listener, POLLIN, 0}};
+        auto   wait   = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next - now);
+        if (poll(fds, m->listener >= 0 ? 2 : 1,
+                 static_cast<int>(wait.count()) + 1) < 0) {
+            continue;
+        }
+        if (fds[0].revents) {
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            int client = accept(m->listener, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            /* Served from the latest periodic export rather than a fresh
+             * dump, so scrapes cost the device nothing. */
+            std::string text;
+            {
+                std::lock_guard<std::mutex> guard(m->lock);
+                text = m->text;
+            }
+            Serve(client, text);
+            close(client);
+        }
+    }
+}
+
+int Listen(const std::string &path)
+{
+    sockaddr_un addr = {};
+    addr.sun_family  = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}  // namespace
+
+extern "C" memory_metrics *
+memory_metrics_create(const memory_metrics_options *opts)
+{
+    /* The file and the socket are only fed by the background export. */
+    if (opts->interval_ns == 0 && (opts->path || opts->socket_path)) {
+        return nullptr;
+    }
+    if (opts->interval_ns > 0 &&
+        !wgpuDeviceHasFeature(opts->device,
+                              WGPUFeatureName_ImplicitDeviceSynchronization)) {
+        return nullptr;
+    }
+
+    auto m = std::make_unique<memory_metrics>(
+            opts->depth ? opts->depth : MEMORY_METRICS_DEPTH_DEFAULT);
+    m->device      = opts->device;
+    m->interval_ns = opts->interval_ns;
+    m->path        = opts->path ? opts->path : "";
+    m->socket_path = opts->socket_path ? opts->socket_path : "";
+    if (m->interval_ns == 0) {
+        wgpuDeviceAddRef(m->device);
+        return m.release();
+    }
+
+    if (!m->socket_path.empty() &&
+        (m->listener = Listen(m->socket_path)) < 0) {
+        return nullptr;
+    }
+    if (pipe(m->wake) != 0) {
+        if (m->listener >= 0) {
+            close(m->listener);
+            unlink(m->socket_path.c_str());
+        }
+        return nullptr;
+    }
+    wgpuDeviceAddRef(m->device);
+    m->thread = std::thread(Run, m.get());
+    return m.release();
+}
+
+extern "C" bool memory_metrics_write(memory_metrics *m, int fd)
+{
+    std::string text;
+    {
+        std::lock_guard<std::mutex> guard(m->lock);
+        Snapshot(m);
+        text = m->text;
+    }
+    return WriteAll(fd, text);
+}
+
+extern "C" void memory_metrics_destroy(memory_metrics *m)
+{
+    if (m->thread.joinable()) {
+        char    stop = 0;
+        ssize_t n;
+        do {
+            n = write(m->wake[1], &stop, 1);
+        } while (n < 0 && errno == EINTR);
+        m->thread.join();
+    }
+    for (int fd : m->wake) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (m->listener >= 0) {
+        close(m->listener);
+        unlink(m->socket_path.c_str());
+    }
+    wgpuDeviceRelease(m->device);
+    delete m;
+}
+
+// vim: set ft=cpp ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,69 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_MEMORY_METRICS_H
+#define WGPU_MEMORY_METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEMORY_METRICS_DEPTH_DEFAULT 2
+
+struct memory_metrics_options {
+    WGPUDevice device;
+    /* Path segments kept as the path label. Deeper nodes are summed into
+     * their ancestor, which bounds the number of series. */
+    unsigned depth;
+    /* Period of the background export, which needs a device with
+     * ImplicitDeviceSynchronization. Zero only exports on demand, through
+     * memory_metrics_write, and leaves path and socket_path unset. */
+    uint64_t interval_ns;
+    /* Rewritten atomically each period, when set. */
+    const char *path;
+    /* Unix socket answering each connection with the latest export, so it
+     * can be scraped, when set. A client that does not read the export
+     * promptly is dropped. */
+    const char *socket_path;
+};
+
+struct memory_metrics;
+
+/* Fails on a background export without ImplicitDeviceSynchronization, on
+ * a path or socket_path without a background export, or when the socket
+ * cannot be bound. */
+struct memory_metrics *
+memory_metrics_create(const struct memory_metrics_options *opts);
+
+/* Takes a dawn::native::DumpMemoryStatistics snapshot now and writes it to
+ * fd in the OpenMetrics text format. */
+bool memory_metrics_write(struct memory_metrics *m, int fd);
+
+void memory_metrics_destroy(struct memory_metrics *m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_MEMORY_METRICS_H */
@@ -0,0 +1,387 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "parallel_encode.h"
+#include "phase.h"
+
+struct pass {
+    encode_fn fn;
+    void     *userdata;
+    uint64_t  cost;
+    size_t    dep_first; /* into the encoder's deps */
+    size_t    dep_count;
+};
+
+/* Records order[first, first + count) into one command buffer. */
+struct worker {
+    struct parallel_encoder *pe;
+    pthread_t                thread;
+    size_t                   first;
+    size_t                   count;
+    WGPUCommandBuffer        cmd;
+};
+
+struct parallel_encoder {
+    WGPUDevice device;
+    WGPUQueue  queue;
+    size_t     threads;
+
+    struct pass *passes;
+    size_t       pass_count;
+    size_t       pass_capacity;
+    int         *deps;
+    size_t       dep_count;
+    size_t       dep_capacity;
+
+    /* Scratch for ordering, sized with the passes and deps above. order is
+     * also the FIFO of the topological sort; dependents lists, per pass,
+     * the passes waiting on it, starting at dependents_first. */
+    size_t *order;
+    size_t *waiting;
+    size_t *dependents_first;
+    size_t *dependents;
+
+    pthread_mutex_t    lock;
+    pthread_cond_t     start;
+    pthread_cond_t     finished;
+    uint64_t           generation;
+    size_t             busy;
+    bool               stopping;
+    struct worker     *workers;
+    size_t             started;
+    WGPUCommandBuffer *cmds;
+};
+
+static void record(struct worker *w)
+{
+    struct parallel_encoder *pe = w->pe;
+    w->cmd                      = NULL;
+    if (w->count == 0) {
+        return;
+    }
+    WGPUCommandEncoder encoder =
+            wgpuDeviceCreateCommandEncoder(pe->device, NULL);
+    for (size_t i = w->first; i < w->first + w->count; ++i) {
+        const struct pass *p = &pe->passes[pe->order[i]];
+        p->fn(encoder, p->userdata);
+    }
+    w->cmd = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuCommandEncoderRelease(encoder);
+}
+
+static void *worker_main(void *arg)
+{
+    struct worker           *w    = arg;
+    struct parallel_encoder *pe   = w->pe;
+    uint64_t                 seen = 0;
+
+    pthread_mutex_lock(&pe->lock);
+    for (;;) {
+        while (pe->generation == seen && !pe->stopping) {
+            pthread_cond_wait(&pe->start, &pe->lock);
+        }
+        if (pe->stopping) {
+            break;
+        }
+        seen = pe->generation;
+        pthread_mutex_unlock(&pe->lock);
+        record(w);
+        pthread_mutex_lock(&pe->lock);
+        if (--pe->busy == 0) {
+            pthread_cond_signal(&pe->finished);
+        }
+    }
+    pthread_mutex_unlock(&pe->lock);
+    return NULL;
+}
+
+static bool grow_passes(struct parallel_encoder *pe)
+{
+    size_t capacity = pe->pass_capacity ? pe->pass_capacity * 2 : 64;
+    struct pass *passes = realloc(pe->passes, capacity * sizeof(*passes));
+    if (passes == NULL) {
+        return false;
+    }
+    pe->passes = passes;
+
+    size_t *order = realloc(pe->order, capacity * sizeof(*order));
+    if (order == NULL) {
+        return false;
+    }
+    pe->order = order;
+
+    size_t *waiting = realloc(pe->waiting, capacity * sizeof(*waiting));
+    if (waiting == NULL) {
+        return false;
+    }
+    pe->waiting = waiting;
+
+    size_t *end = realloc(pe->dependents_first, capacity * sizeof(*end));
+    if (end == NULL) {
+        return false;
+    }
+    pe->dependents_first = end;
+    pe->pass_capacity  = capacity;
+    return true;
+}
+
+static bool grow_deps(struct parallel_encoder *pe, size_t needed)
+{
+    size_t capacity = pe->dep_capacity ? pe->dep_capacity : 64;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    int *deps = realloc(pe->deps, capacity * sizeof(*deps));
+    if (deps == NULL) {
+        return false;
+    }
+    pe->deps = deps;
+
+    size_t *dependents =
+            realloc(pe->dependents, capacity * sizeof(*dependents));
+    if (dependents == NULL) {
+        return false;
+    }
+    pe->dependents   = dependents;
+    pe->dep_capacity = capacity;
+    return true;
+}
+
+/* Kahn's algorithm over pe->order, seeded in id order so that independent
+ * passes keep the order they were added in. */
+static bool sort(struct parallel_encoder *pe)
+{
+    size_t n = pe->pass_count;
+    for (size_t i = 0; i < n; ++i) {
+        pe->dependents_first[i] = 0;
+    }
+    for (size_t i = 0; i < pe->dep_count; ++i) {
+        if (pe->deps[i] < 0 || ( size_t )pe->deps[i] >= n) {
+            return false;
+        }
+        ++pe->dependents_first[pe->deps[i]];
+    }
+    for (size_t i = 1; i < n; ++i) {
+        pe->dependents_first[i] += pe->dependents_first[i - 1];
+    }
+    /* Counted as list ends, then filled back to front, which leaves each
+     * pass's entry at the start of its list. */
+    for (size_t i = n; i-- > 0;) {
+        const struct pass *p = &pe->passes[i];
+        pe->waiting[i]       = p->dep_count;
+        for (size_t d = 0; d < p->dep_count; ++d) {
+            int dep = pe->deps[p->dep_first + d];
+            pe->dependents[--pe->dependents_first[dep]] = i;
+        }
+    }
+
+    size_t tail = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (pe->waiting[i] == 0) {
+            pe->order[tail++] = i;
+        }
+    }
+    for (size_t head = 0; head < tail; ++head) {
+        size_t done  = pe->order[head];
+        size_t first = pe->dependents_first[done];
+        size_t end   = done + 1 < n ? pe->dependents_first[done + 1]
+                                    : pe->dep_count;
+        for (size_t e = first; e < end; ++e) {
+            if (--pe->waiting[pe->dependents[e]] == 0) {
+                pe->order[tail++] = pe->dependents[e];
+            }
+        }
+    }
+    return tail == n;
+}
+
+/* Splits the order into one contiguous run per worker of about equal
+ * cost. */
+static void split(struct parallel_encoder *pe)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < pe->pass_count; ++i) {
+        total += pe->passes[i].cost;
+    }
+
+    size_t   next = 0;
+    uint64_t cost = 0;
+    for (size_t k = 0; k < pe->threads; ++k) {
+        struct worker *w = &pe->workers[k];
+        uint64_t target  = ( uint64_t )(( double )total * ( double )(k + 1) /
+                                        ( double )pe->threads);
+        w->first         = next;
+        while (next < pe->pass_count &&
+               (cost < target || k == pe->threads - 1)) {
+            cost += pe->passes[pe->order[next++]].cost;
+        }
+        w->count = next - w->first;
+    }
+}
+
+static void stop_workers(struct parallel_encoder *pe)
+{
+    pthread_mutex_lock(&pe->lock);
+    pe->stopping = true;
+    pthread_cond_broadcast(&pe->start);
+    pthread_mutex_unlock(&pe->lock);
+    for (size_t i = 0; i < pe->started; ++i) {
+        pthread_join(pe->workers[i].thread, NULL);
+    }
+}
+
+static void free_encoder(struct parallel_encoder *pe)
+{
+    pthread_mutex_destroy(&pe->lock);
+    pthread_cond_destroy(&pe->start);
+    pthread_cond_destroy(&pe->finished);
+    free(pe->passes);
+    free(pe->deps);
+    free(pe->order);
+    free(pe->waiting);
+    free(pe->dependents_first);
+    free(pe->dependents);
+    free(pe->workers);
+    free(pe->cmds);
+    free(pe);
+}
+
+struct parallel_encoder *
+parallel_encoder_create(const struct parallel_encoder_options *opts)
+{
+    if (!wgpuDeviceHasFeature(opts->device,
+                              WGPUFeatureName_ImplicitDeviceSynchronization)) {
+        return NULL;
+    }
+    struct parallel_encoder *pe = calloc(1, sizeof(*pe));
+    if (pe == NULL) {
+        return NULL;
+    }
+    pe->device  = opts->device;
+    pe->queue   = opts->queue;
+    pe->threads = opts->threads ? opts->threads : PARALLEL_THREADS_DEFAULT;
+    pthread_mutex_init(&pe->lock, NULL);
+    pthread_cond_init(&pe->start, NULL);
+    pthread_cond_init(&pe->finished, NULL);
+
+    pe->workers = calloc(pe->threads, sizeof(*pe->workers));
+    pe->cmds    = calloc(pe->threads, sizeof(*pe->cmds));
+    if (pe->workers == NULL || pe->cmds == NULL || !grow_passes(pe) ||
+        !grow_deps(pe, 0)) {
+        free_encoder(pe);
+        return NULL;
+    }
+    for (; pe->started < pe->threads; ++pe->started) {
+        struct worker *w = &pe->workers[pe->started];
+        w->pe            = pe;
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            stop_workers(pe);
+            free_encoder(pe);
+            return NULL;
+        }
+    }
+    wgpuDeviceAddRef(pe->device);
+    wgpuQueueAddRef(pe->queue);
+    return pe;
+}
+
+int parallel_encoder_add(struct parallel_encoder *pe, encode_fn fn,
+                         void *userdata, uint64_t cost, size_t dep_count,
+                         const int *deps)
+{
+    if ((pe->pass_count == pe->pass_capacity && !grow_passes(pe)) ||
+        (pe->dep_count + dep_count > pe->dep_capacity &&
+         !grow_deps(pe, pe->dep_count + dep_count))) {
+        return -1;
+    }
+    struct pass *p = &pe->passes[pe->pass_count];
+    p->fn          = fn;
+    p->userdata    = userdata;
+    p->cost        = cost ? cost : 1;
+    p->dep_first   = pe->dep_count;
+    p->dep_count   = dep_count;
+    for (size_t i = 0; i < dep_count; ++i) {
+        pe->deps[pe->dep_count++] = deps[i];
+    }
+    return ( int )pe->pass_count++;
+}
+
+bool parallel_encoder_run(struct parallel_encoder    *pe,
+                          struct parallel_encode_run *out)
+{
+    uint64_t start  = phase_now_ns();
+    size_t   passes = pe->pass_count;
+    bool     sorted = sort(pe);
+    if (!sorted || passes == 0) {
+        pe->pass_count = 0;
+        pe->dep_count  = 0;
+        if (out != NULL) {
+            *out = (struct parallel_encode_run){0};
+        }
+        return sorted;
+    }
+    split(pe);
+
+    pthread_mutex_lock(&pe->lock);
+    pe->busy = pe->threads;
+    ++pe->generation;
+    pthread_cond_broadcast(&pe->start);
+    while (pe->busy > 0) {
+        pthread_cond_wait(&pe->finished, &pe->lock);
+    }
+    pthread_mutex_unlock(&pe->lock);
+
+    size_t count = 0;
+    for (size_t i = 0; i < pe->threads; ++i) {
+        if (pe->workers[i].cmd != NULL) {
+            pe->cmds[count++] = pe->workers[i].cmd;
+        }
+    }
+    uint64_t recorded = phase_now_ns();
+    wgpuQueueSubmit(pe->queue, count, pe->cmds);
+    for (size_t i = 0; i < count; ++i) {
+        wgpuCommandBufferRelease(pe->cmds[i]);
+    }
+    uint64_t submitted = phase_now_ns();
+
+    pe->pass_count = 0;
+    pe->dep_count  = 0;
+    if (out != NULL) {
+        out->passes          = passes;
+        out->command_buffers = count;
+        out->record_ns       = recorded - start;
+        out->submit_ns       = submitted - recorded;
+    }
+    return true;
+}
+
+void parallel_encoder_destroy(struct parallel_encoder *pe)
+{
+    stop_workers(pe);
+    wgpuQueueRelease(pe->queue);
+    wgpuDeviceRelease(pe->device);
+    free_encoder(pe);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
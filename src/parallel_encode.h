@@ -0,0 +1,79 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_PARALLEL_ENCODE_H
+#define WGPU_PARALLEL_ENCODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define PARALLEL_THREADS_DEFAULT 4
+
+/* Records one pass, or any other commands, into the worker's encoder. It
+ * must not touch resources that another pass of the same run writes. */
+typedef void (*encode_fn)(WGPUCommandEncoder encoder, void *userdata);
+
+struct parallel_encoder_options {
+    /* Encoders are created and finished on the worker threads, so the
+     * device needs ImplicitDeviceSynchronization. */
+    WGPUDevice device;
+    WGPUQueue  queue;
+    size_t     threads;
+};
+
+/* Timings of one parallel_encoder_run. */
+struct parallel_encode_run {
+    size_t   passes;
+    size_t   command_buffers;
+    uint64_t record_ns; /* ordering, recording and finishing */
+    uint64_t submit_ns;
+};
+
+struct parallel_encoder;
+
+/* Starts the workers. Returns NULL on failure or when the device lacks
+ * ImplicitDeviceSynchronization. A parallel encoder is driven from one
+ * thread; only the recording fans out. */
+struct parallel_encoder *
+parallel_encoder_create(const struct parallel_encoder_options *opts);
+
+/* Adds a pass to the next run and returns its id, or -1 when out of memory.
+ * Ids count up from zero in every run. The pass is submitted after the
+ * dep_count passes listed in deps, which may also be added later in the
+ * same run. cost is its expected recording effort, used to balance the
+ * workers; zero counts as one. */
+int parallel_encoder_add(struct parallel_encoder *pe, encode_fn fn,
+                         void *userdata, uint64_t cost, size_t dep_count,
+                         const int *deps);
+
+/* Orders the passes by their dependencies and cuts that order into one
+ * contiguous run of passes per worker. Each worker records its run into its
+ * own encoder and finishes it, then the command buffers go out in order as a
+ * single wgpuQueueSubmit. The passes are cleared either way. Returns false,
+ * without recording anything, on an unknown dependency or a cycle. out may
+ * be NULL. */
+bool parallel_encoder_run(struct parallel_encoder    *pe,
+                          struct parallel_encode_run *out);
+
+void parallel_encoder_destroy(struct parallel_encoder *pe);
+
+#endif /* ifndef WGPU_PARALLEL_ENCODE_H */
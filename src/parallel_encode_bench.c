@@ -0,0 +1,267 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <dawn/webgpu.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "feature_names.h"
+#include "parallel_encode.h"
+#include "phase.h"
+#include "writer.h"
+
+#define COPIES_PER_PASS 64
+#define COPY_SIZE       256
+#define REGION_SIZE     (COPIES_PER_PASS * COPY_SIZE)
+#define CHAIN_LENGTH    8
+
+struct bench {
+    struct acquire acq;
+    WGPUBuffer     src;
+    WGPUBuffer     dst;
+    long           passes;
+    long           iterations;
+};
+
+/* Enough small commands that recording, not the submit, dominates. */
+struct pass {
+    struct bench *b;
+    uint64_t      offset;
+};
+
+static void work_done(WGPUQueueWorkDoneStatus status, void *userdata1,
+                      void *userdata2)
+{
+    (void)status;
+    (void)userdata1;
+    (void)userdata2;
+}
+
+static void wait_idle(struct bench *b)
+{
+    WGPUQueueWorkDoneCallbackInfo info =
+            WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+    info.mode     = WGPUCallbackMode_WaitAnyOnly;
+    info.callback = work_done;
+
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future             = wgpuQueueOnSubmittedWorkDone(b->acq.queue, info);
+    wgpuInstanceWaitAny(b->acq.instance, 1, &wait, UINT64_MAX);
+}
+
+static void encode_pass(WGPUCommandEncoder encoder, void *userdata)
+{
+    const struct pass *p = userdata;
+    wgpuCommandEncoderClearBuffer(encoder, p->b->dst, p->offset, REGION_SIZE);
+    for (uint64_t i = 0; i < COPIES_PER_PASS; ++i) {
+        wgpuCommandEncoderCopyBufferToBuffer(
+                encoder, p->b->src, p->offset + i * COPY_SIZE, p->b->dst,
+                p->offset + (COPIES_PER_PASS - 1 - i) * COPY_SIZE, COPY_SIZE);
+    }
+}
+
+static WGPUBuffer create_buffer(struct bench *b, WGPUBufferUsage usage)
+{
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.usage                = usage;
+    desc.size                 = ( uint64_t )b->passes * REGION_SIZE;
+    return wgpuDeviceCreateBuffer(b->acq.device, &desc);
+}
+
+/* Passes form chains of CHAIN_LENGTH, so the sequencer has an order to keep
+ * while the chains themselves spread over the workers. */
+static bool measure(struct bench *b, struct pass *passes, size_t threads,
+                    struct phase_profile *p, size_t *command_buffers)
+{
+    struct parallel_encoder_options opts = {
+            .device  = b->acq.device,
+            .queue   = b->acq.queue,
+            .threads = threads,
+    };
+    struct parallel_encoder *pe = parallel_encoder_create(&opts);
+    if (pe == NULL || !phase_init(p, ( size_t )b->iterations)) {
+        if (pe != NULL) {
+            parallel_encoder_destroy(pe);
+        }
+        return false;
+    }
+    int record = phase_define(p, "record");
+    int submit = phase_define(p, "submit");
+    int total  = phase_define(p, "total");
+
+    bool ok = true;
+    for (long i = 0; i < b->iterations && ok; ++i) {
+        for (long j = 0; j < b->passes && ok; ++j) {
+            int dep = ( int )j - 1;
+            ok      = parallel_encoder_add(pe, encode_pass, &passes[j],
+                                           COPIES_PER_PASS,
+                                           j % CHAIN_LENGTH ? 1 : 0,
+                                           &dep) >= 0;
+        }
+        struct parallel_encode_run run;
+        if (!ok || !parallel_encoder_run(pe, &run)) {
+            ok = false;
+            break;
+        }
+        wait_idle(b);
+        phase_record(p, record, run.record_ns);
+        phase_record(p, submit, run.submit_ns);
+        phase_record(p, total, run.record_ns + run.submit_ns);
+        phase_next_run(p);
+        *command_buffers = run.command_buffers;
+    }
+    parallel_encoder_destroy(pe);
+    if (!ok) {
+        phase_free(p);
+    }
+    return ok;
+}
+
+static bool acquire_device(struct bench *b)
+{
+    /* The adapter is probed first so a missing feature is reported by
+     * name rather than as a failed device request. */
+    if (!acquire_init(&b->acq)) {
+        fprintf(stderr, "%s\n", b->acq.message);
+        return false;
+    }
+    WGPURequestAdapterOptions options = {0};
+    acquire_begin(&b->acq, &(struct acquire_options){.adapter = &options});
+    struct adapter_caps caps;
+    if (acquire_wait(&b->acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        !caps_query(b->acq.adapter, &caps)) {
+        fprintf(stderr, "%s\n", b->acq.message);
+        acquire_release(&b->acq);
+        return false;
+    }
+    WGPUFeatureName sync = WGPUFeatureName_ImplicitDeviceSynchronization;
+    bool            has  = caps_has_feature(&caps, sync);
+    caps_free(&caps);
+    acquire_release(&b->acq);
+    if (!has) {
+        fprintf(stderr, "Adapter lacks %s\n", feature_name(sync));
+        return false;
+    }
+
+    WGPUDeviceDescriptor device = WGPU_DEVICE_DESCRIPTOR_INIT;
+    device.requiredFeatureCount = 1;
+    device.requiredFeatures     = &sync;
+    if (!acquire_init(&b->acq)) {
+        fprintf(stderr, "%s\n", b->acq.message);
+        return false;
+    }
+    acquire_begin(&b->acq, &(struct acquire_options){.adapter = &options,
+                                                     .device  = &device,
+                                                     .request_device = true});
+    if (acquire_wait(&b->acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS) {
+        fprintf(stderr, "%s\n", b->acq.message);
+        acquire_release(&b->acq);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    long passes      = argc > 1 ? strtol(argv[1], NULL, 10) : 1024;
+    long max_threads = argc > 2 ? strtol(argv[2], NULL, 10) : 8;
+    long iterations  = argc > 3 ? strtol(argv[3], NULL, 10) : 32;
+    if (passes <= 0 || passes > INT32_MAX || max_threads <= 0 ||
+        iterations <= 0) {
+        fprintf(stderr, "Usage: %s [PASSES [MAX_THREADS [ITERATIONS]]]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct bench b = {.passes = passes, .iterations = iterations};
+    if (!acquire_device(&b)) {
+        return EXIT_FAILURE;
+    }
+    b.src = create_buffer(&b, WGPUBufferUsage_CopySrc);
+    b.dst = create_buffer(&b, WGPUBufferUsage_CopyDst);
+    struct pass *list = calloc(( size_t )passes, sizeof(*list));
+    if (list == NULL) {
+        fprintf(stderr, "Unable to allocate %ld passes\n", passes);
+        wgpuBufferRelease(b.src);
+        wgpuBufferRelease(b.dst);
+        acquire_release(&b.acq);
+        return EXIT_FAILURE;
+    }
+    for (long i = 0; i < passes; ++i) {
+        list[i].b      = &b;
+        list[i].offset = ( uint64_t )i * REGION_SIZE;
+    }
+
+    /* One JSON line per thread count, doubling up to MAX_THREADS. */
+    static struct writer out;
+    uint64_t             baseline = 0;
+    bool                 ok       = true;
+    for (long threads = 1; ok; threads *= 2) {
+        if (threads > max_threads) {
+            if (threads / 2 == max_threads) {
+                break;
+            }
+            threads = max_threads;
+        }
+        struct phase_profile p;
+        size_t               command_buffers = 0;
+        if (!measure(&b, list, ( size_t )threads, &p, &command_buffers)) {
+            fprintf(stderr, "Parallel encoding failed with %ld threads\n",
+                    threads);
+            ok = false;
+            break;
+        }
+        /* Phase 0 is the recording, which is what the workers speed up. */
+        uint64_t median = phase_percentile(&p, 0, 50);
+        if (baseline == 0) {
+            baseline = median;
+        }
+        char speedup[32];
+        snprintf(speedup, sizeof(speedup), "%.2f",
+                 median ? ( double )baseline / ( double )median : 0.0);
+
+        writer_init(&out, STDOUT_FILENO);
+        writer_str(&out, "{\"threads\":");
+        writer_u64(&out, ( uint64_t )threads);
+        writer_str(&out, ",\"passes\":");
+        writer_u64(&out, ( uint64_t )passes);
+        writer_str(&out, ",\"command_buffers\":");
+        writer_u64(&out, command_buffers);
+        writer_str(&out, ",\"record_speedup\":");
+        writer_str(&out, speedup);
+        writer_str(&out, ",\"profile\":");
+        phase_json(&out, &p);
+        writer_str(&out, "}\n");
+        ok = writer_flush(&out);
+        phase_free(&p);
+    }
+
+    free(list);
+    wgpuBufferRelease(b.src);
+    wgpuBufferRelease(b.dst);
+    acquire_release(&b.acq);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
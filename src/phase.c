@@ -0,0 +1,186 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "phase.h"
+
+uint64_t phase_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ( uint64_t )ts.tv_sec * 1000000000ull + ( uint64_t )ts.tv_nsec;
+}
+
+bool phase_init(struct phase_profile *p, size_t runs)
+{
+    memset(p, 0, sizeof(*p));
+    p->samples = calloc(runs ? runs : 1, PHASE_MAX * sizeof(uint64_t));
+    if (p->samples == NULL) {
+        return false;
+    }
+    p->run_capacity = runs ? runs : 1;
+    return true;
+}
+
+void phase_free(struct phase_profile *p)
+{
+    free(p->samples);
+    memset(p, 0, sizeof(*p));
+}
+
+int phase_define(struct phase_profile *p, const char *name)
+{
+    if (p->phase_count == PHASE_MAX) {
+        return -1;
+    }
+    p->names[p->phase_count] = name;
+    return ( int )p->phase_count++;
+}
+
+/* Only ids phase_define() handed out; -1 from a full profile included. */
+static bool defined(const struct phase_profile *p, int phase)
+{
+    return phase >= 0 && ( size_t )phase < p->phase_count;
+}
+
+static uint64_t *row(struct phase_profile *p)
+{
+    return p->samples + p->run_count * PHASE_MAX;
+}
+
+void phase_begin(struct phase_profile *p, int phase)
+{
+    if (defined(p, phase)) {
+        p->started[phase] = phase_now_ns();
+    }
+}
+
+void phase_end(struct phase_profile *p, int phase)
+{
+    if (defined(p, phase)) {
+        phase_record(p, phase, phase_now_ns() - p->started[phase]);
+    }
+}
+
+void phase_record(struct phase_profile *p, int phase, uint64_t ns)
+{
+    if (defined(p, phase) && p->run_count < p->run_capacity) {
+        row(p)[phase] = ns;
+    }
+}
+
+bool phase_next_run(struct phase_profile *p)
+{
+    if (p->run_count < p->run_capacity) {
+        ++p->run_count;
+    }
+    return p->run_count < p->run_capacity;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *( const uint64_t * )a;
+    uint64_t y = *( const uint64_t * )b;
+    return (x > y) - (x < y);
+}
+
+/* Sorted copy of one column; the caller frees it. */
+static uint64_t *sorted_column(const struct phase_profile *p, int phase)
+{
+    uint64_t *column = malloc((p->run_count ? p->run_count : 1) *
+                              sizeof(uint64_t));
+    if (column == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < p->run_count; ++i) {
+        column[i] = p->samples[i * PHASE_MAX + phase];
+    }
+    qsort(column, p->run_count, sizeof(uint64_t), compare_u64);
+    return column;
+}
+
+static uint64_t rank(const uint64_t *sorted, size_t count, double percentile)
+{
+    if (count == 0) {
+        return 0;
+    }
+    size_t index = ( size_t )(percentile / 100.0 * count + 0.999999);
+    index        = index == 0 ? 0 : index - 1;
+    return sorted[index < count ? index : count - 1];
+}
+
+uint64_t phase_percentile(const struct phase_profile *p, int phase,
+                          double percentile)
+{
+    if (!defined(p, phase)) {
+        return 0;
+    }
+    uint64_t *sorted = sorted_column(p, phase);
+    if (sorted == NULL) {
+        return 0;
+    }
+    uint64_t value = rank(sorted, p->run_count, percentile);
+    free(sorted);
+    return value;
+}
+
+void phase_json(struct writer *w, const struct phase_profile *p)
+{
+    static const struct {
+        const char *key;
+        double      percentile;
+    } stats[] = {
+            {"min", 0.0},  {"p50", 50.0}, {"p90", 90.0},
+            {"p99", 99.0}, {"max", 100.0},
+    };
+
+    writer_str(w, "{\"unit\":\"ns\",\"runs\":");
+    writer_u64(w, p->run_count);
+    writer_str(w, ",\"phases\":[");
+    for (size_t i = 0; i < p->phase_count; ++i) {
+        uint64_t *sorted = sorted_column(p, ( int )i);
+        uint64_t  total  = 0;
+        for (size_t r = 0; sorted != NULL && r < p->run_count; ++r) {
+            total += sorted[r];
+        }
+
+        writer_str(w, i ? ",{\"name\":" : "{\"name\":");
+        writer_json_string(w, p->names[i], strlen(p->names[i]));
+        for (size_t s = 0; s < sizeof(stats) / sizeof(stats[0]); ++s) {
+            writer_str(w, ",\"");
+            writer_str(w, stats[s].key);
+            writer_str(w, "\":");
+            writer_u64(w, sorted ? rank(sorted, p->run_count,
+                                        stats[s].percentile)
+                                 : 0);
+        }
+        writer_str(w, ",\"mean\":");
+        writer_u64(w, p->run_count ? total / p->run_count : 0);
+        writer_str(w, "}");
+        free(sorted);
+    }
+    writer_str(w, "]}\n");
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,78 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_PHASE_H
+#define WGPU_PHASE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHASE_MAX 8
+
+/* Per-phase latency samples over repeated runs. Phases are registered once
+ * with phase_define() and every run fills one row of samples, either through
+ * phase_begin()/phase_end() or from timestamps taken elsewhere. */
+struct phase_profile {
+    size_t      phase_count;
+    const char *names[PHASE_MAX];
+    uint64_t    started[PHASE_MAX];
+
+    size_t    run_count;
+    size_t    run_capacity;
+    uint64_t *samples; /* run_capacity rows of PHASE_MAX nanoseconds */
+};
+
+/* Monotonic clock in nanoseconds, shared by everything that reports
+ * latency so samples from different modules are comparable. */
+uint64_t phase_now_ns(void);
+
+bool phase_init(struct phase_profile *p, size_t runs);
+void phase_free(struct phase_profile *p);
+
+/* Returns the phase id, or -1 once PHASE_MAX phases exist. */
+int phase_define(struct phase_profile *p, const char *name);
+
+/* Ids phase_define() did not return, -1 included, are ignored. */
+void phase_begin(struct phase_profile *p, int phase);
+void phase_end(struct phase_profile *p, int phase);
+void phase_record(struct phase_profile *p, int phase, uint64_t ns);
+
+/* Closes the current row; returns false once run_capacity rows exist. */
+bool phase_next_run(struct phase_profile *p);
+
+/* Nearest-rank percentile (0-100) of one phase over the recorded runs, 0
+ * for an undefined phase. */
+uint64_t phase_percentile(const struct phase_profile *p, int phase,
+                          double percentile);
+
+/* {"unit":"ns","runs":N,"phases":[{"name":..,"min":..,"p50":..,...}]} */
+void phase_json(struct writer *w, const struct phase_profile *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_PHASE_H */
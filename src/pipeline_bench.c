@@ -0,0 +1,171 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dawn/webgpu.h>
+
+#include "acquire.h"
+#include "phase.h"
+#include "pipeline_service.h"
+
+/* One override per pipeline makes every compile distinct, so Dawn's own
+ * pipeline cache doesn't hide the cost being measured. */
+static const char shader[] =
+        "override salt: f32 = 0.0;\n"
+        "@group(0) @binding(0) var<storage, read_write> data: array<f32>;\n"
+        "@compute @workgroup_size(64)\n"
+        "fn main(@builtin(global_invocation_id) id: vec3u) {\n"
+        "    data[id.x] = data[id.x] * salt + sin(f32(id.x) + salt);\n"
+        "}\n";
+
+struct request {
+    WGPUConstantEntry             constant;
+    WGPUComputePipelineDescriptor desc;
+};
+
+static void fill(struct request *req, WGPUShaderModule module, double salt)
+{
+    WGPUConstantEntry constant = WGPU_CONSTANT_ENTRY_INIT;
+    constant.key   = (WGPUStringView){.data = "salt", .length = 4};
+    constant.value = salt;
+    req->constant  = constant;
+
+    WGPUComputePipelineDescriptor desc = WGPU_COMPUTE_PIPELINE_DESCRIPTOR_INIT;
+    desc.compute.module                = module;
+    desc.compute.entryPoint = (WGPUStringView){.data = "main", .length = 4};
+    desc.compute.constantCount = 1;
+    desc.compute.constants     = &req->constant;
+    req->desc                  = desc;
+}
+
+static double ms(uint64_t ns)
+{
+    return ( double )ns / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    long count = argc > 1 ? strtol(argv[1], NULL, 10) : 64;
+    long width = argc > 2 ? strtol(argv[2], NULL, 10) : 4;
+    if (count <= 0 || width <= 0) {
+        fprintf(stderr, "Usage: %s [COUNT [IN_FLIGHT]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct acquire acq;
+    if (!acquire_init(&acq)) {
+        fprintf(stderr, "%s\n", acq.message);
+        return EXIT_FAILURE;
+    }
+    WGPURequestAdapterOptions options = {0};
+    acquire_begin(&acq, &(struct acquire_options){.adapter        = &options,
+                                                  .request_device = true});
+    if (acquire_wait(&acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS) {
+        fprintf(stderr, "%s\n", acq.message);
+        acquire_release(&acq);
+        return EXIT_FAILURE;
+    }
+
+    WGPUShaderSourceWGSL wgsl = WGPU_SHADER_SOURCE_WGSL_INIT;
+    wgsl.code = (WGPUStringView){.data = shader, .length = sizeof(shader) - 1};
+    WGPUShaderModuleDescriptor module_desc = WGPU_SHADER_MODULE_DESCRIPTOR_INIT;
+    module_desc.nextInChain                = &wgsl.chain;
+    WGPUShaderModule module =
+            wgpuDeviceCreateShaderModule(acq.device, &module_desc);
+
+    /* count background compiles followed by one critical one, first done
+     * synchronously and then through the service with fresh constants. */
+    struct request *reqs = calloc(2 * (count + 1), sizeof(*reqs));
+    if (reqs == NULL) {
+        fprintf(stderr, "Unable to allocate %ld requests\n", count);
+        return EXIT_FAILURE;
+    }
+    for (long i = 0; i < 2 * (count + 1); ++i) {
+        fill(&reqs[i], module, ( double )i + 1);
+    }
+
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i <= count; ++i) {
+        wgpuComputePipelineRelease(
+                wgpuDeviceCreateComputePipeline(acq.device, &reqs[i].desc));
+    }
+    /* Synchronously the critical compile waits behind every other one. */
+    uint64_t sync_total = phase_now_ns() - start;
+
+    struct pipeline_service_options svc_opts = {
+            .instance      = acq.instance,
+            .device        = acq.device,
+            .max_in_flight = ( size_t )width,
+    };
+    struct pipeline_service *svc = pipeline_service_create(&svc_opts);
+    struct pipeline_future **futures =
+            calloc(( size_t )count + 1, sizeof(*futures));
+    if (svc == NULL || futures == NULL) {
+        fprintf(stderr, "Unable to start the pipeline service\n");
+        return EXIT_FAILURE;
+    }
+
+    struct request *service_reqs = reqs + count + 1;
+    start                        = phase_now_ns();
+    for (long i = 0; i < count; ++i) {
+        futures[i] = pipeline_service_compute(svc, &service_reqs[i].desc,
+                                              PIPELINE_PRIORITY_BACKGROUND);
+    }
+    uint64_t critical_start = phase_now_ns();
+    futures[count] = pipeline_service_compute(svc, &service_reqs[count].desc,
+                                              PIPELINE_PRIORITY_CRITICAL);
+
+    bool     ok       = true;
+    uint64_t critical = 0;
+    for (long i = count; i >= 0; --i) {
+        struct pipeline_result result;
+        if (futures[i] == NULL ||
+            !pipeline_future_wait(futures[i], PIPELINE_WAIT_FOREVER, &result)) {
+            ok = false;
+            continue;
+        }
+        if (i == count) {
+            critical = phase_now_ns() - critical_start;
+        }
+        if (result.compute) {
+            wgpuComputePipelineRelease(result.compute);
+        }
+        pipeline_future_release(futures[i]);
+        ok = ok && result.status == WGPUCreatePipelineAsyncStatus_Success;
+    }
+    uint64_t service_total = phase_now_ns() - start;
+
+    printf("{\"count\":%ld,\"in_flight\":%ld,"
+           "\"sync\":{\"total_ms\":%.3f,\"critical_ms\":%.3f},"
+           "\"service\":{\"total_ms\":%.3f,\"critical_ms\":%.3f}}\n",
+           count, width, ms(sync_total), ms(sync_total), ms(service_total),
+           ms(critical));
+
+    pipeline_service_destroy(svc);
+    free(futures);
+    free(reqs);
+    wgpuShaderModuleRelease(module);
+    acquire_release(&acq);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
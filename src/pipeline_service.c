@@ -0,0 +1,637 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "key.h"
+#include "pipeline_service.h"
+
+#define POLL_INTERVAL_DEFAULT (1000ull * 1000)
+#define PENDING_BUCKETS       256
+
+enum job_kind {
+    JOB_COMPUTE,
+    JOB_RENDER,
+};
+
+enum job_state {
+    JOB_QUEUED,
+    JOB_IN_FLIGHT,
+    JOB_DONE,
+};
+
+/* One compile, shared by every request merged into it. The service holds a
+ * reference until the compile completes and each submitter holds one. */
+struct pipeline_future {
+    _Atomic unsigned refs;
+    enum job_kind    kind;
+    union {
+        const WGPUComputePipelineDescriptor *compute;
+        const WGPURenderPipelineDescriptor  *render;
+    } desc;
+
+    /* Guarded by the service lock. */
+    enum job_state          state;
+    int                     priority;
+    uint64_t                seq;
+    size_t                  heap_index;
+    struct key              key;
+    uint64_t                hash;
+    struct pipeline_future *next_pending;
+
+    /* Only touched by the service thread. */
+    WGPUFuture future;
+
+    pthread_mutex_t        lock;
+    pthread_cond_t         done;
+    bool                   ready;
+    struct pipeline_result result;
+};
+
+struct pipeline_service {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    size_t       max_in_flight;
+    size_t       wait_chunk;
+    uint64_t     interval_ns;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_t       thread;
+    bool            stopping;
+    uint64_t        seq;
+
+    struct pipeline_future **heap;
+    size_t                   queued;
+    size_t                   heap_capacity;
+
+    struct pipeline_future **in_flight;
+    size_t                   in_flight_count;
+    WGPUFutureWaitInfo      *waits;
+
+    struct pipeline_future *pending[PENDING_BUCKETS];
+
+    struct pipeline_service_stats stats;
+};
+
+static struct timespec deadline_after(uint64_t ns)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ns += ( uint64_t )ts.tv_nsec;
+    ts.tv_sec += ( time_t )(ns / 1000000000ull);
+    ts.tv_nsec = ( long )(ns % 1000000000ull);
+    return ts;
+}
+
+static void job_release(struct pipeline_future *job)
+{
+    if (atomic_fetch_sub(&job->refs, 1) != 1) {
+        return;
+    }
+    if (job->result.compute) {
+        wgpuComputePipelineRelease(job->result.compute);
+    }
+    if (job->result.render) {
+        wgpuRenderPipelineRelease(job->result.render);
+    }
+    key_free(&job->key);
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->done);
+    free(job);
+}
+
+/* Publishes the result and drops the service's reference. */
+static void job_complete(struct pipeline_future       *job,
+                         WGPUCreatePipelineAsyncStatus status,
+                         WGPUStringView                message)
+{
+    pthread_mutex_lock(&job->lock);
+    size_t length = message.length == WGPU_STRLEN
+                            ? (message.data ? strlen(message.data) : 0)
+                            : message.length;
+    job->result.status = status;
+    snprintf(job->result.message, sizeof(job->result.message), "%.*s",
+             ( int )length, message.data ? message.data : "");
+    job->ready = true;
+    pthread_cond_broadcast(&job->done);
+    pthread_mutex_unlock(&job->lock);
+    job_release(job);
+}
+
+static bool heap_before(const struct pipeline_future *a,
+                        const struct pipeline_future *b)
+{
+    return a->priority != b->priority ? a->priority > b->priority
+                                      : a->seq < b->seq;
+}
+
+static void heap_place(struct pipeline_service *svc, size_t i,
+                       struct pipeline_future *job)
+{
+    svc->heap[i]    = job;
+    job->heap_index = i;
+}
+
+static void heap_up(struct pipeline_service *svc, size_t i)
+{
+    struct pipeline_future *job = svc->heap[i];
+    while (i > 0 && heap_before(job, svc->heap[(i - 1) / 2])) {
+        heap_place(svc, i, svc->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    heap_place(svc, i, job);
+}
+
+static struct pipeline_future *heap_pop(struct pipeline_service *svc)
+{
+    struct pipeline_future *top  = svc->heap[0];
+    struct pipeline_future *last = svc->heap[--svc->queued];
+    size_t                  i    = 0;
+    while (svc->queued > 0) {
+        size_t child = 2 * i + 1;
+        if (child >= svc->queued) {
+            break;
+        }
+        if (child + 1 < svc->queued &&
+            heap_before(svc->heap[child + 1], svc->heap[child])) {
+            ++child;
+        }
+        if (!heap_before(svc->heap[child], last)) {
+            break;
+        }
+        heap_place(svc, i, svc->heap[child]);
+        i = child;
+    }
+    if (svc->queued > 0) {
+        heap_place(svc, i, last);
+    }
+    return top;
+}
+
+static bool grow_heap(struct pipeline_service *svc)
+{
+    size_t capacity = svc->heap_capacity ? svc->heap_capacity * 2 : 64;
+    struct pipeline_future **heap =
+            realloc(svc->heap, capacity * sizeof(*svc->heap));
+    if (heap == NULL) {
+        return false;
+    }
+    svc->heap          = heap;
+    svc->heap_capacity = capacity;
+    return true;
+}
+
+static void unlink_pending(struct pipeline_service *svc,
+                           struct pipeline_future  *job)
+{
+    if (job->key.failed) {
+        return;
+    }
+    struct pipeline_future **link = &svc->pending[job->hash % PENDING_BUCKETS];
+    while (*link != job) {
+        link = &(*link)->next_pending;
+    }
+    *link = job->next_pending;
+}
+
+/* Runs inside WaitAny on the service thread, with the lock released. */
+static void finish(struct pipeline_service *svc, struct pipeline_future *job,
+                   WGPUCreatePipelineAsyncStatus status, WGPUStringView message)
+{
+    pthread_mutex_lock(&svc->lock);
+    for (size_t i = 0; i < svc->in_flight_count; ++i) {
+        if (svc->in_flight[i] == job) {
+            svc->in_flight[i] = svc->in_flight[--svc->in_flight_count];
+            break;
+        }
+    }
+    unlink_pending(svc, job);
+    job->state = JOB_DONE;
+    if (status == WGPUCreatePipelineAsyncStatus_Success) {
+        ++svc->stats.compiled;
+    } else {
+        ++svc->stats.failed;
+    }
+    pthread_mutex_unlock(&svc->lock);
+    job_complete(job, status, message);
+}
+
+static void compute_callback(WGPUCreatePipelineAsyncStatus status,
+                             WGPUComputePipeline           pipeline,
+                             WGPUStringView message, void *userdata1,
+                             void *userdata2)
+{
+    struct pipeline_future *job = userdata1;
+    job->result.compute         = pipeline;
+    finish(userdata2, job, status, message);
+}
+
+static void render_callback(WGPUCreatePipelineAsyncStatus status,
+                            WGPURenderPipeline            pipeline,
+                            WGPUStringView message, void *userdata1,
+                            void *userdata2)
+{
+    struct pipeline_future *job = userdata1;
+    job->result.render          = pipeline;
+    finish(userdata2, job, status, message);
+}
+
+static WGPUFuture issue(struct pipeline_service *svc,
+                        struct pipeline_future  *job)
+{
+    if (job->kind == JOB_COMPUTE) {
+        WGPUCreateComputePipelineAsyncCallbackInfo info =
+                WGPU_CREATE_COMPUTE_PIPELINE_ASYNC_CALLBACK_INFO_INIT;
+        info.mode      = WGPUCallbackMode_WaitAnyOnly;
+        info.callback  = compute_callback;
+        info.userdata1 = job;
+        info.userdata2 = svc;
+        return wgpuDeviceCreateComputePipelineAsync(svc->device,
+                                                    job->desc.compute, info);
+    }
+    WGPUCreateRenderPipelineAsyncCallbackInfo info =
+            WGPU_CREATE_RENDER_PIPELINE_ASYNC_CALLBACK_INFO_INIT;
+    info.mode      = WGPUCallbackMode_WaitAnyOnly;
+    info.callback  = render_callback;
+    info.userdata1 = job;
+    info.userdata2 = svc;
+    return wgpuDeviceCreateRenderPipelineAsync(svc->device, job->desc.render,
+                                               info);
+}
+
+/* Only this thread talks to the device, so submitters never race Dawn and
+ * every callback fires here. */
+static void *service_main(void *arg)
+{
+    struct pipeline_service *svc = arg;
+
+    pthread_mutex_lock(&svc->lock);
+    for (;;) {
+        while (svc->queued > 0 && svc->in_flight_count < svc->max_in_flight) {
+            struct pipeline_future *job            = heap_pop(svc);
+            job->state                             = JOB_IN_FLIGHT;
+            svc->in_flight[svc->in_flight_count++] = job;
+            pthread_mutex_unlock(&svc->lock);
+            job->future = issue(svc, job);
+            pthread_mutex_lock(&svc->lock);
+        }
+        if (svc->stopping && svc->in_flight_count == 0) {
+            break;
+        }
+        if (svc->in_flight_count == 0) {
+            pthread_cond_wait(&svc->wake, &svc->lock);
+            continue;
+        }
+
+        size_t count = svc->in_flight_count;
+        for (size_t i = 0; i < count; ++i) {
+            svc->waits[i].future    = svc->in_flight[i]->future;
+            svc->waits[i].completed = false;
+        }
+        pthread_mutex_unlock(&svc->lock);
+
+        size_t chunks = (count + svc->wait_chunk - 1) / svc->wait_chunk;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t first = c * svc->wait_chunk;
+            size_t n     = count - first < svc->wait_chunk ? count - first
+                                                           : svc->wait_chunk;
+            wgpuInstanceWaitAny(svc->instance, n, svc->waits + first,
+                                svc->interval_ns / chunks);
+        }
+
+        pthread_mutex_lock(&svc->lock);
+    }
+    pthread_mutex_unlock(&svc->lock);
+    return NULL;
+}
+
+static void key_constants(struct key *key, size_t count,
+                          const WGPUConstantEntry *constants)
+{
+    key_u64(key, count);
+    for (size_t i = 0; i < count; ++i) {
+        key_no_chain(key, constants[i].nextInChain);
+        key_string(key, constants[i].key);
+        key_f64(key, constants[i].value);
+    }
+}
+
+/* The label is left out: it doesn't change what gets compiled. */
+static void key_compute(struct key                          *key,
+                        const WGPUComputePipelineDescriptor *desc)
+{
+    key_no_chain(key, desc->nextInChain);
+    key_ptr(key, desc->layout);
+    key_no_chain(key, desc->compute.nextInChain);
+    key_ptr(key, desc->compute.module);
+    key_string(key, desc->compute.entryPoint);
+    key_constants(key, desc->compute.constantCount, desc->compute.constants);
+}
+
+static void key_render(struct key                         *key,
+                       const WGPURenderPipelineDescriptor *desc)
+{
+    key_no_chain(key, desc->nextInChain);
+    key_ptr(key, desc->layout);
+
+    const WGPUVertexState *vertex = &desc->vertex;
+    key_no_chain(key, vertex->nextInChain);
+    key_ptr(key, vertex->module);
+    key_string(key, vertex->entryPoint);
+    key_constants(key, vertex->constantCount, vertex->constants);
+    key_u64(key, vertex->bufferCount);
+    for (size_t i = 0; i < vertex->bufferCount; ++i) {
+        const WGPUVertexBufferLayout *buffer = &vertex->buffers[i];
+        key_no_chain(key, buffer->nextInChain);
+        key_u32(key, buffer->stepMode);
+        key_u64(key, buffer->arrayStride);
+        key_u64(key, buffer->attributeCount);
+        for (size_t j = 0; j < buffer->attributeCount; ++j) {
+            const WGPUVertexAttribute *attribute = &buffer->attributes[j];
+            key_no_chain(key, attribute->nextInChain);
+            key_u32(key, attribute->format);
+            key_u64(key, attribute->offset);
+            key_u32(key, attribute->shaderLocation);
+        }
+    }
+
+    const WGPUPrimitiveState *primitive = &desc->primitive;
+    key_no_chain(key, primitive->nextInChain);
+    key_u32(key, primitive->topology);
+    key_u32(key, primitive->stripIndexFormat);
+    key_u32(key, primitive->frontFace);
+    key_u32(key, primitive->cullMode);
+    key_u32(key, primitive->unclippedDepth);
+
+    const WGPUDepthStencilState *depth = desc->depthStencil;
+    key_u32(key, depth != NULL);
+    if (depth != NULL) {
+        key_no_chain(key, depth->nextInChain);
+        key_u32(key, depth->format);
+        key_u32(key, depth->depthWriteEnabled);
+        key_u32(key, depth->depthCompare);
+        key_bytes(key, &depth->stencilFront, sizeof(depth->stencilFront));
+        key_bytes(key, &depth->stencilBack, sizeof(depth->stencilBack));
+        key_u32(key, depth->stencilReadMask);
+        key_u32(key, depth->stencilWriteMask);
+        key_bytes(key, &depth->depthBias, sizeof(depth->depthBias));
+        key_bytes(key, &depth->depthBiasSlopeScale,
+                  sizeof(depth->depthBiasSlopeScale));
+        key_bytes(key, &depth->depthBiasClamp, sizeof(depth->depthBiasClamp));
+    }
+
+    key_no_chain(key, desc->multisample.nextInChain);
+    key_u32(key, desc->multisample.count);
+    key_u32(key, desc->multisample.mask);
+    key_u32(key, desc->multisample.alphaToCoverageEnabled);
+
+    const WGPUFragmentState *fragment = desc->fragment;
+    key_u32(key, fragment != NULL);
+    if (fragment != NULL) {
+        key_no_chain(key, fragment->nextInChain);
+        key_ptr(key, fragment->module);
+        key_string(key, fragment->entryPoint);
+        key_constants(key, fragment->constantCount, fragment->constants);
+        key_u64(key, fragment->targetCount);
+        for (size_t i = 0; i < fragment->targetCount; ++i) {
+            const WGPUColorTargetState *target = &fragment->targets[i];
+            key_no_chain(key, target->nextInChain);
+            key_u32(key, target->format);
+            key_u32(key, target->blend != NULL);
+            if (target->blend != NULL) {
+                key_bytes(key, target->blend, sizeof(*target->blend));
+            }
+            key_u64(key, target->writeMask);
+        }
+    }
+}
+
+struct pipeline_service *
+pipeline_service_create(const struct pipeline_service_options *opts)
+{
+    struct pipeline_service *svc = calloc(1, sizeof(*svc));
+    if (svc == NULL) {
+        return NULL;
+    }
+    svc->instance      = opts->instance;
+    svc->device        = opts->device;
+    svc->max_in_flight = opts->max_in_flight ? opts->max_in_flight
+                                             : PIPELINE_IN_FLIGHT_DEFAULT;
+    svc->interval_ns   = opts->poll_interval_ns ? opts->poll_interval_ns
+                                                : POLL_INTERVAL_DEFAULT;
+
+    WGPUInstanceCapabilities caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    wgpuGetInstanceCapabilities(&caps);
+    svc->wait_chunk = caps.timedWaitAnyMaxCount;
+    if (svc->wait_chunk == 0 || svc->wait_chunk > svc->max_in_flight) {
+        svc->wait_chunk = svc->max_in_flight;
+    }
+
+    svc->in_flight = calloc(svc->max_in_flight, sizeof(*svc->in_flight));
+    svc->waits     = calloc(svc->max_in_flight, sizeof(*svc->waits));
+    pthread_mutex_init(&svc->lock, NULL);
+    pthread_cond_init(&svc->wake, NULL);
+    if (svc->in_flight == NULL || svc->waits == NULL ||
+        pthread_create(&svc->thread, NULL, service_main, svc) != 0) {
+        pthread_mutex_destroy(&svc->lock);
+        pthread_cond_destroy(&svc->wake);
+        free(svc->in_flight);
+        free(svc->waits);
+        free(svc);
+        return NULL;
+    }
+    wgpuInstanceAddRef(svc->instance);
+    wgpuDeviceAddRef(svc->device);
+    return svc;
+}
+
+/* Takes ownership of job's key; returns the future to hand out, which is
+ * job itself unless an identical request was pending. */
+static struct pipeline_future *submit(struct pipeline_service *svc,
+                                      struct pipeline_future  *job,
+                                      int                      priority)
+{
+    pthread_mutex_lock(&svc->lock);
+    ++svc->stats.submitted;
+    if (!job->key.failed) {
+        job->hash = key_hash(&job->key);
+        for (struct pipeline_future *other =
+                     svc->pending[job->hash % PENDING_BUCKETS];
+             other; other = other->next_pending) {
+            if (other->kind != job->kind || other->hash != job->hash ||
+                !key_equal(&other->key, job->key.data, job->key.size)) {
+                continue;
+            }
+            ++svc->stats.merged;
+            atomic_fetch_add(&other->refs, 1);
+            if (other->state == JOB_QUEUED && priority > other->priority) {
+                other->priority = priority;
+                heap_up(svc, other->heap_index);
+            }
+            pthread_mutex_unlock(&svc->lock);
+            job_release(job);
+            return other;
+        }
+    }
+
+    if (svc->stopping ||
+        (svc->queued == svc->heap_capacity && !grow_heap(svc))) {
+        pthread_mutex_unlock(&svc->lock);
+        job_release(job);
+        return NULL;
+    }
+    if (!job->key.failed) {
+        job->next_pending = svc->pending[job->hash % PENDING_BUCKETS];
+        svc->pending[job->hash % PENDING_BUCKETS] = job;
+    }
+    job->priority = priority;
+    job->seq      = svc->seq++;
+    job->state    = JOB_QUEUED;
+    atomic_fetch_add(&job->refs, 1);
+    heap_place(svc, svc->queued++, job);
+    heap_up(svc, job->heap_index);
+    pthread_cond_signal(&svc->wake);
+    pthread_mutex_unlock(&svc->lock);
+    return job;
+}
+
+static struct pipeline_future *job_new(enum job_kind kind)
+{
+    struct pipeline_future *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        return NULL;
+    }
+    atomic_init(&job->refs, 1);
+    job->kind = kind;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->done, NULL);
+    return job;
+}
+
+struct pipeline_future *
+pipeline_service_compute(struct pipeline_service             *svc,
+                         const WGPUComputePipelineDescriptor *desc,
+                         int                                  priority)
+{
+    struct pipeline_future *job = job_new(JOB_COMPUTE);
+    if (job == NULL) {
+        return NULL;
+    }
+    job->desc.compute = desc;
+    key_compute(&job->key, desc);
+    return submit(svc, job, priority);
+}
+
+struct pipeline_future *
+pipeline_service_render(struct pipeline_service            *svc,
+                        const WGPURenderPipelineDescriptor *desc,
+                        int                                 priority)
+{
+    struct pipeline_future *job = job_new(JOB_RENDER);
+    if (job == NULL) {
+        return NULL;
+    }
+    job->desc.render = desc;
+    key_render(&job->key, desc);
+    return submit(svc, job, priority);
+}
+
+bool pipeline_future_wait(struct pipeline_future *future, uint64_t timeout_ns,
+                          struct pipeline_result *out)
+{
+    pthread_mutex_lock(&future->lock);
+    if (timeout_ns == PIPELINE_WAIT_FOREVER) {
+        while (!future->ready) {
+            pthread_cond_wait(&future->done, &future->lock);
+        }
+    } else if (!future->ready && timeout_ns > 0) {
+        struct timespec deadline = deadline_after(timeout_ns);
+        while (!future->ready &&
+               pthread_cond_timedwait(&future->done, &future->lock,
+                                      &deadline) == 0) {
+        }
+    }
+    bool ready = future->ready;
+    pthread_mutex_unlock(&future->lock);
+
+    if (ready) {
+        *out = future->result;
+        if (out->compute) {
+            wgpuComputePipelineAddRef(out->compute);
+        }
+        if (out->render) {
+            wgpuRenderPipelineAddRef(out->render);
+        }
+    }
+    return ready;
+}
+
+void pipeline_future_release(struct pipeline_future *future)
+{
+    job_release(future);
+}
+
+void pipeline_service_stats(struct pipeline_service       *svc,
+                            struct pipeline_service_stats *out)
+{
+    pthread_mutex_lock(&svc->lock);
+    *out           = svc->stats;
+    out->queued    = svc->queued;
+    out->in_flight = svc->in_flight_count;
+    pthread_mutex_unlock(&svc->lock);
+}
+
+void pipeline_service_destroy(struct pipeline_service *svc)
+{
+    static const char cancelled[] = "pipeline service destroyed";
+
+    pthread_mutex_lock(&svc->lock);
+    svc->stopping = true;
+    while (svc->queued > 0) {
+        struct pipeline_future *job = heap_pop(svc);
+        unlink_pending(svc, job);
+        job->state = JOB_DONE;
+        pthread_mutex_unlock(&svc->lock);
+        job_complete(job, WGPUCreatePipelineAsyncStatus_CallbackCancelled,
+                     (WGPUStringView){cancelled, sizeof(cancelled) - 1});
+        pthread_mutex_lock(&svc->lock);
+    }
+    pthread_cond_signal(&svc->wake);
+    pthread_mutex_unlock(&svc->lock);
+    pthread_join(svc->thread, NULL);
+
+    pthread_mutex_destroy(&svc->lock);
+    pthread_cond_destroy(&svc->wake);
+    wgpuDeviceRelease(svc->device);
+    wgpuInstanceRelease(svc->instance);
+    free(svc->heap);
+    free(svc->in_flight);
+    free(svc->waits);
+    free(svc);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,100 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_PIPELINE_SERVICE_H
+#define WGPU_PIPELINE_SERVICE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define PIPELINE_IN_FLIGHT_DEFAULT 4
+#define PIPELINE_WAIT_FOREVER      UINT64_MAX
+#define PIPELINE_MESSAGE_MAX       256
+
+/* Higher runs first; requests of equal priority run in submission order. */
+enum pipeline_priority {
+    PIPELINE_PRIORITY_BACKGROUND = 0,
+    PIPELINE_PRIORITY_NORMAL     = 100,
+    PIPELINE_PRIORITY_CRITICAL   = 200,
+};
+
+struct pipeline_service_options {
+    /* The instance must have timed waits enabled, as acquire_init does. */
+    WGPUInstance instance;
+    WGPUDevice   device;
+    size_t       max_in_flight;
+    /* How long the service thread blocks in WaitAny before picking up
+     * compiles dispatched by submitters. */
+    uint64_t poll_interval_ns;
+};
+
+struct pipeline_result {
+    WGPUCreatePipelineAsyncStatus status;
+    /* Whichever matches the request; one reference per result. */
+    WGPUComputePipeline compute;
+    WGPURenderPipeline  render;
+    char                message[PIPELINE_MESSAGE_MAX];
+};
+
+struct pipeline_service_stats {
+    uint64_t submitted;
+    uint64_t merged; /* requests folded into an identical pending one */
+    uint64_t compiled;
+    uint64_t failed;
+    size_t   queued;
+    size_t   in_flight;
+};
+
+struct pipeline_service;
+struct pipeline_future;
+
+/* Starts the service thread. Returns NULL on failure. */
+struct pipeline_service *
+pipeline_service_create(const struct pipeline_service_options *opts);
+
+/* Queue a compile and return a future for it. A request identical to one
+ * still queued or compiling is merged into it, raising its priority if
+ * needed. desc and everything it points to must stay valid until the
+ * future is ready. Returns NULL when out of memory. */
+struct pipeline_future *
+pipeline_service_compute(struct pipeline_service             *svc,
+                         const WGPUComputePipelineDescriptor *desc,
+                         int                                  priority);
+struct pipeline_future *
+pipeline_service_render(struct pipeline_service            *svc,
+                        const WGPURenderPipelineDescriptor *desc,
+                        int                                 priority);
+
+/* Waits at most timeout_ns; a zero timeout only polls. Fills out and
+ * returns true once the compile finished. */
+bool pipeline_future_wait(struct pipeline_future *future, uint64_t timeout_ns,
+                          struct pipeline_result *out);
+void pipeline_future_release(struct pipeline_future *future);
+
+void pipeline_service_stats(struct pipeline_service       *svc,
+                            struct pipeline_service_stats *out);
+
+/* Waits for compiles in flight and cancels the queued ones. Futures that
+ * are still held stay valid until released. */
+void pipeline_service_destroy(struct pipeline_service *svc);
+
+#endif /* ifndef WGPU_PIPELINE_SERVICE_H */
@@ -0,0 +1,86 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "placement.h"
+
+void placement_choose(const struct adapter_caps *caps, WGPUDevice device,
+                      struct placement *out)
+{
+    uint64_t unified_bytes = 0;
+    uint64_t cached_bytes  = 0;
+
+    *out = (struct placement){0};
+    for (size_t i = 0; i < caps->heap_count; ++i) {
+        WGPUHeapProperty flags = caps->heaps[i].properties;
+        uint64_t         size  = caps->heaps[i].size;
+        if (flags & WGPUHeapProperty_DeviceLocal) {
+            out->device_local_bytes += size;
+        }
+        if (!(flags & WGPUHeapProperty_HostVisible)) {
+            continue;
+        }
+        out->host_visible_bytes += size;
+        if (flags & WGPUHeapProperty_DeviceLocal) {
+            unified_bytes += size;
+            if (flags & WGPUHeapProperty_HostCached) {
+                cached_bytes += size;
+            }
+        }
+    }
+
+    if (caps->heap_count > 0) {
+        /* A small DeviceLocal | HostVisible heap is the PCIe BAR window of a
+         * discrete GPU, not unified memory. */
+        out->unified     = 2 * unified_bytes >= out->device_local_bytes &&
+                           unified_bytes > 0;
+        out->host_cached = out->unified && 2 * cached_bytes >= unified_bytes;
+    } else {
+        out->unified = caps->adapter_type == WGPUAdapterType_IntegratedGPU ||
+                       caps->adapter_type == WGPUAdapterType_CPU;
+        out->host_cached = caps->adapter_type == WGPUAdapterType_CPU;
+    }
+    out->extended_usages = wgpuDeviceHasFeature(
+            device, WGPUFeatureName_BufferMapExtendedUsages);
+
+    bool direct   = out->unified && out->extended_usages;
+    out->upload   = direct ? PLACEMENT_DIRECT : PLACEMENT_STAGING;
+    out->readback = direct && out->host_cached ? PLACEMENT_DIRECT
+                                               : PLACEMENT_STAGING;
+}
+
+WGPUBufferUsage placement_upload_usage(const struct placement *p,
+                                       WGPUBufferUsage         usage)
+{
+    return usage | (p->upload == PLACEMENT_DIRECT ? WGPUBufferUsage_MapWrite
+                                                  : WGPUBufferUsage_CopyDst);
+}
+
+WGPUBufferUsage placement_readback_usage(const struct placement *p,
+                                         WGPUBufferUsage         usage)
+{
+    return usage | (p->readback == PLACEMENT_DIRECT ? WGPUBufferUsage_MapRead
+                                                    : WGPUBufferUsage_CopySrc);
+}
+
+const char *placement_strategy_name(placement_strategy strategy)
+{
+    return strategy == PLACEMENT_DIRECT ? "direct" : "staging";
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
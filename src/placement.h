@@ -0,0 +1,63 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_PLACEMENT_H
+#define WGPU_PLACEMENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "caps.h"
+
+typedef enum placement_strategy {
+    PLACEMENT_STAGING = 0, /* upload_ring or readback through a copy */
+    PLACEMENT_DIRECT,      /* map the GPU buffer itself */
+} placement_strategy;
+
+struct placement {
+    bool     unified;         /* the bulk of DeviceLocal is HostVisible */
+    bool     host_cached;     /* and HostCached, so CPU reads are fast */
+    bool     extended_usages; /* the device has BufferMapExtendedUsages */
+    uint64_t device_local_bytes;
+    uint64_t host_visible_bytes;
+
+    placement_strategy upload;
+    placement_strategy readback;
+};
+
+/* Reads the adapter's memory heaps, or falls back on its type when they are
+ * not reported. Direct mapping needs unified memory and a device created
+ * with BufferMapExtendedUsages. Direct readback additionally needs cached
+ * memory, since reading write-combined memory is slower than a copy. */
+void placement_choose(const struct adapter_caps *caps, WGPUDevice device,
+                      struct placement *out);
+
+/* usage plus MapWrite for a direct upload, or CopyDst for a staged one. */
+WGPUBufferUsage placement_upload_usage(const struct placement *p,
+                                       WGPUBufferUsage         usage);
+
+/* usage plus MapRead for a direct readback, or CopySrc for a staged one. */
+WGPUBufferUsage placement_readback_usage(const struct placement *p,
+                                         WGPUBufferUsage         usage);
+
+const char *placement_strategy_name(placement_strategy strategy);
+
+#endif /* ifndef WGPU_PLACEMENT_H */
@@ -0,0 +1,343 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dawn/webgpu.h>
+
+#include "acquire.h"
+#include "caps.h"
+#include "phase.h"
+#include "placement.h"
+#include "readback.h"
+#include "upload_ring.h"
+
+#define CHUNK_SIZE (16ull * 1024 * 1024)
+
+struct bench {
+    struct acquire acq;
+    uint64_t       size;
+    long           iterations;
+    uint8_t       *host;
+};
+
+static void work_done(WGPUQueueWorkDoneStatus status, void *userdata1,
+                      void *userdata2)
+{
+    (void)status;
+    (void)userdata1;
+    (void)userdata2;
+}
+
+static void map_done(WGPUMapAsyncStatus status, WGPUStringView message,
+                     void *userdata1, void *userdata2)
+{
+    (void)message;
+    (void)userdata2;
+    *( WGPUMapAsyncStatus * )userdata1 = status;
+}
+
+struct reads {
+    size_t done;
+    size_t failed;
+};
+
+static void read_done(WGPUMapAsyncStatus status, const void *data,
+                      uint64_t size, void *userdata)
+{
+    struct reads *reads = userdata;
+    (void)size;
+    ++reads->done;
+    reads->failed += status != WGPUMapAsyncStatus_Success || data == NULL;
+}
+
+/* A path that did not move every byte reports nothing rather than a rate
+ * for work that never happened. */
+static uint64_t failed(const char *path)
+{
+    fprintf(stderr, "%s failed, reporting 0 MiB/s\n", path);
+    return 0;
+}
+
+static void wait_idle(struct bench *b)
+{
+    WGPUQueueWorkDoneCallbackInfo info =
+            WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+    info.mode     = WGPUCallbackMode_WaitAnyOnly;
+    info.callback = work_done;
+
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future             = wgpuQueueOnSubmittedWorkDone(b->acq.queue, info);
+    wgpuInstanceWaitAny(b->acq.instance, 1, &wait, UINT64_MAX);
+}
+
+static bool map(struct bench *b, WGPUBuffer buffer, WGPUMapMode mode)
+{
+    WGPUMapAsyncStatus        status = WGPUMapAsyncStatus_Error;
+    WGPUBufferMapCallbackInfo info   = WGPU_BUFFER_MAP_CALLBACK_INFO_INIT;
+    info.mode                        = WGPUCallbackMode_WaitAnyOnly;
+    info.callback                    = map_done;
+    info.userdata1                   = &status;
+
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future = wgpuBufferMapAsync(buffer, mode, 0, b->size, info);
+    wgpuInstanceWaitAny(b->acq.instance, 1, &wait, UINT64_MAX);
+    return status == WGPUMapAsyncStatus_Success;
+}
+
+static WGPUBuffer create_buffer(struct bench *b, WGPUBufferUsage usage)
+{
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.usage                = usage;
+    desc.size                 = b->size;
+    return wgpuDeviceCreateBuffer(b->acq.device, &desc);
+}
+
+static uint64_t upload_write_buffer(struct bench *b)
+{
+    WGPUBuffer dst =
+            create_buffer(b, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations; ++i) {
+        wgpuQueueWriteBuffer(b->acq.queue, dst, 0, b->host, ( size_t )b->size);
+        wait_idle(b);
+    }
+    uint64_t elapsed = phase_now_ns() - start;
+    wgpuBufferRelease(dst);
+    return elapsed;
+}
+
+static uint64_t upload_staging(struct bench *b)
+{
+    struct upload_ring_options opts = {
+            .instance = b->acq.instance,
+            .device   = b->acq.device,
+    };
+    struct upload_ring *ring = upload_ring_create(&opts);
+    WGPUBuffer          dst =
+            create_buffer(b, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst);
+    if (ring == NULL) {
+        wgpuBufferRelease(dst);
+        return failed("staging upload");
+    }
+
+    bool     ok    = true;
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations && ok; ++i) {
+        /* One submit per chunk, so a chunk never waits on segments that
+         * have not been submitted yet. */
+        for (uint64_t off = 0; off < b->size && ok; off += CHUNK_SIZE) {
+            uint64_t n = b->size - off < CHUNK_SIZE ? b->size - off
+                                                    : CHUNK_SIZE;
+            WGPUCommandEncoder encoder =
+                    wgpuDeviceCreateCommandEncoder(b->acq.device, NULL);
+            ok = upload_ring_write(ring, encoder, dst, off, b->host + off, n,
+                                   UPLOAD_WAIT_FOREVER);
+            WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(encoder, NULL);
+            upload_ring_submit(ring, b->acq.queue, 1, &cmd);
+            wgpuCommandBufferRelease(cmd);
+            wgpuCommandEncoderRelease(encoder);
+        }
+        wait_idle(b);
+    }
+    uint64_t elapsed = phase_now_ns() - start;
+    upload_ring_destroy(ring);
+    wgpuBufferRelease(dst);
+    return ok ? elapsed : failed("staging upload");
+}
+
+static uint64_t upload_direct(struct bench *b)
+{
+    WGPUBuffer dst = create_buffer(
+            b, WGPUBufferUsage_Storage | WGPUBufferUsage_MapWrite);
+    bool     ok    = dst != NULL;
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations && ok; ++i) {
+        ok = map(b, dst, WGPUMapMode_Write);
+        if (ok) {
+            void *mapped = wgpuBufferGetMappedRange(dst, 0, ( size_t )b->size);
+            if (mapped != NULL) {
+                memcpy(mapped, b->host, ( size_t )b->size);
+            }
+            wgpuBufferUnmap(dst);
+            ok = mapped != NULL;
+        }
+    }
+    uint64_t elapsed = phase_now_ns() - start;
+    wgpuBufferRelease(dst);
+    return ok ? elapsed : failed("direct upload");
+}
+
+static uint64_t readback_staging(struct bench *b)
+{
+    struct readback_options opts = {
+            .instance    = b->acq.instance,
+            .device      = b->acq.device,
+            .buffer_size = CHUNK_SIZE,
+    };
+    struct readback *rb = readback_create(&opts);
+    WGPUBuffer       src =
+            create_buffer(b, WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc);
+    if (rb == NULL) {
+        wgpuBufferRelease(src);
+        return failed("staging readback");
+    }
+
+    bool     ok    = true;
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations && ok; ++i) {
+        size_t       expected = 0;
+        struct reads reads    = {0};
+        for (uint64_t off = 0; off < b->size && ok; off += CHUNK_SIZE) {
+            uint64_t n = b->size - off < CHUNK_SIZE ? b->size - off
+                                                    : CHUNK_SIZE;
+            WGPUCommandEncoder encoder =
+                    wgpuDeviceCreateCommandEncoder(b->acq.device, NULL);
+            ok = readback_copy(rb, encoder, src, off, n, b->host + off,
+                               read_done, &reads, READBACK_WAIT_FOREVER);
+            expected += ok;
+            WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(encoder, NULL);
+            readback_submit(rb, b->acq.queue, 1, &cmd);
+            wgpuCommandBufferRelease(cmd);
+            wgpuCommandEncoderRelease(encoder);
+        }
+        while (reads.done < expected) {
+            readback_poll(rb, READBACK_WAIT_FOREVER);
+        }
+        ok = ok && reads.failed == 0;
+    }
+    uint64_t elapsed = phase_now_ns() - start;
+    readback_destroy(rb);
+    wgpuBufferRelease(src);
+    return ok ? elapsed : failed("staging readback");
+}
+
+static uint64_t readback_direct(struct bench *b)
+{
+    WGPUBuffer src =
+            create_buffer(b, WGPUBufferUsage_Storage | WGPUBufferUsage_MapRead);
+    bool     ok    = src != NULL;
+    uint64_t start = phase_now_ns();
+    for (long i = 0; i < b->iterations && ok; ++i) {
+        ok = map(b, src, WGPUMapMode_Read);
+        if (ok) {
+            ok = wgpuBufferReadMappedRange(src, 0, b->host,
+                                           ( size_t )b->size) ==
+                 WGPUStatus_Success;
+            wgpuBufferUnmap(src);
+        }
+    }
+    uint64_t elapsed = phase_now_ns() - start;
+    wgpuBufferRelease(src);
+    return ok ? elapsed : failed("direct readback");
+}
+
+static double mib_per_second(const struct bench *b, uint64_t ns)
+{
+    if (ns == 0) {
+        return 0;
+    }
+    return ( double )b->size * ( double )b->iterations / (1024.0 * 1024.0) /
+           (( double )ns / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    long mib        = argc > 1 ? strtol(argv[1], NULL, 10) : 64;
+    long iterations = argc > 2 ? strtol(argv[2], NULL, 10) : 16;
+    if (mib <= 0 || iterations <= 0) {
+        fprintf(stderr, "Usage: %s [MIB [ITERATIONS]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* The adapter is probed first so the device can be asked for
+     * BufferMapExtendedUsages only where it exists. */
+    struct bench b = {.size = ( uint64_t )mib * 1024 * 1024,
+                      .iterations = iterations};
+    if (!acquire_init(&b.acq)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        return EXIT_FAILURE;
+    }
+    WGPURequestAdapterOptions options = {0};
+    acquire_begin(&b.acq, &(struct acquire_options){.adapter = &options});
+    struct adapter_caps caps;
+    if (acquire_wait(&b.acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        !caps_query(b.acq.adapter, &caps)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        acquire_release(&b.acq);
+        return EXIT_FAILURE;
+    }
+    WGPUFeatureName      extended = WGPUFeatureName_BufferMapExtendedUsages;
+    WGPUDeviceDescriptor device   = WGPU_DEVICE_DESCRIPTOR_INIT;
+    if (caps_has_feature(&caps, extended)) {
+        device.requiredFeatureCount = 1;
+        device.requiredFeatures     = &extended;
+    }
+    acquire_release(&b.acq);
+    if (!acquire_init(&b.acq)) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        caps_free(&caps);
+        return EXIT_FAILURE;
+    }
+    acquire_begin(&b.acq, &(struct acquire_options){.adapter = &options,
+                                                    .device  = &device,
+                                                    .request_device = true});
+    b.host = malloc(( size_t )b.size);
+    if (acquire_wait(&b.acq, ACQUIRE_TIMEOUT_INFINITE) != ACQUIRE_SUCCESS ||
+        b.host == NULL) {
+        fprintf(stderr, "%s\n", b.acq.message);
+        acquire_release(&b.acq);
+        caps_free(&caps);
+        free(b.host);
+        return EXIT_FAILURE;
+    }
+    memset(b.host, 0xa5, ( size_t )b.size);
+
+    struct placement p;
+    placement_choose(&caps, b.acq.device, &p);
+    bool direct = p.extended_usages;
+
+    double write_buffer = mib_per_second(&b, upload_write_buffer(&b));
+    double up_staging   = mib_per_second(&b, upload_staging(&b));
+    double up_direct    = direct ? mib_per_second(&b, upload_direct(&b)) : 0;
+    double rb_staging   = mib_per_second(&b, readback_staging(&b));
+    double rb_direct    = direct ? mib_per_second(&b, readback_direct(&b)) : 0;
+
+    printf("{\"mib\":%ld,\"iterations\":%ld,\"unified\":%s,"
+           "\"host_cached\":%s,\"extended_usages\":%s,"
+           "\"upload\":{\"chosen\":\"%s\",\"write_buffer_mibps\":%.1f,"
+           "\"staging_mibps\":%.1f,\"direct_mibps\":%.1f},"
+           "\"readback\":{\"chosen\":\"%s\",\"staging_mibps\":%.1f,"
+           "\"direct_mibps\":%.1f}}\n",
+           mib, iterations, p.unified ? "true" : "false",
+           p.host_cached ? "true" : "false", direct ? "true" : "false",
+           placement_strategy_name(p.upload), write_buffer, up_staging,
+           up_direct, placement_strategy_name(p.readback), rb_staging,
+           rb_direct);
+
+    free(b.host);
+    caps_free(&caps);
+    acquire_release(&b.acq);
+    return EXIT_SUCCESS;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,407 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "phase.h"
+#include "readback.h"
+
+#define COPY_ALIGNMENT 4
+/* Mapped range offsets have to be multiples of 8, so requests start there. */
+#define MAP_ALIGNMENT 8
+
+struct request {
+    uint64_t         offset;
+    uint64_t         size;
+    void            *dst;
+    readback_done_fn done;
+    void            *userdata;
+};
+
+enum staging_state {
+    STAGING_FREE,
+    STAGING_RECORDING, /* copies recorded, not yet submitted */
+    STAGING_MAPPING,
+};
+
+struct staging {
+    struct readback   *rb;
+    WGPUBuffer         buffer;
+    uint64_t           size;
+    uint64_t           cursor;
+    bool               dedicated;
+    enum staging_state state;
+    WGPUFuture         future;
+    uint64_t           submit_ns;
+
+    struct request *requests;
+    size_t          request_count;
+    size_t          request_capacity;
+};
+
+struct readback {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    uint64_t     buffer_size;
+    size_t       max_buffers;
+    size_t       wait_chunk;
+
+    /* Pooled buffers first; dedicated ones are appended and dropped once
+     * their readback completes. */
+    struct staging **stagings;
+    size_t           count;
+    size_t           pooled;
+    struct staging  *current;
+
+    WGPUFutureWaitInfo *waits;
+    size_t              wait_capacity;
+
+    struct readback_stats stats;
+    uint64_t              latency_total_ns;
+    uint64_t              busy_ns;
+    uint64_t              busy_since;
+    size_t                mapping;
+};
+
+static struct staging *staging_new(struct readback *rb, uint64_t size,
+                                   bool dedicated)
+{
+    struct staging **stagings =
+            realloc(rb->stagings, (rb->count + 1) * sizeof(*stagings));
+    if (stagings == NULL) {
+        return NULL;
+    }
+    rb->stagings = stagings;
+
+    struct staging *s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return NULL;
+    }
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.label = (WGPUStringView){.data = "readback", .length = 8};
+    desc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+    desc.size  = size;
+    s->buffer  = wgpuDeviceCreateBuffer(rb->device, &desc);
+    if (s->buffer == NULL) {
+        free(s);
+        return NULL;
+    }
+    s->rb                     = rb;
+    s->size                   = size;
+    s->dedicated              = dedicated;
+    rb->stagings[rb->count++] = s;
+    rb->pooled += !dedicated;
+    return s;
+}
+
+static void staging_drop(struct readback *rb, struct staging *s)
+{
+    for (size_t i = 0; i < rb->count; ++i) {
+        if (rb->stagings[i] == s) {
+            memmove(&rb->stagings[i], &rb->stagings[i + 1],
+                    (rb->count - i - 1) * sizeof(*rb->stagings));
+            --rb->count;
+            break;
+        }
+    }
+    rb->pooled -= !s->dedicated;
+    wgpuBufferRelease(s->buffer);
+    free(s->requests);
+    free(s);
+}
+
+static void finish(struct staging *s, WGPUMapAsyncStatus status)
+{
+    struct readback *rb = s->rb;
+    uint64_t         now = phase_now_ns();
+    for (size_t i = 0; i < s->request_count; ++i) {
+        struct request    *r      = &s->requests[i];
+        const void        *data   = NULL;
+        WGPUMapAsyncStatus result = status;
+        if (status == WGPUMapAsyncStatus_Success && r->dst != NULL) {
+            if (wgpuBufferReadMappedRange(s->buffer, ( size_t )r->offset,
+                                          r->dst, ( size_t )r->size) ==
+                WGPUStatus_Success) {
+                data = r->dst;
+            }
+        } else if (status == WGPUMapAsyncStatus_Success) {
+            data = wgpuBufferGetConstMappedRange(s->buffer, ( size_t )r->offset,
+                                                 ( size_t )r->size);
+        }
+        /* A range that cannot be read fails only its own request; the
+         * others in the buffer are still mapped and readable. */
+        if (data == NULL) {
+            ++rb->stats.failed;
+            if (result == WGPUMapAsyncStatus_Success) {
+                result = WGPUMapAsyncStatus_Error;
+            }
+        } else {
+            rb->stats.bytes += r->size;
+        }
+        ++rb->stats.requests;
+        if (r->done != NULL) {
+            r->done(result, data, r->size, r->userdata);
+        }
+    }
+    if (s->state == STAGING_MAPPING) {
+        uint64_t latency = now - s->submit_ns;
+        rb->latency_total_ns += latency * s->request_count;
+        if (latency > rb->stats.latency_max_ns) {
+            rb->stats.latency_max_ns = latency;
+        }
+        if (--rb->mapping == 0) {
+            rb->busy_ns += now - rb->busy_since;
+        }
+    }
+    if (status == WGPUMapAsyncStatus_Success) {
+        wgpuBufferUnmap(s->buffer);
+    }
+    s->request_count = 0;
+    s->cursor        = 0;
+    s->state         = STAGING_FREE;
+}
+
+static void map_callback(WGPUMapAsyncStatus status, WGPUStringView message,
+                         void *userdata1, void *userdata2)
+{
+    struct staging *s = userdata1;
+    (void)message;
+    (void)userdata2;
+    finish(s, status);
+    if (s->dedicated) {
+        staging_drop(s->rb, s);
+    }
+}
+
+struct readback *readback_create(const struct readback_options *opts)
+{
+    struct readback *rb = calloc(1, sizeof(*rb));
+    if (rb == NULL) {
+        return NULL;
+    }
+    rb->instance    = opts->instance;
+    rb->device      = opts->device;
+    rb->buffer_size = opts->buffer_size ? opts->buffer_size
+                                        : READBACK_BUFFER_SIZE_DEFAULT;
+    rb->max_buffers = opts->buffer_count ? opts->buffer_count
+                                         : READBACK_BUFFER_COUNT_DEFAULT;
+    if (rb->buffer_size % COPY_ALIGNMENT != 0) {
+        free(rb);
+        return NULL;
+    }
+
+    WGPUInstanceCapabilities caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    wgpuGetInstanceCapabilities(&caps);
+    rb->wait_chunk = caps.timedWaitAnyMaxCount ? caps.timedWaitAnyMaxCount : 1;
+
+    wgpuInstanceAddRef(rb->instance);
+    wgpuDeviceAddRef(rb->device);
+    return rb;
+}
+
+size_t readback_poll(struct readback *rb, uint64_t timeout_ns)
+{
+    if (rb->mapping == 0) {
+        return 0;
+    }
+    if (rb->wait_capacity < rb->count) {
+        WGPUFutureWaitInfo *waits =
+                realloc(rb->waits, rb->count * sizeof(*waits));
+        if (waits == NULL) {
+            return 0;
+        }
+        rb->waits         = waits;
+        rb->wait_capacity = rb->count;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < rb->count; ++i) {
+        if (rb->stagings[i]->state == STAGING_MAPPING) {
+            rb->waits[count].future    = rb->stagings[i]->future;
+            rb->waits[count].completed = false;
+            ++count;
+        }
+    }
+
+    /* Callbacks run inside WaitAny and can drop dedicated buffers, so only
+     * the wait infos are used past this point. A timed wait is limited to
+     * timedWaitAnyMaxCount futures: the first chunk gets the timeout and
+     * the rest are only polled. */
+    uint64_t before = rb->stats.requests;
+    for (size_t first = 0; first < count;) {
+        size_t n = count - first;
+        if (timeout_ns > 0 && n > rb->wait_chunk) {
+            n = rb->wait_chunk;
+        }
+        uint64_t timeout = first == 0 ? timeout_ns : 0;
+        if (wgpuInstanceWaitAny(rb->instance, n, rb->waits + first,
+                                timeout) == WGPUWaitStatus_Error &&
+            timeout > 0) {
+            /* No timed waits on this instance: fall back to polling. */
+            wgpuInstanceWaitAny(rb->instance, n, rb->waits + first, 0);
+        }
+        first += n;
+    }
+    return ( size_t )(rb->stats.requests - before);
+}
+
+static uint64_t next_offset(const struct staging *s)
+{
+    return (s->cursor + MAP_ALIGNMENT - 1) / MAP_ALIGNMENT * MAP_ALIGNMENT;
+}
+
+/* A pooled buffer with room for size more bytes, reclaiming mapped ones
+ * if every buffer is taken. */
+static struct staging *pooled_staging(struct readback *rb, uint64_t size,
+                                      uint64_t timeout_ns)
+{
+    if (rb->current && next_offset(rb->current) + size <= rb->current->size) {
+        return rb->current;
+    }
+    uint64_t start = phase_now_ns();
+    for (;;) {
+        for (size_t i = 0; i < rb->count; ++i) {
+            if (!rb->stagings[i]->dedicated &&
+                rb->stagings[i]->state == STAGING_FREE) {
+                return rb->current = rb->stagings[i];
+            }
+        }
+        if (rb->pooled < rb->max_buffers) {
+            return rb->current = staging_new(rb, rb->buffer_size, false);
+        }
+        uint64_t elapsed = phase_now_ns() - start;
+        if (rb->mapping == 0 ||
+            (timeout_ns != READBACK_WAIT_FOREVER && elapsed >= timeout_ns)) {
+            return NULL;
+        }
+        readback_poll(rb, timeout_ns == READBACK_WAIT_FOREVER
+                                  ? UINT64_MAX
+                                  : timeout_ns - elapsed);
+    }
+}
+
+bool readback_copy(struct readback *rb, WGPUCommandEncoder encoder,
+                   WGPUBuffer src, uint64_t src_offset, uint64_t size,
+                   void *dst, readback_done_fn done, void *userdata,
+                   uint64_t timeout_ns)
+{
+    if (size == 0 || size % COPY_ALIGNMENT || src_offset % COPY_ALIGNMENT) {
+        return false;
+    }
+    struct staging *s = size > rb->buffer_size
+                                ? staging_new(rb, size, true)
+                                : pooled_staging(rb, size, timeout_ns);
+    if (s == NULL) {
+        return false;
+    }
+    if (s->request_count == s->request_capacity) {
+        size_t capacity = s->request_capacity ? 2 * s->request_capacity : 16;
+        struct request *requests =
+                realloc(s->requests, capacity * sizeof(*requests));
+        if (requests == NULL) {
+            if (s->dedicated) {
+                staging_drop(rb, s);
+            }
+            return false;
+        }
+        s->requests         = requests;
+        s->request_capacity = capacity;
+    }
+
+    uint64_t offset = next_offset(s);
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, src, src_offset, s->buffer,
+                                         offset, size);
+    s->requests[s->request_count++] = (struct request){
+            .offset   = offset,
+            .size     = size,
+            .dst      = dst,
+            .done     = done,
+            .userdata = userdata,
+    };
+    s->cursor = offset + size;
+    s->state = STAGING_RECORDING;
+    return true;
+}
+
+void readback_submit(struct readback *rb, WGPUQueue queue, size_t count,
+                     const WGPUCommandBuffer *commands)
+{
+    wgpuQueueSubmit(queue, count, commands);
+
+    /* Mapping right after the submit is enough: the map resolves once the
+     * queue is done writing the buffer, with no work done callback. */
+    uint64_t now = phase_now_ns();
+    for (size_t i = 0; i < rb->count; ++i) {
+        struct staging *s = rb->stagings[i];
+        if (s->state != STAGING_RECORDING) {
+            continue;
+        }
+        WGPUBufferMapCallbackInfo info = WGPU_BUFFER_MAP_CALLBACK_INFO_INIT;
+        info.mode                      = WGPUCallbackMode_WaitAnyOnly;
+        info.callback                  = map_callback;
+        info.userdata1                 = s;
+        if (rb->mapping++ == 0) {
+            rb->busy_since = now;
+        }
+        s->state     = STAGING_MAPPING;
+        s->submit_ns = now;
+        s->future    = wgpuBufferMapAsync(s->buffer, WGPUMapMode_Read, 0,
+                                          ( size_t )s->cursor, info);
+    }
+    rb->current = NULL;
+}
+
+void readback_stats(struct readback *rb, struct readback_stats *out)
+{
+    *out           = rb->stats;
+    out->in_flight = rb->mapping;
+    if (out->requests > 0) {
+        out->latency_mean_ns = rb->latency_total_ns / out->requests;
+    }
+    uint64_t busy = rb->busy_ns;
+    if (rb->mapping > 0) {
+        busy += phase_now_ns() - rb->busy_since;
+    }
+    if (busy > 0) {
+        out->bytes_per_second =
+                ( uint64_t )(( double )out->bytes * 1e9 / ( double )busy);
+    }
+}
+
+void readback_destroy(struct readback *rb)
+{
+    while (rb->mapping > 0) {
+        readback_poll(rb, READBACK_WAIT_FOREVER);
+    }
+    while (rb->count > 0) {
+        struct staging *s = rb->stagings[rb->count - 1];
+        if (s->state == STAGING_RECORDING) {
+            finish(s, WGPUMapAsyncStatus_Aborted);
+        }
+        staging_drop(rb, s);
+    }
+    wgpuDeviceRelease(rb->device);
+    wgpuInstanceRelease(rb->instance);
+    free(rb->stagings);
+    free(rb->waits);
+    free(rb);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,90 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_READBACK_H
+#define WGPU_READBACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define READBACK_BUFFER_SIZE_DEFAULT  (4ull * 1024 * 1024)
+#define READBACK_BUFFER_COUNT_DEFAULT 16
+#define READBACK_WAIT_FOREVER         UINT64_MAX
+
+struct readback_options {
+    /* Polling with a timeout needs an instance with timed waits. */
+    WGPUInstance instance;
+    WGPUDevice   device;
+    uint64_t     buffer_size;
+    size_t       buffer_count;
+};
+
+struct readback_stats {
+    uint64_t requests;
+    uint64_t bytes;
+    uint64_t failed;
+    size_t   in_flight;       /* staging buffers being mapped */
+    uint64_t latency_mean_ns; /* submit to result */
+    uint64_t latency_max_ns;
+    uint64_t bytes_per_second; /* over the time any readback was in flight */
+};
+
+/* status is the map status. data is dst when one was given, otherwise the
+ * mapped range, which is only valid during the call. */
+typedef void (*readback_done_fn)(WGPUMapAsyncStatus status, const void *data,
+                                 uint64_t size, void *userdata);
+
+struct readback;
+
+/* Staging buffers are MapRead | CopyDst and created on demand, up to
+ * buffer_count of buffer_size. Returns NULL on failure. A readback engine
+ * is used from one thread. */
+struct readback *readback_create(const struct readback_options *opts);
+
+/* Records a copy of size bytes of src at src_offset into staging memory.
+ * Small reads share a staging buffer. Reads larger than the buffer size get
+ * a dedicated one. When dst is set, the result is copied there with
+ * wgpuBufferReadMappedRange, and the mapped range is never exposed. size
+ * and src_offset must be multiples of 4. When every staging buffer is busy
+ * this polls for up to timeout_ns, and it fails if none frees up. */
+bool readback_copy(struct readback *rb, WGPUCommandEncoder encoder,
+                   WGPUBuffer src, uint64_t src_offset, uint64_t size,
+                   void *dst, readback_done_fn done, void *userdata,
+                   uint64_t timeout_ns);
+
+/* Submits commands, which must include every encoder copies were recorded
+ * into, and starts mapping the staging buffers they write. */
+void readback_submit(struct readback *rb, WGPUQueue queue, size_t count,
+                     const WGPUCommandBuffer *commands);
+
+/* Waits up to timeout_ns for mapped staging buffers in one batched
+ * wgpuInstanceWaitAny and runs their callbacks. A zero timeout only polls.
+ * Returns the number of readbacks completed. */
+size_t readback_poll(struct readback *rb, uint64_t timeout_ns);
+
+void readback_stats(struct readback *rb, struct readback_stats *out);
+
+/* Finishes mapped readbacks. Callbacks for copies that were never
+ * submitted get WGPUMapAsyncStatus_Aborted. */
+void readback_destroy(struct readback *rb);
+
+#endif /* ifndef WGPU_READBACK_H */
@@ -0,0 +1,106 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "score.h"
+
+static unsigned ilog2(uint64_t value)
+{
+    unsigned bits = 0;
+    while (value >>= 1) {
+        ++bits;
+    }
+    return bits;
+}
+
+static double clamp01(double value)
+{
+    return value < 0.0 ? 0.0 : value > 1.0 ? 1.0 : value;
+}
+
+static double type_term(WGPUAdapterType type)
+{
+    switch (type) {
+    case WGPUAdapterType_DiscreteGPU:
+        return 1.0;
+    case WGPUAdapterType_IntegratedGPU:
+        return 0.6;
+    case WGPUAdapterType_Unknown:
+        return 0.3;
+    default:
+        return 0.0;
+    }
+}
+
+/* The limits that bound how large a compute job can be, as log2 fractions
+ * of generous upper bounds. */
+static double limits_term(const WGPULimits *limits)
+{
+    double sum = ilog2(limits->maxBufferSize) / 40.0 +
+                 ilog2(limits->maxStorageBufferBindingSize) / 40.0 +
+                 ilog2(limits->maxComputeInvocationsPerWorkgroup) / 11.0 +
+                 ilog2(limits->maxComputeWorkgroupStorageSize) / 16.0 +
+                 ilog2(limits->maxComputeWorkgroupsPerDimension) / 16.0;
+    return clamp01(sum / 5.0);
+}
+
+/* Device local bytes; without the heaps feature there is nothing to go on
+ * and the term stays neutral rather than penalising the adapter. */
+static double memory_term(const struct adapter_caps *caps)
+{
+    if (caps->heap_count == 0) {
+        return 0.5;
+    }
+    uint64_t device_local = 0;
+    for (size_t i = 0; i < caps->heap_count; ++i) {
+        if (caps->heaps[i].properties & WGPUHeapProperty_DeviceLocal) {
+            device_local += caps->heaps[i].size;
+        }
+    }
+    /* 1 MiB scores 0, 64 GiB and above score 1. */
+    return clamp01(ilog2((device_local >> 20) | 1) / 16.0);
+}
+
+static double subgroups_term(const struct adapter_caps *caps)
+{
+    if (!caps_has_feature(caps, WGPUFeatureName_Subgroups)) {
+        return 0.0;
+    }
+    double width = caps->subgroup_max_size == WGPU_LIMIT_U32_UNDEFINED
+                           ? 0.0
+                           : clamp01(caps->subgroup_max_size / 64.0);
+    double matrices = clamp01(caps->config_count / 8.0);
+    return 0.5 + 0.25 * width + 0.25 * matrices;
+}
+
+double score_adapter(const struct adapter_caps  *caps,
+                     const struct score_weights *weights)
+{
+    double power = 0.0;
+    if (weights->power_preference != WGPUPowerPreference_Undefined &&
+        caps->power_preference == weights->power_preference) {
+        power = 1.0;
+    }
+
+    return weights->adapter_type * type_term(caps->adapter_type) +
+           weights->limits * limits_term(&caps->limits) +
+           weights->memory * memory_term(caps) +
+           weights->subgroups * subgroups_term(caps) + weights->power * power;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,56 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SCORE_H
+#define WGPU_SCORE_H
+
+#include <dawn/webgpu.h>
+
+#include "caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Relative weight of each scoring term. Every term is normalised to roughly
+ * [0, 1] before weighting, so the weights read as priorities. */
+struct score_weights {
+    WGPUPowerPreference power_preference;
+    double              adapter_type;
+    double              limits;
+    double              memory;
+    double              subgroups;
+    double              power;
+};
+
+#define SCORE_WEIGHTS_DEFAULT                                                  \
+    {                                                                          \
+        .power_preference = WGPUPowerPreference_HighPerformance,               \
+        .adapter_type = 4.0, .limits = 2.0, .memory = 2.0, .subgroups = 1.0,   \
+        .power = 0.5,                                                          \
+    }
+
+double score_adapter(const struct adapter_caps  *caps,
+                     const struct score_weights *weights);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_SCORE_H */
@@ -0,0 +1,291 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "key.h"
+#include "shader_cache.h"
+
+#define SHARDS 64
+
+/* The chained structs we know how to key, flattened in this fixed order so
+ * the key doesn't depend on how the chain was built. */
+enum part {
+    PART_WGSL,
+    PART_SPIRV,
+    PART_COMPILATION_OPTIONS,
+    PART_SPIRV_OPTIONS,
+    PARTS,
+};
+
+/* Everything but ready and module is immutable once the entry is linked
+ * into its bucket, so readers walk the chains without locking. */
+struct entry {
+    struct entry    *next;
+    uint64_t         hash;
+    atomic_bool      ready;
+    WGPUShaderModule module;
+    size_t           key_size;
+    uint8_t          key[];
+};
+
+/* Serialises inserts into, and creation waits on, the buckets it covers. */
+struct shard {
+    pthread_mutex_t lock;
+    pthread_cond_t  created;
+};
+
+struct shader_cache {
+    WGPUDevice device;
+    size_t     mask;
+
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t waits;
+    _Atomic uint64_t uncacheable;
+    _Atomic uint64_t entries;
+    _Atomic uint64_t key_bytes;
+
+    struct shard           shards[SHARDS];
+    struct entry *_Atomic *buckets;
+};
+
+/* Fails on chained structs that aren't understood, or that appear twice,
+ * since they may change what gets compiled. */
+static bool key_module(struct key *key, const WGPUShaderModuleDescriptor *desc)
+{
+    const WGPUChainedStruct *parts[PARTS] = {NULL};
+    for (const WGPUChainedStruct *c = desc->nextInChain; c; c = c->next) {
+        enum part part;
+        switch (c->sType) {
+        case WGPUSType_ShaderSourceWGSL:
+            part = PART_WGSL;
+            break;
+        case WGPUSType_ShaderSourceSPIRV:
+            part = PART_SPIRV;
+            break;
+        case WGPUSType_ShaderModuleCompilationOptions:
+            part = PART_COMPILATION_OPTIONS;
+            break;
+        case WGPUSType_DawnShaderModuleSPIRVOptionsDescriptor:
+            part = PART_SPIRV_OPTIONS;
+            break;
+        default:
+            return false;
+        }
+        if (parts[part] != NULL) {
+            return false;
+        }
+        parts[part] = c;
+    }
+    if (parts[PART_WGSL] == NULL && parts[PART_SPIRV] == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < PARTS; ++i) {
+        key_u32(key, parts[i] != NULL);
+    }
+    if (parts[PART_WGSL] != NULL) {
+        const WGPUShaderSourceWGSL *wgsl = ( const void * )parts[PART_WGSL];
+        key_string(key, wgsl->code);
+    }
+    if (parts[PART_SPIRV] != NULL) {
+        const WGPUShaderSourceSPIRV *spirv = ( const void * )parts[PART_SPIRV];
+        key_u64(key, spirv->codeSize);
+        key_bytes(key, spirv->code, spirv->codeSize * sizeof(uint32_t));
+    }
+    if (parts[PART_COMPILATION_OPTIONS] != NULL) {
+        const WGPUShaderModuleCompilationOptions *opts =
+                ( const void * )parts[PART_COMPILATION_OPTIONS];
+        key_u32(key, opts->strictMath);
+    }
+    if (parts[PART_SPIRV_OPTIONS] != NULL) {
+        const WGPUDawnShaderModuleSPIRVOptionsDescriptor *opts =
+                ( const void * )parts[PART_SPIRV_OPTIONS];
+        key_u32(key, opts->allowNonUniformDerivatives);
+    }
+    return !key->failed;
+}
+
+static struct entry *find(struct entry *e, const struct key *key,
+                          uint64_t hash)
+{
+    while (e && (e->hash != hash || !key_equal(key, e->key, e->key_size))) {
+        e = e->next;
+    }
+    return e;
+}
+
+/* Copies the key so the entry doesn't borrow the caller's descriptor. */
+static struct entry *entry_new(const struct key *key, uint64_t hash)
+{
+    struct entry *e = malloc(sizeof(*e) + key->size);
+    if (e == NULL) {
+        return NULL;
+    }
+    e->next     = NULL;
+    e->hash     = hash;
+    e->module   = NULL;
+    e->key_size = key->size;
+    atomic_init(&e->ready, false);
+    memcpy(e->key, key->data, key->size);
+    return e;
+}
+
+struct shader_cache *shader_cache_create(WGPUDevice device, size_t buckets)
+{
+    if (!wgpuDeviceHasFeature(device,
+                              WGPUFeatureName_ImplicitDeviceSynchronization)) {
+        return NULL;
+    }
+
+    size_t count  = 16;
+    size_t wanted = buckets ? buckets : SHADER_CACHE_BUCKETS_DEFAULT;
+    while (count < wanted) {
+        count <<= 1;
+    }
+
+    struct shader_cache *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->buckets = calloc(count, sizeof(*cache->buckets));
+    if (cache->buckets == NULL) {
+        free(cache);
+        return NULL;
+    }
+    cache->device = device;
+    cache->mask   = count - 1;
+    for (int i = 0; i < SHARDS; ++i) {
+        pthread_mutex_init(&cache->shards[i].lock, NULL);
+        pthread_cond_init(&cache->shards[i].created, NULL);
+    }
+    wgpuDeviceAddRef(device);
+    return cache;
+}
+
+WGPUShaderModule shader_cache_get(struct shader_cache              *cache,
+                                  const WGPUShaderModuleDescriptor *desc)
+{
+    struct key key = {0};
+    if (!key_module(&key, desc)) {
+        key_free(&key);
+        atomic_fetch_add(&cache->uncacheable, 1);
+        return wgpuDeviceCreateShaderModule(cache->device, desc);
+    }
+
+    uint64_t               hash   = key_hash(&key);
+    size_t                 index  = hash & cache->mask;
+    struct entry *_Atomic *bucket = &cache->buckets[index];
+    struct shard          *shard  = &cache->shards[index % SHARDS];
+    struct entry          *e      = find(
+            atomic_load_explicit(bucket, memory_order_acquire), &key, hash);
+
+    if (e == NULL) {
+        pthread_mutex_lock(&shard->lock);
+        struct entry *head = atomic_load(bucket);
+        e                  = find(head, &key, hash);
+        if (e == NULL) {
+            e = entry_new(&key, hash);
+            if (e == NULL) {
+                pthread_mutex_unlock(&shard->lock);
+                key_free(&key);
+                atomic_fetch_add(&cache->uncacheable, 1);
+                return wgpuDeviceCreateShaderModule(cache->device, desc);
+            }
+            e->next = head;
+            atomic_store_explicit(bucket, e, memory_order_release);
+            pthread_mutex_unlock(&shard->lock);
+
+            /* Created outside the lock: other sources in the shard keep
+             * going, and callers of this one wait on the entry. */
+            WGPUShaderModule module =
+                    wgpuDeviceCreateShaderModule(cache->device, desc);
+            pthread_mutex_lock(&shard->lock);
+            e->module = module;
+            atomic_store_explicit(&e->ready, true, memory_order_release);
+            pthread_cond_broadcast(&shard->created);
+            pthread_mutex_unlock(&shard->lock);
+
+            atomic_fetch_add(&cache->misses, 1);
+            atomic_fetch_add(&cache->entries, 1);
+            atomic_fetch_add(&cache->key_bytes, key.size);
+            key_free(&key);
+            if (module) {
+                wgpuShaderModuleAddRef(module);
+            }
+            return module;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    key_free(&key);
+
+    if (!atomic_load_explicit(&e->ready, memory_order_acquire)) {
+        atomic_fetch_add(&cache->waits, 1);
+        pthread_mutex_lock(&shard->lock);
+        while (!atomic_load(&e->ready)) {
+            pthread_cond_wait(&shard->created, &shard->lock);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    atomic_fetch_add(&cache->hits, 1);
+    if (e->module) {
+        wgpuShaderModuleAddRef(e->module);
+    }
+    return e->module;
+}
+
+void shader_cache_stats(struct shader_cache       *cache,
+                        struct shader_cache_stats *out)
+{
+    out->hits         = atomic_load(&cache->hits);
+    out->misses       = atomic_load(&cache->misses);
+    out->waits        = atomic_load(&cache->waits);
+    out->uncacheable  = atomic_load(&cache->uncacheable);
+    out->entries      = atomic_load(&cache->entries);
+    out->key_bytes    = atomic_load(&cache->key_bytes);
+}
+
+void shader_cache_destroy(struct shader_cache *cache)
+{
+    for (size_t i = 0; i <= cache->mask; ++i) {
+        struct entry *e = atomic_load(&cache->buckets[i]);
+        while (e) {
+            struct entry *next = e->next;
+            if (e->module) {
+                wgpuShaderModuleRelease(e->module);
+            }
+            free(e);
+            e = next;
+        }
+    }
+    for (int i = 0; i < SHARDS; ++i) {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        pthread_cond_destroy(&cache->shards[i].created);
+    }
+    wgpuDeviceRelease(cache->device);
+    free(cache->buckets);
+    free(cache);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,61 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SHADER_CACHE_H
+#define WGPU_SHADER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define SHADER_CACHE_BUCKETS_DEFAULT 1024
+
+struct shader_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t waits;       /* hits that waited for another thread to create */
+    uint64_t uncacheable; /* descriptors with chained structs we can't key */
+    uint64_t entries;
+    uint64_t key_bytes;   /* serialized keys held by the entries */
+};
+
+struct shader_cache;
+
+/* Interns shader modules for one device. buckets is rounded up to a power of
+ * two, 0 picks SHADER_CACHE_BUCKETS_DEFAULT. Misses create modules on the
+ * calling threads, so the device needs ImplicitDeviceSynchronization.
+ * Returns NULL without it, or on failure. */
+struct shader_cache *shader_cache_create(WGPUDevice device, size_t buckets);
+
+/* Returns the module for desc's WGSL or SPIR-V source and compilation
+ * options, creating it on first use. The caller owns one reference and
+ * releases it with wgpuShaderModuleRelease. The label is not part of the
+ * key, so the first caller's label sticks. Hits are lock free; concurrent
+ * misses on the same source create the module once. */
+WGPUShaderModule shader_cache_get(struct shader_cache              *cache,
+                                  const WGPUShaderModuleDescriptor *desc);
+
+void shader_cache_stats(struct shader_cache       *cache,
+                        struct shader_cache_stats *out);
+
+/* Drops the cache's references; modules handed out stay valid. */
+void shader_cache_destroy(struct shader_cache *cache);
+
+#endif /* ifndef WGPU_SHADER_CACHE_H */
@@ -0,0 +1,407 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "shared_cache.h"
+#include "writer.h"
+
+#define SEGMENT_MAGIC   0x4D47455355504757ull /* "WGPUSEGM" */
+#define SEGMENT_VERSION 1
+#define BUNDLE_MAGIC    0x4C444E4255504757ull /* "WGPUBNDL" */
+#define BUNDLE_VERSION  1
+#define SHARED_SEED     0x7368617265646361ull
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+               "the segment index needs address-free 64-bit atomics");
+
+/* Everything below the header is shared by every attached process, so all
+ * mutable fields are atomics and no process ever takes a lock after the
+ * segment is formatted. */
+struct segment_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t size;
+    uint64_t index_offset;
+    uint64_t index_mask;
+    uint64_t data_offset;
+
+    _Atomic uint64_t data_head;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t stores;
+    _Atomic uint64_t full;
+    _Atomic uint64_t entries;
+};
+
+/* hash is claimed first; record (an offset from the segment base) is
+ * published after the blob is written, so 0 means still in flight. */
+struct index_slot {
+    _Atomic uint64_t hash;
+    _Atomic uint64_t record;
+};
+
+struct record {
+    uint32_t key_size;
+    uint32_t value_size;
+};
+
+struct bundle_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct shared_cache {
+    uint8_t               *base;
+    size_t                 length;
+    struct segment_header *header;
+    struct index_slot     *index;
+};
+
+static uint64_t align8(uint64_t value)
+{
+    return (value + 7) & ~( uint64_t )7;
+}
+
+static uint64_t key_hash(const void *key, size_t key_size)
+{
+    uint64_t h = hash_bytes(key, key_size, SHARED_SEED);
+    return h == 0 ? 1 : h;
+}
+
+static bool lock_file(int fd, short type)
+{
+    struct flock lock = {.l_type = type, .l_whence = SEEK_SET};
+    return fcntl(fd, F_SETLKW, &lock) == 0;
+}
+
+static void format(uint8_t *base, uint64_t size, uint64_t entries)
+{
+    struct segment_header *header = ( struct segment_header * )base;
+    memset(base, 0, align8(sizeof(*header)) + entries * sizeof(struct index_slot));
+    header->version      = SEGMENT_VERSION;
+    header->header_size  = sizeof(*header);
+    header->size         = size;
+    header->index_offset = align8(sizeof(*header));
+    header->index_mask   = entries - 1;
+    header->data_offset =
+            header->index_offset + entries * sizeof(struct index_slot);
+    atomic_store(&header->data_head, header->data_offset);
+    /* Attachers check the magic last. */
+    header->magic = SEGMENT_MAGIC;
+}
+
+struct shared_cache *shared_cache_attach(const struct shared_cache_options *opts)
+{
+    uint64_t entries = 16;
+    uint64_t wanted  = opts->index_entries ? opts->index_entries
+                                           : SHARED_CACHE_ENTRIES_DEFAULT;
+    while (entries < wanted) {
+        entries <<= 1;
+    }
+    uint64_t size = opts->size_bytes ? opts->size_bytes
+                                     : SHARED_CACHE_SIZE_DEFAULT;
+    if (size < align8(sizeof(struct segment_header)) +
+                       entries * sizeof(struct index_slot) + 4096) {
+        return NULL;
+    }
+
+    int fd = open(opts->path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    /* The file lock only serialises formatting a fresh segment. */
+    if (!lock_file(fd, F_WRLCK)) {
+        close(fd);
+        return NULL;
+    }
+
+    struct stat st;
+    bool        fresh = fstat(fd, &st) == 0 && st.st_size == 0;
+    if (fresh && ftruncate(fd, ( off_t )size) != 0) {
+        fresh = false;
+        size  = 0;
+    } else if (!fresh) {
+        size = ( uint64_t )st.st_size;
+    }
+
+    void *addr = MAP_FAILED;
+    if (size >= sizeof(struct segment_header)) {
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (addr != MAP_FAILED && fresh) {
+        format(addr, size, entries);
+    }
+    lock_file(fd, F_UNLCK);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    struct segment_header *header = addr;
+    if (header->magic != SEGMENT_MAGIC || header->version != SEGMENT_VERSION ||
+        header->header_size != sizeof(*header) || header->size != size) {
+        munmap(addr, size);
+        return NULL;
+    }
+
+    struct shared_cache *cache = malloc(sizeof(*cache));
+    if (cache == NULL) {
+        munmap(addr, size);
+        return NULL;
+    }
+    cache->base   = addr;
+    cache->length = size;
+    cache->header = header;
+    cache->index  = ( struct index_slot * )(cache->base + header->index_offset);
+    return cache;
+}
+
+void shared_cache_detach(struct shared_cache *cache)
+{
+    munmap(cache->base, cache->length);
+    free(cache);
+}
+
+/* Returns the record at offset if it lies inside the data region. */
+static const struct record *record_at(const struct shared_cache *cache,
+                                      uint64_t                   offset)
+{
+    const struct segment_header *header = cache->header;
+    if (offset < header->data_offset ||
+        offset > header->size - sizeof(struct record)) {
+        return NULL;
+    }
+    const struct record *rec = ( const struct record * )(cache->base + offset);
+    if (( uint64_t )rec->key_size + rec->value_size >
+        header->size - offset - sizeof(*rec)) {
+        return NULL;
+    }
+    return rec;
+}
+
+size_t shared_cache_load(struct shared_cache *cache, const void *key,
+                         size_t key_size, void *value, size_t value_size)
+{
+    struct segment_header *header = cache->header;
+    uint64_t               h      = key_hash(key, key_size);
+
+    for (uint64_t i = 0; i <= header->index_mask; ++i) {
+        struct index_slot *slot = &cache->index[(h + i) & header->index_mask];
+        uint64_t           seen = atomic_load(&slot->hash);
+        if (seen == 0) {
+            break;
+        }
+        if (seen != h) {
+            continue;
+        }
+        const struct record *rec = record_at(
+                cache, atomic_load_explicit(&slot->record,
+                                            memory_order_acquire));
+        if (rec == NULL || rec->key_size != key_size ||
+            memcmp(rec + 1, key, key_size) != 0) {
+            break;
+        }
+        if (value != NULL && value_size >= rec->value_size) {
+            memcpy(value, ( const uint8_t * )(rec + 1) + key_size,
+                   rec->value_size);
+            atomic_fetch_add(&header->hits, 1);
+        }
+        return rec->value_size;
+    }
+    atomic_fetch_add(&header->misses, 1);
+    return 0;
+}
+
+void shared_cache_store(struct shared_cache *cache, const void *key,
+                        size_t key_size, const void *value, size_t value_size)
+{
+    struct segment_header *header = cache->header;
+    if (value_size == 0 || key_size > UINT32_MAX || value_size > UINT32_MAX) {
+        return;
+    }
+    uint64_t h = key_hash(key, key_size);
+
+    /* Skip the copy when another process already published this key. */
+    struct index_slot *slot = NULL;
+    for (uint64_t i = 0; i <= header->index_mask; ++i) {
+        struct index_slot *probe =
+                &cache->index[(h + i) & header->index_mask];
+        uint64_t expected = 0;
+        if (atomic_compare_exchange_strong(&probe->hash, &expected, h)) {
+            slot = probe;
+            break;
+        }
+        if (expected == h) {
+            return;
+        }
+    }
+    if (slot == NULL) {
+        atomic_fetch_add(&header->full, 1);
+        return;
+    }
+
+    uint64_t length = align8(sizeof(struct record) + key_size + value_size);
+    uint64_t offset = atomic_fetch_add(&header->data_head, length);
+    if (offset > header->size || length > header->size - offset) {
+        /* The slot stays claimed with no record, which readers treat as a
+         * miss; a full segment is recreated, not compacted. */
+        atomic_fetch_add(&header->full, 1);
+        return;
+    }
+
+    struct record *rec = ( struct record * )(cache->base + offset);
+    rec->key_size      = ( uint32_t )key_size;
+    rec->value_size    = ( uint32_t )value_size;
+    memcpy(rec + 1, key, key_size);
+    memcpy(( uint8_t * )(rec + 1) + key_size, value, value_size);
+    atomic_store_explicit(&slot->record, offset, memory_order_release);
+
+    atomic_fetch_add(&header->entries, 1);
+    atomic_fetch_add(&header->stores, 1);
+}
+
+static size_t load_data(const void *key, size_t key_size, void *value,
+                        size_t value_size, void *userdata)
+{
+    return shared_cache_load(userdata, key, key_size, value, value_size);
+}
+
+static void store_data(const void *key, size_t key_size, const void *value,
+                       size_t value_size, void *userdata)
+{
+    shared_cache_store(userdata, key, key_size, value, value_size);
+}
+
+void shared_cache_descriptor(struct shared_cache           *cache,
+                             WGPUDawnCacheDeviceDescriptor *desc,
+                             WGPUStringView                 isolation_key)
+{
+    memset(desc, 0, sizeof(*desc));
+    desc->chain.sType       = WGPUSType_DawnCacheDeviceDescriptor;
+    desc->isolationKey      = isolation_key;
+    desc->loadDataFunction  = load_data;
+    desc->storeDataFunction = store_data;
+    desc->functionUserdata  = cache;
+}
+
+bool shared_cache_export(struct shared_cache *cache, const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct writer *w = malloc(sizeof(*w));
+    if (w == NULL) {
+        close(fd);
+        return false;
+    }
+    writer_init(w, fd);
+
+    struct bundle_header bundle = {.magic   = BUNDLE_MAGIC,
+                                   .version = BUNDLE_VERSION};
+    writer_bytes(w, &bundle, sizeof(bundle));
+    for (uint64_t i = 0; i <= cache->header->index_mask; ++i) {
+        const struct record *rec = record_at(
+                cache, atomic_load_explicit(&cache->index[i].record,
+                                            memory_order_acquire));
+        if (rec == NULL) {
+            continue;
+        }
+        uint64_t length = sizeof(*rec) + rec->key_size + rec->value_size;
+        writer_bytes(w, rec, length);
+        writer_zeros(w, align8(length) - length);
+    }
+    /* An empty record terminates the bundle. */
+    writer_zeros(w, sizeof(struct record));
+
+    bool ok = writer_flush(w);
+    free(w);
+    return close(fd) == 0 && ok;
+}
+
+size_t shared_cache_import(struct shared_cache *cache, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    void       *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 &&
+        ( size_t )st.st_size >= sizeof(struct bundle_header)) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return 0;
+    }
+
+    const uint8_t              *base   = addr;
+    const struct bundle_header *bundle = addr;
+    size_t                      count  = 0;
+    if (bundle->magic == BUNDLE_MAGIC && bundle->version == BUNDLE_VERSION) {
+        uint64_t offset = sizeof(*bundle);
+        while (offset + sizeof(struct record) <= ( uint64_t )st.st_size) {
+            const struct record *rec = ( const struct record * )(base + offset);
+            uint64_t payload = ( uint64_t )rec->key_size + rec->value_size;
+            if (rec->key_size == 0 ||
+                payload > ( uint64_t )st.st_size - offset - sizeof(*rec)) {
+                break;
+            }
+            const uint8_t *key = ( const uint8_t * )(rec + 1);
+            shared_cache_store(cache, key, rec->key_size, key + rec->key_size,
+                               rec->value_size);
+            offset += align8(sizeof(*rec) + payload);
+            ++count;
+        }
+    }
+    munmap(addr, st.st_size);
+    return count;
+}
+
+void shared_cache_stats(struct shared_cache       *cache,
+                        struct shared_cache_stats *out)
+{
+    struct segment_header *header = cache->header;
+    uint64_t               head   = atomic_load(&header->data_head);
+
+    out->hits        = atomic_load(&header->hits);
+    out->misses      = atomic_load(&header->misses);
+    out->stores      = atomic_load(&header->stores);
+    out->full        = atomic_load(&header->full);
+    out->entries     = atomic_load(&header->entries);
+    out->bytes_used  = (head < header->size ? head : header->size) -
+                      header->data_offset;
+    out->bytes_total = header->size - header->data_offset;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,78 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SHARED_CACHE_H
+#define WGPU_SHARED_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define SHARED_CACHE_SIZE_DEFAULT    (256ull * 1024 * 1024)
+#define SHARED_CACHE_ENTRIES_DEFAULT 16384
+
+struct shared_cache_options {
+    const char *path;          /* segment file, e.g. under /dev/shm */
+    uint64_t    size_bytes;    /* only used by whoever creates it */
+    size_t      index_entries; /* likewise; rounded up to a power of two */
+};
+
+/* Counters live in the segment, so they are host wide. */
+struct shared_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t full;
+    uint64_t entries;
+    uint64_t bytes_used;
+    uint64_t bytes_total;
+};
+
+struct shared_cache;
+
+/* Maps the segment at path, creating and formatting it if this is the first
+ * process to attach. Returns NULL on failure or a segment of another
+ * layout version. */
+struct shared_cache *shared_cache_attach(const struct shared_cache_options *);
+void                 shared_cache_detach(struct shared_cache *cache);
+
+/* WGPUDawnLoadCacheDataFunction contract; lock free. */
+size_t shared_cache_load(struct shared_cache *cache, const void *key,
+                         size_t key_size, void *value, size_t value_size);
+
+/* Appends the blob and publishes it in the index; lock free. The first
+ * store of a key wins, and stores into a full segment are dropped. */
+void shared_cache_store(struct shared_cache *cache, const void *key,
+                        size_t key_size, const void *value, size_t value_size);
+
+void shared_cache_descriptor(struct shared_cache           *cache,
+                             WGPUDawnCacheDeviceDescriptor *desc,
+                             WGPUStringView                 isolation_key);
+
+/* Bundles are a flat list of (key, value) records for shipping a warm cache
+ * with a deployment. Import returns the number of records it stored. */
+bool   shared_cache_export(struct shared_cache *cache, const char *path);
+size_t shared_cache_import(struct shared_cache *cache, const char *path);
+
+void shared_cache_stats(struct shared_cache       *cache,
+                        struct shared_cache_stats *out);
+
+#endif /* ifndef WGPU_SHARED_CACHE_H */
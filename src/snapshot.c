@@ -0,0 +1,314 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+#ifndef WGPU_DAWN_LIBRARY
+#define WGPU_DAWN_LIBRARY ""
+#endif
+
+#define SECTION_ALIGN 8
+
+static size_t align_up(size_t value)
+{
+    return (value + SECTION_ALIGN - 1) & ~( size_t )(SECTION_ALIGN - 1);
+}
+
+static uint64_t hash_file(uint64_t h, const char *path, size_t length)
+{
+    char name[4096];
+    if (length == 0 || length >= sizeof(name)) {
+        return h;
+    }
+    memcpy(name, path, length);
+    name[length] = '\0';
+
+    struct stat st;
+    uint64_t    id[4] = {0};
+    if (stat(name, &st) == 0) {
+        id[0] = ( uint64_t )st.st_dev;
+        id[1] = ( uint64_t )st.st_ino;
+        id[2] = ( uint64_t )st.st_size;
+        id[3] = ( uint64_t )st.st_mtime;
+    }
+    h = caps_hash(h, name, length);
+    return caps_hash(h, id, sizeof(id));
+}
+
+uint64_t snapshot_fingerprint(void)
+{
+    uint32_t layout[3] = {SNAPSHOT_VERSION, sizeof(struct snapshot_header),
+                          sizeof(WGPULimits)};
+    uint64_t h         = caps_hash(CAPS_HASH_INIT, layout, sizeof(layout));
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        h = caps_hash(h, uts.sysname, strlen(uts.sysname));
+        h = caps_hash(h, uts.release, strlen(uts.release));
+        h = caps_hash(h, uts.version, strlen(uts.version));
+        h = caps_hash(h, uts.machine, strlen(uts.machine));
+    }
+
+    h = hash_file(h, WGPU_DAWN_LIBRARY, strlen(WGPU_DAWN_LIBRARY));
+
+    const char *files = getenv(SNAPSHOT_DRIVER_FILES_ENV);
+    while (files != NULL && *files != '\0') {
+        const char *end = strchr(files, ':');
+        size_t length   = end != NULL ? ( size_t )(end - files) : strlen(files);
+        h               = hash_file(h, files, length);
+        files           = end != NULL ? end + 1 : NULL;
+    }
+    return h;
+}
+
+static struct snapshot_section place(size_t *offset, size_t length,
+                                     size_t count, bool terminated)
+{
+    struct snapshot_section section = {.offset = *offset, .count = count};
+    *offset = align_up(*offset + length + (terminated ? 1 : 0));
+    return section;
+}
+
+static void emit(struct writer *w, size_t *offset,
+                 struct snapshot_section section, const void *data,
+                 size_t length, bool terminated)
+{
+    writer_zeros(w, section.offset - *offset);
+    writer_bytes(w, data, length);
+    if (terminated) {
+        writer_zeros(w, 1);
+    }
+    *offset = section.offset + length + (terminated ? 1 : 0);
+}
+
+void snapshot_encode(struct writer *w, uint64_t fingerprint,
+                     const struct adapter_caps *caps)
+{
+    struct snapshot_header header = {
+            .magic               = SNAPSHOT_MAGIC,
+            .version             = SNAPSHOT_VERSION,
+            .header_size         = sizeof(struct snapshot_header),
+            .fingerprint         = fingerprint,
+            .adapter_fingerprint = caps_fingerprint(caps),
+            .vendor_id           = caps->vendor_id,
+            .device_id           = caps->device_id,
+            .backend_type        = caps->backend_type,
+            .adapter_type        = caps->adapter_type,
+            .subgroup_min_size   = caps->subgroup_min_size,
+            .subgroup_max_size   = caps->subgroup_max_size,
+            .power_preference    = caps->power_preference,
+            .limits_size         = sizeof(WGPULimits),
+    };
+
+    size_t features_size = caps->feature_count * sizeof(WGPUFeatureName);
+    size_t heaps_size    = caps->heap_count * sizeof(WGPUMemoryHeapInfo);
+    size_t configs_size  = caps->config_count *
+                          sizeof(WGPUSubgroupMatrixConfig);
+
+    size_t offset       = align_up(sizeof(header));
+    header.vendor       = place(&offset, caps->vendor.length,
+                                caps->vendor.length, true);
+    header.architecture = place(&offset, caps->architecture.length,
+                                caps->architecture.length, true);
+    header.device       = place(&offset, caps->device.length,
+                                caps->device.length, true);
+    header.description  = place(&offset, caps->description.length,
+                                caps->description.length, true);
+    header.features     = place(&offset, features_size, caps->feature_count,
+                                false);
+    header.limits       = place(&offset, sizeof(WGPULimits), 1, false);
+    header.heaps   = place(&offset, heaps_size, caps->heap_count, false);
+    header.configs = place(&offset, configs_size, caps->config_count, false);
+    header.size    = offset;
+
+    WGPULimits limits  = caps->limits;
+    limits.nextInChain = NULL;
+
+    size_t written = 0;
+    writer_bytes(w, &header, sizeof(header));
+    written = sizeof(header);
+    emit(w, &written, header.vendor, caps->vendor.data, caps->vendor.length,
+         true);
+    emit(w, &written, header.architecture, caps->architecture.data,
+         caps->architecture.length, true);
+    emit(w, &written, header.device, caps->device.data, caps->device.length,
+         true);
+    emit(w, &written, header.description, caps->description.data,
+         caps->description.length, true);
+    emit(w, &written, header.features, caps->features, features_size, false);
+    emit(w, &written, header.limits, &limits, sizeof(limits), false);
+    emit(w, &written, header.heaps, caps->heaps, heaps_size, false);
+    emit(w, &written, header.configs, caps->configs, configs_size, false);
+    writer_zeros(w, header.size - written);
+}
+
+bool snapshot_write(const char *path, uint64_t fingerprint,
+                    const struct adapter_caps *caps)
+{
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, ( long )getpid()) >=
+        ( int )sizeof(tmp)) {
+        return false;
+    }
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct writer w;
+    writer_init(&w, fd);
+    snapshot_encode(&w, fingerprint, caps);
+    bool ok = writer_flush(&w);
+    ok      = close(fd) == 0 && ok;
+    ok      = ok && rename(tmp, path) == 0;
+    if (!ok) {
+        unlink(tmp);
+    }
+    return ok;
+}
+
+static bool section_valid(const struct snapshot_header *header,
+                          struct snapshot_section section, size_t elem_size,
+                          bool terminated)
+{
+    if (section.offset % SECTION_ALIGN != 0 || section.offset > header->size) {
+        return false;
+    }
+    uint64_t available = header->size - section.offset;
+    if (section.count > available / elem_size) {
+        return false;
+    }
+    if (terminated) {
+        return section.count < available &&
+               (( const uint8_t * )header)[section.offset + section.count] ==
+                       '\0';
+    }
+    return true;
+}
+
+static WGPUStringView section_string(const uint8_t          *base,
+                                     struct snapshot_section section)
+{
+    return (WGPUStringView){.data   = ( const char * )(base + section.offset),
+                            .length = section.count};
+}
+
+bool snapshot_map(struct snapshot *snap, const char *path, uint64_t fingerprint)
+{
+    memset(snap, 0, sizeof(*snap));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        ( size_t )st.st_size < sizeof(struct snapshot_header)) {
+        close(fd);
+        return false;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const uint8_t                *base   = addr;
+    const struct snapshot_header *header = addr;
+    bool valid = header->magic == SNAPSHOT_MAGIC &&
+                 header->version == SNAPSHOT_VERSION &&
+                 header->header_size == sizeof(struct snapshot_header) &&
+                 header->size == ( uint64_t )st.st_size &&
+                 header->fingerprint == fingerprint &&
+                 header->limits_size == sizeof(WGPULimits) &&
+                 section_valid(header, header->vendor, 1, true) &&
+                 section_valid(header, header->architecture, 1, true) &&
+                 section_valid(header, header->device, 1, true) &&
+                 section_valid(header, header->description, 1, true) &&
+                 section_valid(header, header->features,
+                               sizeof(WGPUFeatureName), false) &&
+                 header->limits.count == 1 &&
+                 section_valid(header, header->limits, sizeof(WGPULimits),
+                               false) &&
+                 section_valid(header, header->heaps,
+                               sizeof(WGPUMemoryHeapInfo), false) &&
+                 section_valid(header, header->configs,
+                               sizeof(WGPUSubgroupMatrixConfig), false);
+    if (!valid) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+
+    struct adapter_caps *caps = &snap->caps;
+    caps->vendor_id           = header->vendor_id;
+    caps->device_id           = header->device_id;
+    caps->backend_type        = ( WGPUBackendType )header->backend_type;
+    caps->adapter_type        = ( WGPUAdapterType )header->adapter_type;
+    caps->subgroup_min_size   = header->subgroup_min_size;
+    caps->subgroup_max_size   = header->subgroup_max_size;
+    caps->power_preference = ( WGPUPowerPreference )header->power_preference;
+
+    caps->vendor       = section_string(base, header->vendor);
+    caps->architecture = section_string(base, header->architecture);
+    caps->device       = section_string(base, header->device);
+    caps->description  = section_string(base, header->description);
+
+    caps->feature_count = header->features.count;
+    caps->features =
+            ( const WGPUFeatureName * )(base + header->features.offset);
+    memcpy(&caps->limits, base + header->limits.offset, sizeof(WGPULimits));
+    caps->heap_count = header->heaps.count;
+    caps->heaps = ( const WGPUMemoryHeapInfo * )(base + header->heaps.offset);
+    caps->config_count = header->configs.count;
+    caps->configs      = ( const WGPUSubgroupMatrixConfig * )(base +
+                                                         header->configs.offset);
+
+    /* The stored strings must still hash to the stored fingerprint, or the
+     * file was altered after it was written. */
+    if (caps_fingerprint(caps) != header->adapter_fingerprint) {
+        munmap(addr, st.st_size);
+        memset(snap, 0, sizeof(*snap));
+        return false;
+    }
+
+    snap->addr   = addr;
+    snap->length = st.st_size;
+    return true;
+}
+
+void snapshot_unmap(struct snapshot *snap)
+{
+    if (snap->addr != NULL) {
+        munmap(snap->addr, snap->length);
+    }
+    memset(snap, 0, sizeof(*snap));
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,101 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SNAPSHOT_H
+#define WGPU_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "caps.h"
+#include "writer.h"
+
+#define SNAPSHOT_MAGIC   0x50414E5355504757ull /* "WGPUSNAP" */
+#define SNAPSHOT_VERSION 1
+
+/* Colon separated list of extra files (driver libraries, ICD manifests)
+ * whose identity is folded into the environment fingerprint. */
+#define SNAPSHOT_DRIVER_FILES_ENV "WGPU_SNAPSHOT_DRIVER_FILES"
+
+struct snapshot_section {
+    uint64_t offset;
+    uint64_t count;
+};
+
+/* On-disk layout, native endianness; everything after the header is
+ * addressed through the sections and is 8-byte aligned. */
+struct snapshot_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t size;
+    uint64_t fingerprint;
+    uint64_t adapter_fingerprint;
+
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t backend_type;
+    uint32_t adapter_type;
+    uint32_t subgroup_min_size;
+    uint32_t subgroup_max_size;
+    uint32_t power_preference;
+    uint32_t limits_size;
+
+    struct snapshot_section vendor;
+    struct snapshot_section architecture;
+    struct snapshot_section device;
+    struct snapshot_section description;
+    struct snapshot_section features;
+    struct snapshot_section limits;
+    struct snapshot_section heaps;
+    struct snapshot_section configs;
+};
+
+/* A mapped snapshot; caps points into the mapping and must not be passed to
+ * caps_free(). */
+struct snapshot {
+    void               *addr;
+    size_t              length;
+    struct adapter_caps caps;
+};
+
+/* Fingerprint of the environment a snapshot is valid for: the snapshot and
+ * struct layout versions, the kernel, the Dawn library in use and the files
+ * named by SNAPSHOT_DRIVER_FILES_ENV. Computed without touching the GPU, so
+ * list the driver libraries there for a driver update to invalidate it. */
+uint64_t snapshot_fingerprint(void);
+
+/* Emits caps in the snapshot layout, e.g. to stdout for --binary. */
+void snapshot_encode(struct writer *w, uint64_t fingerprint,
+                     const struct adapter_caps *caps);
+
+/* Writes caps atomically (temporary file and rename). */
+bool snapshot_write(const char *path, uint64_t fingerprint,
+                    const struct adapter_caps *caps);
+
+/* Maps path read-only. Fails, leaving snap zeroed, when the file is missing,
+ * malformed, was written under a different fingerprint or was altered
+ * after it was written. */
+bool snapshot_map(struct snapshot *snap, const char *path,
+                  uint64_t fingerprint);
+
+void snapshot_unmap(struct snapshot *snap);
+
+#endif /* ifndef WGPU_SNAPSHOT_H */
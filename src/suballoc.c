@@ -0,0 +1,635 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "suballoc.h"
+
+#define NO_INDEX         UINT32_MAX
+#define CLASS_MIN        256
+#define CLASS_MAX        16
+#define SLAB_OBJECTS_MAX (SUBALLOC_CHUNK_SIZE / CLASS_MIN)
+#define RANGES_PER_PAGE  256
+#define COPY_ALIGNMENT   4
+
+/* Each backing buffer is a buddy allocator over SUBALLOC_CHUNK_SIZE leaves.
+ * longest[] is the usual implicit tree: for every node, one plus the
+ * largest free order in its subtree, or 0 if nothing in it is free. */
+struct block {
+    WGPUBuffer buffer;
+    uint64_t   used;
+    bool       draining;
+    uint8_t   *longest;
+};
+
+/* A chunk cut into equal objects of one class. Slabs with free objects are
+ * kept on a per-class list. */
+struct slab {
+    uint32_t block;
+    uint32_t prev;
+    uint32_t next;
+    uint16_t used;
+    uint16_t capacity;
+    uint8_t  cls;
+    bool     partial;
+    uint64_t offset;
+    uint64_t bits[SLAB_OBJECTS_MAX / 64];
+};
+
+struct suballoc {
+    WGPUDevice      device;
+    WGPUBufferUsage usage;
+    uint64_t        block_size;
+    uint8_t         block_order;
+    uint8_t         chunk_order;
+    uint8_t         class_order; /* log2 of the smallest class */
+    uint8_t         class_count;
+    size_t          max_blocks;
+
+    pthread_mutex_t lock;
+
+    struct block *blocks;
+    size_t        block_count;
+
+    struct slab *slabs;
+    size_t       slab_count;
+    uint32_t     free_slab;
+    uint32_t     partial[CLASS_MAX];
+
+    /* Ranges live in fixed pages so the pointers handed out stay put. */
+    struct suballoc_range **pages;
+    size_t                  page_count;
+    uint32_t               *free_ranges;
+    size_t                  free_range_count;
+
+    uint64_t requested;
+    uint64_t allocated;
+    size_t   ranges;
+};
+
+static uint8_t ceil_log2(uint64_t value)
+{
+    uint8_t order = 0;
+    while ((1ull << order) < value) {
+        ++order;
+    }
+    return order;
+}
+
+static uint8_t max_u8(uint8_t a, uint8_t b)
+{
+    return a > b ? a : b;
+}
+
+/* Recomputes the parents of node i, merging buddies that are both free. */
+static void buddy_update(uint8_t *longest, size_t i, uint8_t order)
+{
+    while (i > 0) {
+        i = (i - 1) / 2;
+        ++order;
+        uint8_t left  = longest[2 * i + 1];
+        uint8_t right = longest[2 * i + 2];
+        longest[i]    = left == order && right == order ? order + 1
+                                                        : max_u8(left, right);
+    }
+}
+
+static uint64_t buddy_alloc(struct suballoc *a, struct block *b, uint8_t order)
+{
+    if (b->longest[0] < order + 1) {
+        return UINT64_MAX;
+    }
+    size_t  i          = 0;
+    uint8_t node_order = a->block_order;
+    while (node_order != order) {
+        i = b->longest[2 * i + 1] >= order + 1 ? 2 * i + 1 : 2 * i + 2;
+        --node_order;
+    }
+    b->longest[i] = 0;
+    buddy_update(b->longest, i, order);
+    b->used += 1ull << order;
+
+    size_t first = (( size_t )1 << (a->block_order - order)) - 1;
+    return ( uint64_t )(i - first) << order;
+}
+
+static void buddy_free(struct suballoc *a, struct block *b, uint64_t offset,
+                       uint8_t order)
+{
+    size_t first  = (( size_t )1 << (a->block_order - order)) - 1;
+    size_t i      = first + ( size_t )(offset >> order);
+    b->longest[i] = order + 1;
+    buddy_update(b->longest, i, order);
+    b->used -= 1ull << order;
+}
+
+static bool block_add(struct suballoc *a)
+{
+    size_t index = a->block_count;
+    for (size_t i = 0; i < a->block_count; ++i) {
+        if (a->blocks[i].buffer == NULL) {
+            index = i;
+            break;
+        }
+    }
+    if (index == a->block_count) {
+        if (a->max_blocks && a->block_count == a->max_blocks) {
+            return false;
+        }
+        struct block *blocks =
+                realloc(a->blocks, (a->block_count + 1) * sizeof(*blocks));
+        if (blocks == NULL) {
+            return false;
+        }
+        a->blocks = blocks;
+        memset(&a->blocks[a->block_count++], 0, sizeof(*blocks));
+    }
+
+    struct block *b      = &a->blocks[index];
+    size_t        leaves = ( size_t )1 << (a->block_order - a->chunk_order);
+    b->longest           = malloc(2 * leaves - 1);
+    if (b->longest == NULL) {
+        return false;
+    }
+    /* Node i sits at depth floor(log2(i + 1)). */
+    for (size_t i = 0, depth = 0; i < 2 * leaves - 1; ++i) {
+        if (i + 1 == (( size_t )2 << depth)) {
+            ++depth;
+        }
+        b->longest[i] = ( uint8_t )(a->block_order - depth + 1);
+    }
+
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.label = (WGPUStringView){.data = "suballoc", .length = 8};
+    desc.usage = a->usage;
+    desc.size  = a->block_size;
+    b->buffer  = wgpuDeviceCreateBuffer(a->device, &desc);
+    if (b->buffer == NULL) {
+        free(b->longest);
+        b->longest = NULL;
+        return false;
+    }
+    b->used     = 0;
+    b->draining = false;
+    return true;
+}
+
+static void block_remove(struct block *b)
+{
+    wgpuBufferDestroy(b->buffer);
+    wgpuBufferRelease(b->buffer);
+    free(b->longest);
+    memset(b, 0, sizeof(*b));
+}
+
+/* First fit over the blocks that aren't being drained, so allocations pack
+ * towards the low blocks. */
+static bool chunk_alloc(struct suballoc *a, uint8_t order, uint32_t *block,
+                        uint64_t *offset)
+{
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (size_t i = 0; i < a->block_count; ++i) {
+            struct block *b = &a->blocks[i];
+            if (b->buffer == NULL || b->draining) {
+                continue;
+            }
+            *offset = buddy_alloc(a, b, order);
+            if (*offset != UINT64_MAX) {
+                *block = ( uint32_t )i;
+                return true;
+            }
+        }
+        if (attempt == 0 && !block_add(a)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+static void partial_unlink(struct suballoc *a, uint32_t index)
+{
+    struct slab *s = &a->slabs[index];
+    if (s->prev != NO_INDEX) {
+        a->slabs[s->prev].next = s->next;
+    } else {
+        a->partial[s->cls] = s->next;
+    }
+    if (s->next != NO_INDEX) {
+        a->slabs[s->next].prev = s->prev;
+    }
+    s->partial = false;
+}
+
+static void partial_push(struct suballoc *a, uint32_t index)
+{
+    struct slab *s = &a->slabs[index];
+    s->prev        = NO_INDEX;
+    s->next        = a->partial[s->cls];
+    if (s->next != NO_INDEX) {
+        a->slabs[s->next].prev = index;
+    }
+    a->partial[s->cls] = index;
+    s->partial         = true;
+}
+
+static uint32_t slab_new(struct suballoc *a, uint8_t cls)
+{
+    uint32_t block;
+    uint64_t offset;
+    if (!chunk_alloc(a, a->chunk_order, &block, &offset)) {
+        return NO_INDEX;
+    }
+    uint32_t index = a->free_slab;
+    if (index != NO_INDEX) {
+        a->free_slab = a->slabs[index].next;
+    } else {
+        struct slab *slabs =
+                realloc(a->slabs, (a->slab_count + 1) * sizeof(*slabs));
+        if (slabs == NULL) {
+            buddy_free(a, &a->blocks[block], offset, a->chunk_order);
+            return NO_INDEX;
+        }
+        a->slabs = slabs;
+        index    = ( uint32_t )a->slab_count++;
+    }
+    struct slab *s = &a->slabs[index];
+    memset(s, 0, sizeof(*s));
+    s->block    = block;
+    s->offset   = offset;
+    s->cls      = cls;
+    s->capacity = ( uint16_t )(SUBALLOC_CHUNK_SIZE >> (a->class_order + cls));
+    partial_push(a, index);
+    return index;
+}
+
+/* Fills range->buffer, offset, block, slab and order; size must be set. */
+static bool place(struct suballoc *a, struct suballoc_range *range)
+{
+    uint8_t order = max_u8(ceil_log2(range->size), a->class_order);
+    if (order - a->class_order < a->class_count) {
+        uint8_t  cls   = order - a->class_order;
+        uint32_t index = a->partial[cls];
+        while (index != NO_INDEX && a->blocks[a->slabs[index].block].draining) {
+            index = a->slabs[index].next;
+        }
+        if (index == NO_INDEX && (index = slab_new(a, cls)) == NO_INDEX) {
+            return false;
+        }
+        struct slab *s = &a->slabs[index];
+        uint32_t     object = 0;
+        while (s->bits[object / 64] & (1ull << (object % 64))) {
+            ++object;
+        }
+        s->bits[object / 64] |= 1ull << (object % 64);
+        if (++s->used == s->capacity) {
+            partial_unlink(a, index);
+        }
+        range->block  = s->block;
+        range->slab   = index;
+        range->order  = order;
+        range->offset = s->offset + (( uint64_t )object << order);
+    } else {
+        order = max_u8(order, a->chunk_order);
+        if (order > a->block_order ||
+            !chunk_alloc(a, order, &range->block, &range->offset)) {
+            return false;
+        }
+        range->slab  = NO_INDEX;
+        range->order = order;
+    }
+    range->buffer = a->blocks[range->block].buffer;
+    a->allocated += 1ull << order;
+    return true;
+}
+
+static void unplace(struct suballoc *a, const struct suballoc_range *range)
+{
+    a->allocated -= 1ull << range->order;
+    if (range->slab == NO_INDEX) {
+        buddy_free(a, &a->blocks[range->block], range->offset, range->order);
+        return;
+    }
+
+    struct slab *s = &a->slabs[range->slab];
+    uint32_t     object =
+            ( uint32_t )((range->offset - s->offset) >> range->order);
+    s->bits[object / 64] &= ~(1ull << (object % 64));
+    if (s->used-- == s->capacity) {
+        partial_push(a, range->slab);
+    }
+    if (s->used == 0) {
+        partial_unlink(a, range->slab);
+        buddy_free(a, &a->blocks[s->block], s->offset, a->chunk_order);
+        s->next      = a->free_slab;
+        a->free_slab = range->slab;
+    }
+}
+
+static struct suballoc_range *range_at(struct suballoc *a, uint32_t index)
+{
+    return &a->pages[index / RANGES_PER_PAGE][index % RANGES_PER_PAGE];
+}
+
+static struct suballoc_range *range_new(struct suballoc *a)
+{
+    if (a->free_range_count == 0) {
+        struct suballoc_range **pages =
+                realloc(a->pages, (a->page_count + 1) * sizeof(*pages));
+        if (pages == NULL) {
+            return NULL;
+        }
+        a->pages = pages;
+        uint32_t *free_ranges =
+                realloc(a->free_ranges, (a->page_count + 1) * RANGES_PER_PAGE *
+                                                sizeof(*free_ranges));
+        if (free_ranges == NULL) {
+            return NULL;
+        }
+        a->free_ranges = free_ranges;
+        pages[a->page_count] = calloc(RANGES_PER_PAGE, sizeof(**pages));
+        if (pages[a->page_count] == NULL) {
+            return NULL;
+        }
+        for (uint32_t i = RANGES_PER_PAGE; i-- > 0;) {
+            uint32_t index = ( uint32_t )(a->page_count * RANGES_PER_PAGE + i);
+            pages[a->page_count][i].index         = index;
+            a->free_ranges[a->free_range_count++] = index;
+        }
+        ++a->page_count;
+    }
+    return range_at(a, a->free_ranges[--a->free_range_count]);
+}
+
+struct suballoc *suballoc_create(const struct suballoc_options *opts)
+{
+    uint64_t block_size = opts->block_size ? opts->block_size
+                                           : SUBALLOC_BLOCK_SIZE_DEFAULT;
+    if (block_size < SUBALLOC_CHUNK_SIZE ||
+        (block_size & (block_size - 1)) != 0) {
+        return NULL;
+    }
+    WGPULimits limits = WGPU_LIMITS_INIT;
+    if (wgpuDeviceGetLimits(opts->device, &limits) != WGPUStatus_Success ||
+        block_size > limits.maxBufferSize) {
+        return NULL;
+    }
+
+    uint64_t alignment = COPY_ALIGNMENT;
+    if ((opts->usage & WGPUBufferUsage_Storage) &&
+        limits.minStorageBufferOffsetAlignment > alignment) {
+        alignment = limits.minStorageBufferOffsetAlignment;
+    }
+    if ((opts->usage & WGPUBufferUsage_Uniform) &&
+        limits.minUniformBufferOffsetAlignment > alignment) {
+        alignment = limits.minUniformBufferOffsetAlignment;
+    }
+
+    struct suballoc *a = calloc(1, sizeof(*a));
+    if (a == NULL) {
+        return NULL;
+    }
+    a->device = opts->device;
+    a->usage  = opts->usage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+    a->block_size  = block_size;
+    a->block_order = ceil_log2(block_size);
+    a->chunk_order = ceil_log2(SUBALLOC_CHUNK_SIZE);
+    /* Power-of-two classes from the alignment up to a quarter chunk; every
+     * object offset is then a multiple of the alignment. */
+    a->class_order = ceil_log2(alignment > CLASS_MIN ? alignment : CLASS_MIN);
+    a->class_count = a->class_order + 2 <= a->chunk_order
+                             ? ( uint8_t )(a->chunk_order - 1 - a->class_order)
+                             : 0;
+    a->max_blocks = opts->max_blocks;
+    a->free_slab  = NO_INDEX;
+    for (int i = 0; i < CLASS_MAX; ++i) {
+        a->partial[i] = NO_INDEX;
+    }
+    pthread_mutex_init(&a->lock, NULL);
+    wgpuDeviceAddRef(a->device);
+    return a;
+}
+
+const struct suballoc_range *suballoc_alloc(struct suballoc *a, uint64_t size)
+{
+    if (size == 0 || size > a->block_size) {
+        return NULL;
+    }
+    pthread_mutex_lock(&a->lock);
+    struct suballoc_range *range = range_new(a);
+    if (range != NULL) {
+        range->size = size;
+        if (place(a, range)) {
+            range->live = true;
+            a->requested += size;
+            ++a->ranges;
+        } else {
+            a->free_ranges[a->free_range_count++] = range->index;
+            range                                  = NULL;
+        }
+    }
+    pthread_mutex_unlock(&a->lock);
+    return range;
+}
+
+void suballoc_free(struct suballoc *a, const struct suballoc_range *range)
+{
+    pthread_mutex_lock(&a->lock);
+    unplace(a, range);
+    a->requested -= range->size;
+    --a->ranges;
+    range_at(a, range->index)->live       = false;
+    a->free_ranges[a->free_range_count++] = range->index;
+    pthread_mutex_unlock(&a->lock);
+}
+
+void suballoc_report(struct suballoc *a, struct suballoc_report *out)
+{
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&a->lock);
+    for (size_t i = 0; i < a->block_count; ++i) {
+        const struct block *b = &a->blocks[i];
+        if (b->buffer == NULL) {
+            continue;
+        }
+        uint64_t largest = b->longest[0] ? 1ull << (b->longest[0] - 1) : 0;
+        ++out->blocks;
+        out->reserved += a->block_size;
+        out->free += a->block_size - b->used;
+        if (largest > out->largest_free) {
+            out->largest_free = largest;
+        }
+    }
+    for (size_t i = 0; i < a->slab_count; ++i) {
+        out->slabs += a->slabs[i].capacity > 0 && a->slabs[i].used > 0;
+    }
+    out->requested = a->requested;
+    out->allocated = a->allocated;
+    out->ranges    = a->ranges;
+    pthread_mutex_unlock(&a->lock);
+
+    if (out->allocated > 0) {
+        out->internal_permille = ( uint32_t )(
+                (out->allocated - out->requested) * 1000 / out->allocated);
+    }
+    if (out->free > 0) {
+        out->external_permille = ( uint32_t )(
+                (out->free - out->largest_free) * 1000 / out->free);
+    }
+}
+
+static void json_field(struct writer *w, const char *name, uint64_t value)
+{
+    writer_str(w, ",\"");
+    writer_str(w, name);
+    writer_str(w, "\":");
+    writer_u64(w, value);
+}
+
+void suballoc_json(struct writer *w, struct suballoc *a)
+{
+    struct suballoc_report r;
+    suballoc_report(a, &r);
+
+    writer_str(w, "{\"block_size\":");
+    writer_u64(w, a->block_size);
+    json_field(w, "blocks", r.blocks);
+    json_field(w, "reserved", r.reserved);
+    json_field(w, "requested", r.requested);
+    json_field(w, "allocated", r.allocated);
+    json_field(w, "free", r.free);
+    json_field(w, "largest_free", r.largest_free);
+    json_field(w, "slabs", r.slabs);
+    json_field(w, "ranges", r.ranges);
+    json_field(w, "internal_permille", r.internal_permille);
+    json_field(w, "external_permille", r.external_permille);
+
+    writer_str(w, ",\"occupancy_permille\":[");
+    pthread_mutex_lock(&a->lock);
+    bool first = true;
+    for (size_t i = 0; i < a->block_count; ++i) {
+        if (a->blocks[i].buffer == NULL) {
+            continue;
+        }
+        writer_str(w, first ? "" : ",");
+        writer_u64(w, a->blocks[i].used * 1000 / a->block_size);
+        first = false;
+    }
+    pthread_mutex_unlock(&a->lock);
+    writer_str(w, "]}\n");
+}
+
+size_t suballoc_defrag(struct suballoc *a, WGPUQueue queue,
+                       uint32_t max_permille, suballoc_moved_fn moved,
+                       void *userdata)
+{
+    pthread_mutex_lock(&a->lock);
+
+    /* Drain the sparse blocks, but always keep the fullest block as a
+     * destination so the pass doesn't just create new ones. */
+    size_t draining = 0;
+    size_t fullest  = SIZE_MAX;
+    for (size_t i = 0; i < a->block_count; ++i) {
+        struct block *b = &a->blocks[i];
+        if (b->buffer == NULL) {
+            continue;
+        }
+        b->draining =
+                b->used * 1000 <= ( uint64_t )max_permille * a->block_size;
+        draining += b->draining;
+        if (fullest == SIZE_MAX || b->used > a->blocks[fullest].used) {
+            fullest = i;
+        }
+    }
+    if (fullest != SIZE_MAX && a->blocks[fullest].draining) {
+        a->blocks[fullest].draining = false;
+        --draining;
+    }
+    if (draining == 0) {
+        pthread_mutex_unlock(&a->lock);
+        return 0;
+    }
+
+    WGPUCommandEncoder encoder =
+            wgpuDeviceCreateCommandEncoder(a->device, NULL);
+    size_t count = 0;
+    for (size_t page = 0; page < a->page_count; ++page) {
+        for (size_t i = 0; i < RANGES_PER_PAGE; ++i) {
+            struct suballoc_range *range = &a->pages[page][i];
+            if (!range->live || !a->blocks[range->block].draining) {
+                continue;
+            }
+            struct suballoc_range old = *range;
+            if (!place(a, range)) {
+                /* Out of room: the range stays, and so does its block. */
+                *range = old;
+                continue;
+            }
+            uint64_t size = (old.size + COPY_ALIGNMENT - 1) &
+                            ~( uint64_t )(COPY_ALIGNMENT - 1);
+            wgpuCommandEncoderCopyBufferToBuffer(encoder, old.buffer,
+                                                 old.offset, range->buffer,
+                                                 range->offset, size);
+            unplace(a, &old);
+            if (moved != NULL) {
+                moved(range, old.buffer, old.offset, userdata);
+            }
+            ++count;
+        }
+    }
+
+    WGPUCommandBuffer commands = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(queue, 1, &commands);
+    wgpuCommandBufferRelease(commands);
+    wgpuCommandEncoderRelease(encoder);
+
+    /* The copies were submitted first, so destroying the sources now is
+     * deferred until they complete. */
+    for (size_t i = 0; i < a->block_count; ++i) {
+        struct block *b = &a->blocks[i];
+        if (b->buffer != NULL && b->draining && b->used == 0) {
+            block_remove(b);
+        }
+        b->draining = false;
+    }
+    pthread_mutex_unlock(&a->lock);
+    return count;
+}
+
+void suballoc_destroy(struct suballoc *a)
+{
+    for (size_t i = 0; i < a->block_count; ++i) {
+        if (a->blocks[i].buffer != NULL) {
+            block_remove(&a->blocks[i]);
+        }
+    }
+    for (size_t page = 0; page < a->page_count; ++page) {
+        free(a->pages[page]);
+    }
+    pthread_mutex_destroy(&a->lock);
+    wgpuDeviceRelease(a->device);
+    free(a->blocks);
+    free(a->slabs);
+    free(a->pages);
+    free(a->free_ranges);
+    free(a);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
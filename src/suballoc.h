@@ -0,0 +1,108 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SUBALLOC_H
+#define WGPU_SUBALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "writer.h"
+
+#define SUBALLOC_BLOCK_SIZE_DEFAULT (64ull * 1024 * 1024)
+#define SUBALLOC_CHUNK_SIZE         (64ull * 1024)
+
+struct suballoc_options {
+    WGPUDevice device;
+    /* CopySrc and CopyDst are added for defragmentation. */
+    WGPUBufferUsage usage;
+    /* Size of each backing buffer, a power of two of at least
+     * SUBALLOC_CHUNK_SIZE. 0 picks the default. */
+    uint64_t block_size;
+    /* 0 means no limit. */
+    size_t max_blocks;
+};
+
+/* buffer and offset change only when suballoc_defrag moves the range. */
+struct suballoc_range {
+    WGPUBuffer buffer;
+    uint64_t   offset;
+    uint64_t   size;
+
+    /* Private. */
+    uint32_t index;
+    uint32_t block;
+    uint32_t slab;  /* index into the slab table, or UINT32_MAX */
+    uint8_t  order; /* buddy order of the range or of its slab's chunk */
+    bool     live;
+};
+
+struct suballoc_report {
+    size_t   blocks;
+    uint64_t reserved;  /* bytes in backing buffers */
+    uint64_t requested; /* bytes asked for by live ranges */
+    uint64_t allocated; /* the same after rounding to a slab class or order */
+    uint64_t free;      /* reserved minus chunks handed out by the buddies */
+    uint64_t largest_free;
+    size_t   slabs;
+    size_t   ranges;
+    /* Internal: rounding waste over allocated. External: how much of the
+     * free space can't be served by the largest free range. */
+    uint32_t internal_permille;
+    uint32_t external_permille;
+};
+
+/* Called for each range moved by suballoc_defrag, after its buffer and
+ * offset were updated and with the allocator locked, so it must not call
+ * back into it. Bind groups over the old location must be rebuilt. */
+typedef void (*suballoc_moved_fn)(const struct suballoc_range *range,
+                                  WGPUBuffer old_buffer, uint64_t old_offset,
+                                  void *userdata);
+
+struct suballoc;
+
+/* Reads the offset alignment limits from the device. Returns NULL on
+ * failure. */
+struct suballoc *suballoc_create(const struct suballoc_options *opts);
+
+/* Small sizes come from slab classes, the rest from per-block buddy
+ * allocators. Every offset honours minStorageBufferOffsetAlignment and
+ * minUniformBufferOffsetAlignment as far as the usage needs them. Returns
+ * NULL for sizes over the block size or when out of blocks. */
+const struct suballoc_range *suballoc_alloc(struct suballoc *a, uint64_t size);
+void suballoc_free(struct suballoc *a, const struct suballoc_range *range);
+
+void suballoc_report(struct suballoc *a, struct suballoc_report *out);
+/* The report plus per-block occupancy, as one JSON object and a newline. */
+void suballoc_json(struct writer *w, struct suballoc *a);
+
+/* Empties every block whose occupancy is at most max_permille by copying
+ * its ranges into the other blocks, submits the copies on queue and
+ * destroys the emptied blocks. Returns the number of ranges moved. */
+size_t suballoc_defrag(struct suballoc *a, WGPUQueue queue,
+                       uint32_t max_permille, suballoc_moved_fn moved,
+                       void *userdata);
+
+/* Every range is freed and every backing buffer released. */
+void suballoc_destroy(struct suballoc *a);
+
+#endif /* ifndef WGPU_SUBALLOC_H */
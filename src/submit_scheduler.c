@@ -0,0 +1,481 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "phase.h"
+#include "submit_scheduler.h"
+
+#define DELAY_DEFAULT         (1000ull * 1000)
+#define POLL_INTERVAL_DEFAULT (1000ull * 1000)
+
+struct entry {
+    WGPUCommandBuffer cmd;
+    uint64_t          bytes;
+    submit_done_fn    done;
+    void             *userdata;
+    uint64_t          enqueued_ns;
+};
+
+/* Filled under the lock when the batch is taken from the queue, then only
+ * touched by the scheduler thread until it retires. */
+struct batch {
+    struct entry      *entries;
+    WGPUCommandBuffer *cmds;
+    size_t             count;
+    uint64_t           end_seq; /* sequence number past its last entry */
+
+    WGPUFuture              future;
+    uint64_t                submitted_ns;
+    uint64_t                completed_ns;
+    WGPUQueueWorkDoneStatus status;
+    bool                    done;
+};
+
+struct submit_scheduler {
+    WGPUInstance instance;
+    WGPUQueue    queue;
+    size_t       max_batch_count;
+    uint64_t     max_batch_bytes;
+    uint64_t     max_delay_ns;
+    size_t       max_in_flight;
+    size_t       max_queued;
+    size_t       wait_chunk;
+    uint64_t     interval_ns;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;  /* the scheduler thread */
+    pthread_cond_t  space; /* enqueuers waiting on a full queue */
+    pthread_cond_t  idle;  /* flushers waiting on completion */
+    pthread_t       thread;
+    bool            stopping;
+
+    /* Ring of command buffers not yet submitted, oldest at head. */
+    struct entry *ring;
+    size_t        head;
+    size_t        queued;
+    uint64_t      queued_bytes;
+
+    /* Every command buffer gets the next sequence number on enqueue. */
+    uint64_t enqueued_seq;
+    uint64_t submitted_seq;
+    uint64_t retired_seq;
+    uint64_t flush_seq;
+
+    /* Ring of max_in_flight batches, retired in submission order. */
+    struct batch       *batches;
+    size_t              first;
+    size_t              in_flight_count;
+    WGPUFutureWaitInfo *waits;
+
+    struct submit_scheduler_stats stats;
+};
+
+static struct timespec deadline_after(uint64_t ns)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ns += ( uint64_t )ts.tv_nsec;
+    ts.tv_sec += ( time_t )(ns / 1000000000ull);
+    ts.tv_nsec = ( long )(ns % 1000000000ull);
+    return ts;
+}
+
+static uint64_t due_ns(const struct submit_scheduler *s)
+{
+    return s->ring[s->head].enqueued_ns + s->max_delay_ns;
+}
+
+/* Why the queued command buffers should go out now, or -1 to keep
+ * collecting. */
+static int flush_reason(const struct submit_scheduler *s, uint64_t now)
+{
+    if (s->queued == 0) {
+        return -1;
+    }
+    if (s->queued >= s->max_batch_count) {
+        return SUBMIT_FLUSH_COUNT;
+    }
+    if (s->max_batch_bytes && s->queued_bytes >= s->max_batch_bytes) {
+        return SUBMIT_FLUSH_BYTES;
+    }
+    if (s->stopping || s->flush_seq > s->submitted_seq) {
+        return SUBMIT_FLUSH_EXPLICIT;
+    }
+    if (now >= due_ns(s)) {
+        return SUBMIT_FLUSH_DEADLINE;
+    }
+    return -1;
+}
+
+static void take(struct submit_scheduler *s, struct batch *b)
+{
+    uint64_t bytes = 0;
+    b->count       = 0;
+    while (s->queued > 0 && b->count < s->max_batch_count &&
+           (s->max_batch_bytes == 0 || bytes < s->max_batch_bytes)) {
+        struct entry *e        = &s->ring[s->head];
+        b->entries[b->count++] = *e;
+        bytes += e->bytes;
+        s->head = (s->head + 1) % s->max_queued;
+        --s->queued;
+    }
+    s->queued_bytes -= bytes;
+    s->submitted_seq += b->count;
+    b->end_seq = s->submitted_seq;
+    b->done    = false;
+}
+
+static void work_done(WGPUQueueWorkDoneStatus status, void *userdata1,
+                      void *userdata2)
+{
+    struct batch *b = userdata1;
+    (void)userdata2;
+    b->status       = status;
+    b->completed_ns = phase_now_ns();
+    b->done         = true;
+}
+
+static void submit(struct submit_scheduler *s, struct batch *b)
+{
+    for (size_t i = 0; i < b->count; ++i) {
+        b->cmds[i] = b->entries[i].cmd;
+    }
+    b->submitted_ns = phase_now_ns();
+    wgpuQueueSubmit(s->queue, b->count, b->cmds);
+    for (size_t i = 0; i < b->count; ++i) {
+        wgpuCommandBufferRelease(b->cmds[i]);
+    }
+
+    WGPUQueueWorkDoneCallbackInfo info =
+            WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+    info.mode      = WGPUCallbackMode_WaitAnyOnly;
+    info.callback  = work_done;
+    info.userdata1 = b;
+    b->future = wgpuQueueOnSubmittedWorkDone(s->queue, info);
+}
+
+static void record_latency(struct submit_scheduler_stats *stats, uint64_t ns)
+{
+    uint64_t us     = ns / 1000;
+    size_t   bucket = 0;
+    while (us >= 2 && bucket < SUBMIT_LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+    ++stats->latency[bucket];
+    stats->latency_total_ns += ns;
+    if (ns > stats->latency_max_ns) {
+        stats->latency_max_ns = ns;
+    }
+}
+
+/* Runs the callbacks of completed batches, oldest first, so they fire in
+ * submission order even when WaitAny reports them out of order. */
+static void retire(struct submit_scheduler *s)
+{
+    while (s->in_flight_count > 0) {
+        struct batch *b = &s->batches[s->first];
+        if (!b->done) {
+            break;
+        }
+        pthread_mutex_unlock(&s->lock);
+        for (size_t i = 0; i < b->count; ++i) {
+            if (b->entries[i].done) {
+                b->entries[i].done(b->status, b->entries[i].userdata);
+            }
+        }
+        pthread_mutex_lock(&s->lock);
+        record_latency(&s->stats, b->completed_ns - b->submitted_ns);
+        s->stats.completed += b->count;
+        s->retired_seq = b->end_seq;
+        s->first       = (s->first + 1) % s->max_in_flight;
+        --s->in_flight_count;
+        pthread_cond_broadcast(&s->idle);
+    }
+}
+
+/* Only this thread submits, so batches reach the queue in enqueue order and
+ * every completion callback fires here. */
+static void *scheduler_main(void *arg)
+{
+    struct submit_scheduler *s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        int reason;
+        while (s->in_flight_count < s->max_in_flight &&
+               (reason = flush_reason(s, phase_now_ns())) >= 0) {
+            struct batch *b =
+                    &s->batches[(s->first + s->in_flight_count) %
+                                s->max_in_flight];
+            take(s, b);
+            ++s->in_flight_count;
+            ++s->stats.submits;
+            ++s->stats.flushes[reason];
+            pthread_cond_broadcast(&s->space);
+            pthread_mutex_unlock(&s->lock);
+            submit(s, b);
+            pthread_mutex_lock(&s->lock);
+        }
+
+        uint64_t now  = phase_now_ns();
+        uint64_t wait = s->interval_ns;
+        if (s->queued > 0 && s->in_flight_count < s->max_in_flight) {
+            wait = due_ns(s) > now ? due_ns(s) - now : 0;
+            if (s->in_flight_count > 0 && wait > s->interval_ns) {
+                wait = s->interval_ns;
+            }
+        }
+
+        if (s->in_flight_count == 0) {
+            if (s->queued > 0) {
+                struct timespec deadline = deadline_after(wait);
+                pthread_cond_timedwait(&s->wake, &s->lock, &deadline);
+            } else if (s->stopping) {
+                break;
+            } else {
+                pthread_cond_wait(&s->wake, &s->lock);
+            }
+            continue;
+        }
+
+        size_t count = s->in_flight_count;
+        for (size_t i = 0; i < count; ++i) {
+            struct batch *b = &s->batches[(s->first + i) % s->max_in_flight];
+            s->waits[i].future    = b->future;
+            s->waits[i].completed = false;
+        }
+        pthread_mutex_unlock(&s->lock);
+
+        size_t chunks = (count + s->wait_chunk - 1) / s->wait_chunk;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t first = c * s->wait_chunk;
+            size_t n     = count - first < s->wait_chunk ? count - first
+                                                         : s->wait_chunk;
+            wgpuInstanceWaitAny(s->instance, n, s->waits + first,
+                                wait / chunks);
+        }
+
+        pthread_mutex_lock(&s->lock);
+        retire(s);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static void free_scheduler(struct submit_scheduler *s)
+{
+    if (s->batches != NULL) {
+        for (size_t i = 0; i < s->max_in_flight; ++i) {
+            free(s->batches[i].entries);
+            free(s->batches[i].cmds);
+        }
+    }
+    free(s->batches);
+    free(s->ring);
+    free(s->waits);
+    free(s);
+}
+
+struct submit_scheduler *
+submit_scheduler_create(const struct submit_scheduler_options *opts)
+{
+    struct submit_scheduler *s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->instance        = opts->instance;
+    s->queue           = opts->queue;
+    s->max_batch_count = opts->max_batch_count ? opts->max_batch_count
+                                               : SUBMIT_BATCH_COUNT_DEFAULT;
+    s->max_batch_bytes = opts->max_batch_bytes;
+    s->max_delay_ns    = opts->max_delay_ns ? opts->max_delay_ns
+                                            : DELAY_DEFAULT;
+    s->max_in_flight   = opts->max_in_flight ? opts->max_in_flight
+                                             : SUBMIT_IN_FLIGHT_DEFAULT;
+    s->max_queued      = opts->max_queued ? opts->max_queued
+                                          : 4 * s->max_batch_count;
+    s->interval_ns     = opts->poll_interval_ns ? opts->poll_interval_ns
+                                                : POLL_INTERVAL_DEFAULT;
+
+    WGPUInstanceCapabilities caps = WGPU_INSTANCE_CAPABILITIES_INIT;
+    wgpuGetInstanceCapabilities(&caps);
+    s->wait_chunk = caps.timedWaitAnyMaxCount;
+    if (s->wait_chunk == 0 || s->wait_chunk > s->max_in_flight) {
+        s->wait_chunk = s->max_in_flight;
+    }
+
+    s->ring    = calloc(s->max_queued, sizeof(*s->ring));
+    s->waits   = calloc(s->max_in_flight, sizeof(*s->waits));
+    s->batches = calloc(s->max_in_flight, sizeof(*s->batches));
+    if (s->ring == NULL || s->waits == NULL || s->batches == NULL) {
+        free_scheduler(s);
+        return NULL;
+    }
+    for (size_t i = 0; i < s->max_in_flight; ++i) {
+        struct batch *b = &s->batches[i];
+        b->entries      = calloc(s->max_batch_count, sizeof(*b->entries));
+        b->cmds         = calloc(s->max_batch_count, sizeof(*b->cmds));
+        if (b->entries == NULL || b->cmds == NULL) {
+            free_scheduler(s);
+            return NULL;
+        }
+    }
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    pthread_cond_init(&s->space, NULL);
+    pthread_cond_init(&s->idle, NULL);
+    if (pthread_create(&s->thread, NULL, scheduler_main, s) != 0) {
+        pthread_mutex_destroy(&s->lock);
+        pthread_cond_destroy(&s->wake);
+        pthread_cond_destroy(&s->space);
+        pthread_cond_destroy(&s->idle);
+        free_scheduler(s);
+        return NULL;
+    }
+    wgpuInstanceAddRef(s->instance);
+    wgpuQueueAddRef(s->queue);
+    return s;
+}
+
+bool submit_scheduler_enqueue(struct submit_scheduler *s, WGPUCommandBuffer cmd,
+                              uint64_t bytes, submit_done_fn done,
+                              void *userdata, uint64_t timeout_ns)
+{
+    pthread_mutex_lock(&s->lock);
+    if (s->queued == s->max_queued && !s->stopping) {
+        ++s->stats.stalls;
+        if (timeout_ns == SUBMIT_WAIT_FOREVER) {
+            while (s->queued == s->max_queued && !s->stopping) {
+                pthread_cond_wait(&s->space, &s->lock);
+            }
+        } else if (timeout_ns > 0) {
+            struct timespec deadline = deadline_after(timeout_ns);
+            while (s->queued == s->max_queued && !s->stopping &&
+                   pthread_cond_timedwait(&s->space, &s->lock, &deadline) ==
+                           0) {
+            }
+        }
+    }
+    if (s->queued == s->max_queued || s->stopping) {
+        pthread_mutex_unlock(&s->lock);
+        wgpuCommandBufferRelease(cmd);
+        return false;
+    }
+
+    struct entry *e = &s->ring[(s->head + s->queued) % s->max_queued];
+    e->cmd          = cmd;
+    e->bytes        = bytes;
+    e->done         = done;
+    e->userdata     = userdata;
+    e->enqueued_ns  = phase_now_ns();
+    ++s->queued;
+    s->queued_bytes += bytes;
+    ++s->enqueued_seq;
+    ++s->stats.enqueued;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    return true;
+}
+
+bool submit_scheduler_flush(struct submit_scheduler *s, uint64_t timeout_ns)
+{
+    pthread_mutex_lock(&s->lock);
+    uint64_t target = s->enqueued_seq;
+    if (s->flush_seq < target) {
+        s->flush_seq = target;
+        pthread_cond_signal(&s->wake);
+    }
+    if (timeout_ns == SUBMIT_WAIT_FOREVER) {
+        while (s->retired_seq < target) {
+            pthread_cond_wait(&s->idle, &s->lock);
+        }
+    } else if (s->retired_seq < target && timeout_ns > 0) {
+        struct timespec deadline = deadline_after(timeout_ns);
+        while (s->retired_seq < target &&
+               pthread_cond_timedwait(&s->idle, &s->lock, &deadline) == 0) {
+        }
+    }
+    bool done = s->retired_seq >= target;
+    pthread_mutex_unlock(&s->lock);
+    return done;
+}
+
+uint64_t submit_latency_percentile(const struct submit_scheduler_stats *stats,
+                                   double percentile)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < SUBMIT_LATENCY_BUCKETS; ++i) {
+        total += stats->latency[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = ( uint64_t )(percentile / 100.0 * total + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < SUBMIT_LATENCY_BUCKETS - 1; ++i) {
+        seen += stats->latency[i];
+        if (seen >= rank) {
+            uint64_t bound = (2ull << i) * 1000;
+            return bound < stats->latency_max_ns ? bound
+                                                 : stats->latency_max_ns;
+        }
+    }
+    return stats->latency_max_ns;
+}
+
+void submit_scheduler_stats(struct submit_scheduler       *s,
+                            struct submit_scheduler_stats *out)
+{
+    pthread_mutex_lock(&s->lock);
+    *out           = s->stats;
+    out->queued    = s->queued;
+    out->in_flight = s->in_flight_count;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void submit_scheduler_destroy(struct submit_scheduler *s)
+{
+    pthread_mutex_lock(&s->lock);
+    s->stopping = true;
+    pthread_cond_signal(&s->wake);
+    pthread_cond_broadcast(&s->space);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    pthread_cond_destroy(&s->space);
+    pthread_cond_destroy(&s->idle);
+    wgpuQueueRelease(s->queue);
+    wgpuInstanceRelease(s->instance);
+    free_scheduler(s);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,115 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_SUBMIT_SCHEDULER_H
+#define WGPU_SUBMIT_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define SUBMIT_BATCH_COUNT_DEFAULT 64
+#define SUBMIT_IN_FLIGHT_DEFAULT   2
+#define SUBMIT_WAIT_FOREVER        UINT64_MAX
+/* Bucket i counts latencies below 2^(i + 1) microseconds; the last bucket
+ * also takes everything longer. */
+#define SUBMIT_LATENCY_BUCKETS 24
+
+struct submit_scheduler_options {
+    /* The instance must have timed waits enabled, as acquire_init does. */
+    WGPUInstance instance;
+    /* Submitted from the scheduler thread, so a device that other threads
+     * use as well needs ImplicitDeviceSynchronization. */
+    WGPUQueue queue;
+    /* A batch is submitted as soon as it holds max_batch_count command
+     * buffers or max_batch_bytes of work, or once its oldest command buffer
+     * has waited max_delay_ns. A zero max_batch_bytes disables that limit. */
+    size_t   max_batch_count;
+    uint64_t max_batch_bytes;
+    uint64_t max_delay_ns;
+    /* Batches submitted but not yet complete; further batches wait. */
+    size_t max_in_flight;
+    /* Command buffers held before submit_scheduler_enqueue blocks. Defaults
+     * to four batches. */
+    size_t max_queued;
+    /* How long the scheduler thread blocks in WaitAny before picking up
+     * command buffers enqueued meanwhile. */
+    uint64_t poll_interval_ns;
+};
+
+/* Runs on the scheduler thread once the batch holding the command buffer
+ * completed. Batches complete in submission order. */
+typedef void (*submit_done_fn)(WGPUQueueWorkDoneStatus status, void *userdata);
+
+enum submit_flush_reason {
+    SUBMIT_FLUSH_COUNT,
+    SUBMIT_FLUSH_BYTES,
+    SUBMIT_FLUSH_DEADLINE,
+    SUBMIT_FLUSH_EXPLICIT,
+    SUBMIT_FLUSH_REASONS,
+};
+
+struct submit_scheduler_stats {
+    uint64_t enqueued;
+    uint64_t submits;
+    uint64_t completed;
+    uint64_t stalls; /* enqueues that blocked on a full queue */
+    uint64_t flushes[SUBMIT_FLUSH_REASONS];
+    size_t   queued;
+    size_t   in_flight;
+
+    /* Submit to completion, per batch, as seen by the scheduler thread. */
+    uint64_t latency[SUBMIT_LATENCY_BUCKETS];
+    uint64_t latency_total_ns;
+    uint64_t latency_max_ns;
+};
+
+struct submit_scheduler;
+
+/* Starts the scheduler thread. Returns NULL on failure. */
+struct submit_scheduler *
+submit_scheduler_create(const struct submit_scheduler_options *opts);
+
+/* Takes ownership of cmd in every case. bytes is the caller's estimate of
+ * the work it carries, counted against max_batch_bytes. Blocks at most
+ * timeout_ns while the queue is full; returns false, without calling done,
+ * if it stayed full or the scheduler is shutting down. */
+bool submit_scheduler_enqueue(struct submit_scheduler *s, WGPUCommandBuffer cmd,
+                              uint64_t bytes, submit_done_fn done,
+                              void *userdata, uint64_t timeout_ns);
+
+/* Submits everything enqueued so far without waiting for the batch limits,
+ * then waits at most timeout_ns for it to complete. Returns true once it
+ * has. */
+bool submit_scheduler_flush(struct submit_scheduler *s, uint64_t timeout_ns);
+
+/* Upper bound, in nanoseconds, of the bucket holding the given nearest-rank
+ * percentile (0-100) of the submit latencies; zero without samples. */
+uint64_t submit_latency_percentile(const struct submit_scheduler_stats *stats,
+                                   double percentile);
+
+void submit_scheduler_stats(struct submit_scheduler       *s,
+                            struct submit_scheduler_stats *out);
+
+/* Flushes, waits for every batch to complete and stops the thread. */
+void submit_scheduler_destroy(struct submit_scheduler *s);
+
+#endif /* ifndef WGPU_SUBMIT_SCHEDULER_H */
@@ -0,0 +1,501 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "key.h"
+#include "texture_pool.h"
+
+#define BUCKET_CAPACITY_MIN 16
+
+/* Every texture with one descriptor. Free textures form a LIFO list, so
+ * the warmest one is reused first. */
+struct pool_bucket {
+    WGPUTextureDescriptor desc;
+    WGPUTextureFormat    *view_formats;
+    struct pool_texture  *free;
+    size_t                key_size;
+    uint8_t               key[];
+};
+
+struct bucket_slot {
+    uint64_t            hash;
+    struct pool_bucket *bucket;
+};
+
+/* Textures released before one submit, recycled once its work is done. */
+struct retire {
+    struct texture_pool *pool;
+    struct pool_texture *textures;
+    WGPUFuture           future;
+    bool                 done;
+};
+
+struct texture_pool {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    WGPUQueue    queue;
+    uint32_t     max_idle;
+    uint64_t     submits;
+
+    struct bucket_slot *slots;
+    size_t              mask;
+    size_t              bucket_count;
+
+    struct pool_texture **all;
+    size_t                count;
+    size_t                capacity;
+
+    struct pool_texture *pending;
+    struct retire      **retires;
+    size_t               retire_count;
+    size_t               retire_capacity;
+    WGPUFutureWaitInfo  *waits;
+
+    struct key                key;
+    struct texture_pool_stats stats;
+};
+
+static uint64_t texel_bytes(WGPUTextureFormat format)
+{
+    switch (format) {
+    case WGPUTextureFormat_R8Unorm:
+    case WGPUTextureFormat_R8Snorm:
+    case WGPUTextureFormat_R8Uint:
+    case WGPUTextureFormat_R8Sint:
+    case WGPUTextureFormat_Stencil8:
+        return 1;
+    case WGPUTextureFormat_R16Uint:
+    case WGPUTextureFormat_R16Sint:
+    case WGPUTextureFormat_R16Float:
+    case WGPUTextureFormat_RG8Unorm:
+    case WGPUTextureFormat_RG8Snorm:
+    case WGPUTextureFormat_RG8Uint:
+    case WGPUTextureFormat_RG8Sint:
+    case WGPUTextureFormat_Depth16Unorm:
+        return 2;
+    case WGPUTextureFormat_RG32Float:
+    case WGPUTextureFormat_RG32Uint:
+    case WGPUTextureFormat_RG32Sint:
+    case WGPUTextureFormat_RGBA16Uint:
+    case WGPUTextureFormat_RGBA16Sint:
+    case WGPUTextureFormat_RGBA16Float:
+    case WGPUTextureFormat_Depth32FloatStencil8:
+        return 8;
+    case WGPUTextureFormat_RGBA32Float:
+    case WGPUTextureFormat_RGBA32Uint:
+    case WGPUTextureFormat_RGBA32Sint:
+        return 16;
+    default:
+        /* Every other uncompressed color and depth format; compressed ones
+         * are smaller, which this overestimates. */
+        return 4;
+    }
+}
+
+static uint64_t estimate_bytes(const WGPUTextureDescriptor *desc)
+{
+    uint64_t width  = desc->size.width;
+    uint64_t height = desc->size.height;
+    uint64_t depth  = desc->size.depthOrArrayLayers;
+    uint64_t texels = 0;
+    for (uint32_t level = 0; level < desc->mipLevelCount; ++level) {
+        texels += width * height * depth;
+        width  = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        if (desc->dimension == WGPUTextureDimension_3D) {
+            depth = depth > 1 ? depth / 2 : 1;
+        }
+    }
+    return texels * desc->sampleCount * texel_bytes(desc->format);
+}
+
+static bool slots_grow(struct texture_pool *pool)
+{
+    size_t capacity = pool->slots ? 2 * (pool->mask + 1) : BUCKET_CAPACITY_MIN;
+    struct bucket_slot *grown = calloc(capacity, sizeof(*grown));
+    if (grown == NULL) {
+        return false;
+    }
+    for (size_t i = 0; pool->slots && i <= pool->mask; ++i) {
+        if (pool->slots[i].bucket == NULL) {
+            continue;
+        }
+        size_t j = pool->slots[i].hash & (capacity - 1);
+        while (grown[j].bucket != NULL) {
+            j = (j + 1) & (capacity - 1);
+        }
+        grown[j] = pool->slots[i];
+    }
+    free(pool->slots);
+    pool->slots = grown;
+    pool->mask  = capacity - 1;
+    return true;
+}
+
+/* The bucket for desc, created on first use. */
+static struct pool_bucket *bucket_for(struct texture_pool         *pool,
+                                      const WGPUTextureDescriptor *desc)
+{
+    struct key *key = &pool->key;
+    key_reset(key);
+    key_no_chain(key, desc->nextInChain);
+    key_u64(key, desc->usage);
+    key_u32(key, desc->dimension);
+    key_u32(key, desc->size.width);
+    key_u32(key, desc->size.height);
+    key_u32(key, desc->size.depthOrArrayLayers);
+    key_u32(key, desc->format);
+    key_u32(key, desc->mipLevelCount);
+    key_u32(key, desc->sampleCount);
+    key_u64(key, desc->viewFormatCount);
+    key_bytes(key, desc->viewFormats,
+              desc->viewFormatCount * sizeof(*desc->viewFormats));
+    if (key->failed) {
+        return NULL;
+    }
+
+    /* Grown up front so the probe below can insert where it stops. */
+    if (2 * (pool->bucket_count + 1) > pool->mask + 1 && !slots_grow(pool)) {
+        return NULL;
+    }
+    uint64_t hash = key_hash(key);
+    size_t   i    = hash & pool->mask;
+    for (; pool->slots[i].bucket != NULL; i = (i + 1) & pool->mask) {
+        struct pool_bucket *bucket = pool->slots[i].bucket;
+        if (pool->slots[i].hash == hash &&
+            key_equal(key, bucket->key, bucket->key_size)) {
+            return bucket;
+        }
+    }
+
+    struct pool_bucket *bucket = calloc(1, sizeof(*bucket) + key->size);
+    size_t              views  = desc->viewFormatCount;
+    if (bucket == NULL ||
+        (views > 0 && (bucket->view_formats = malloc(
+                               views * sizeof(*desc->viewFormats))) == NULL)) {
+        free(bucket);
+        return NULL;
+    }
+    bucket->desc       = *desc;
+    bucket->desc.label = (WGPUStringView){.data = "texture_pool", .length = 12};
+    bucket->desc.viewFormats = bucket->view_formats;
+    if (views > 0) {
+        memcpy(bucket->view_formats, desc->viewFormats,
+               views * sizeof(*desc->viewFormats));
+    }
+    bucket->key_size = key->size;
+    memcpy(bucket->key, key->data, key->size);
+    pool->slots[i] = (struct bucket_slot){.hash = hash, .bucket = bucket};
+    ++pool->bucket_count;
+    return bucket;
+}
+
+static struct pool_texture *take(struct texture_pool *pool,
+                                 struct pool_bucket  *bucket)
+{
+    ++pool->stats.acquires;
+    struct pool_texture *t = bucket->free;
+    if (t != NULL) {
+        bucket->free = t->next;
+        t->next      = NULL;
+        ++pool->stats.reused;
+        return t;
+    }
+
+    if (pool->count == pool->capacity) {
+        size_t capacity = pool->capacity ? 2 * pool->capacity : 64;
+        struct pool_texture **grown =
+                realloc(pool->all, capacity * sizeof(*grown));
+        if (grown == NULL) {
+            return NULL;
+        }
+        pool->all      = grown;
+        pool->capacity = capacity;
+    }
+    t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->texture = wgpuDeviceCreateTexture(pool->device, &bucket->desc);
+    if (t->texture == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->bucket = bucket;
+    t->bytes  = estimate_bytes(&bucket->desc);
+    t->index  = pool->count;
+
+    pool->all[pool->count++] = t;
+    ++pool->stats.created;
+    pool->stats.bytes += t->bytes;
+    if (pool->stats.bytes > pool->stats.peak_bytes) {
+        pool->stats.peak_bytes = pool->stats.bytes;
+    }
+    return t;
+}
+
+static void destroy_texture(struct texture_pool *pool, struct pool_texture *t)
+{
+    wgpuTextureDestroy(t->texture);
+    wgpuTextureRelease(t->texture);
+    pool->all[t->index]        = pool->all[pool->count - 1];
+    pool->all[t->index]->index = t->index;
+    --pool->count;
+    ++pool->stats.destroyed;
+    pool->stats.bytes -= t->bytes;
+    free(t);
+}
+
+static void retire_callback(WGPUQueueWorkDoneStatus status, void *userdata1,
+                            void *userdata2)
+{
+    struct retire       *retire = userdata1;
+    struct texture_pool *pool   = retire->pool;
+    (void)status;
+    (void)userdata2;
+
+    while (retire->textures != NULL) {
+        struct pool_texture *t = retire->textures;
+        retire->textures       = t->next;
+        t->next                = t->bucket->free;
+        t->idle_since          = pool->submits;
+        t->bucket->free        = t;
+    }
+    retire->done = true;
+}
+
+static void poll(struct texture_pool *pool)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < pool->retire_count; ++i) {
+        pool->waits[count].future    = pool->retires[i]->future;
+        pool->waits[count].completed = false;
+        ++count;
+    }
+    if (count > 0) {
+        wgpuInstanceWaitAny(pool->instance, count, pool->waits, 0);
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < pool->retire_count; ++i) {
+        if (pool->retires[i]->done) {
+            free(pool->retires[i]);
+        } else {
+            pool->retires[kept++] = pool->retires[i];
+        }
+    }
+    pool->retire_count = kept;
+}
+
+/* Destroys free textures that sat unused for max_idle submits. */
+static void trim(struct texture_pool *pool)
+{
+    for (size_t i = 0; i <= pool->mask && pool->slots; ++i) {
+        struct pool_bucket *bucket = pool->slots[i].bucket;
+        if (bucket == NULL) {
+            continue;
+        }
+        struct pool_texture **link = &bucket->free;
+        while (*link != NULL) {
+            struct pool_texture *t = *link;
+            if (pool->submits - t->idle_since > pool->max_idle) {
+                *link = t->next;
+                destroy_texture(pool, t);
+            } else {
+                link = &t->next;
+            }
+        }
+    }
+}
+
+struct texture_pool *
+texture_pool_create(const struct texture_pool_options *opts)
+{
+    struct texture_pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->instance = opts->instance;
+    pool->device   = opts->device;
+    pool->queue    = opts->queue;
+    pool->max_idle = opts->max_idle_submits ? opts->max_idle_submits
+                                            : TEXTURE_POOL_MAX_IDLE_DEFAULT;
+    wgpuInstanceAddRef(pool->instance);
+    wgpuDeviceAddRef(pool->device);
+    wgpuQueueAddRef(pool->queue);
+    return pool;
+}
+
+struct pool_texture *texture_pool_acquire(struct texture_pool         *pool,
+                                          const WGPUTextureDescriptor *desc)
+{
+    struct pool_bucket *bucket = bucket_for(pool, desc);
+    return bucket ? take(pool, bucket) : NULL;
+}
+
+void texture_pool_release(struct texture_pool *pool, struct pool_texture *t)
+{
+    t->next       = pool->pending;
+    pool->pending = t;
+}
+
+static int by_first_pass(const void *a, const void *b)
+{
+    const struct texture_lifetime *x = *( struct texture_lifetime *const * )a;
+    const struct texture_lifetime *y = *( struct texture_lifetime *const * )b;
+    return (x->first_pass > y->first_pass) - (x->first_pass < y->first_pass);
+}
+
+bool texture_pool_alias(struct texture_pool *pool, size_t count,
+                        struct texture_lifetime *lifetimes)
+{
+    struct texture_lifetime **order = malloc(count * sizeof(*order));
+    struct texture_lifetime **owner = malloc(count * sizeof(*owner));
+    if (count > 0 && (order == NULL || owner == NULL)) {
+        free(order);
+        free(owner);
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        order[i]             = &lifetimes[i];
+        lifetimes[i].texture = NULL;
+    }
+    qsort(order, count, sizeof(*order), by_first_pass);
+
+    /* Greedy interval assignment in order of first use: each texture is
+     * represented by the lifetime that used it last. */
+    size_t live = 0;
+    bool   ok   = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        struct texture_lifetime *l      = order[i];
+        struct pool_bucket      *bucket = bucket_for(pool, l->desc);
+        size_t                   j      = 0;
+        while (j < live && (owner[j]->texture->bucket != bucket ||
+                            owner[j]->last_pass >= l->first_pass)) {
+            ++j;
+        }
+        if (bucket != NULL && j < live) {
+            l->texture = owner[j]->texture;
+            owner[j]   = l;
+            ++pool->stats.aliased;
+        } else if (bucket != NULL && (l->texture = take(pool, bucket))) {
+            owner[live++] = l;
+        } else {
+            ok = false;
+        }
+    }
+
+    for (size_t j = 0; j < live; ++j) {
+        texture_pool_release(pool, owner[j]->texture);
+    }
+    if (!ok) {
+        for (size_t i = 0; i < count; ++i) {
+            lifetimes[i].texture = NULL;
+        }
+    }
+    free(order);
+    free(owner);
+    return ok;
+}
+
+void texture_pool_submit(struct texture_pool *pool, size_t count,
+                         const WGPUCommandBuffer *commands)
+{
+    wgpuQueueSubmit(pool->queue, count, commands);
+    ++pool->submits;
+
+    struct retire *retire = NULL;
+    if (pool->pending != NULL) {
+        if (pool->retire_count == pool->retire_capacity) {
+            size_t capacity =
+                    pool->retire_capacity ? 2 * pool->retire_capacity : 8;
+            struct retire **grown =
+                    realloc(pool->retires, capacity * sizeof(*grown));
+            WGPUFutureWaitInfo *waits =
+                    realloc(pool->waits, capacity * sizeof(*waits));
+            if (grown != NULL) {
+                pool->retires = grown;
+            }
+            if (waits != NULL) {
+                pool->waits = waits;
+            }
+            if (grown != NULL && waits != NULL) {
+                pool->retire_capacity = capacity;
+            }
+        }
+        if (pool->retire_count < pool->retire_capacity) {
+            retire = calloc(1, sizeof(*retire));
+        }
+    }
+    if (retire != NULL) {
+        retire->pool     = pool;
+        retire->textures = pool->pending;
+        pool->pending    = NULL;
+
+        WGPUQueueWorkDoneCallbackInfo info =
+                WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+        info.mode      = WGPUCallbackMode_WaitAnyOnly;
+        info.callback  = retire_callback;
+        info.userdata1 = retire;
+        retire->future = wgpuQueueOnSubmittedWorkDone(pool->queue, info);
+        pool->retires[pool->retire_count++] = retire;
+    }
+    /* On allocation failure the pending textures ride on the next submit. */
+    poll(pool);
+    trim(pool);
+}
+
+void texture_pool_stats(struct texture_pool       *pool,
+                        struct texture_pool_stats *out)
+{
+    *out          = pool->stats;
+    out->textures = pool->count;
+}
+
+void texture_pool_destroy(struct texture_pool *pool)
+{
+    for (size_t i = 0; i < pool->retire_count; ++i) {
+        WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+        wait.future             = pool->retires[i]->future;
+        wgpuInstanceWaitAny(pool->instance, 1, &wait, UINT64_MAX);
+        free(pool->retires[i]);
+    }
+    while (pool->count > 0) {
+        destroy_texture(pool, pool->all[pool->count - 1]);
+    }
+    for (size_t i = 0; i <= pool->mask && pool->slots; ++i) {
+        if (pool->slots[i].bucket != NULL) {
+            free(pool->slots[i].bucket->view_formats);
+            free(pool->slots[i].bucket);
+        }
+    }
+    wgpuQueueRelease(pool->queue);
+    wgpuDeviceRelease(pool->device);
+    wgpuInstanceRelease(pool->instance);
+    key_free(&pool->key);
+    free(pool->slots);
+    free(pool->all);
+    free(pool->retires);
+    free(pool->waits);
+    free(pool);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
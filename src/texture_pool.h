@@ -0,0 +1,105 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_TEXTURE_POOL_H
+#define WGPU_TEXTURE_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define TEXTURE_POOL_MAX_IDLE_DEFAULT 8
+
+struct texture_pool_options {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    WGPUQueue    queue;
+    /* Free textures unused for this many submits are destroyed. */
+    uint32_t max_idle_submits;
+};
+
+/* A pooled texture. Stays valid until released back to the pool. */
+struct pool_texture {
+    WGPUTexture texture;
+
+    /* Private. */
+    struct pool_bucket  *bucket;
+    struct pool_texture *next;
+    uint64_t             bytes;
+    uint64_t             idle_since;
+    size_t               index;
+};
+
+/* An intermediate that is live from first_pass to last_pass, inclusive. */
+struct texture_lifetime {
+    const WGPUTextureDescriptor *desc;
+    uint32_t                     first_pass;
+    uint32_t                     last_pass;
+    struct pool_texture         *texture; /* out */
+};
+
+struct texture_pool_stats {
+    uint64_t acquires;
+    uint64_t reused;
+    uint64_t created; /* wgpuDeviceCreateTexture calls */
+    uint64_t destroyed;
+    uint64_t aliased; /* lifetimes that shared another's texture */
+    size_t   textures;
+    uint64_t bytes; /* estimated, of every texture the pool owns */
+    uint64_t peak_bytes;
+};
+
+struct texture_pool;
+
+/* A texture pool is used from one thread. */
+struct texture_pool *
+texture_pool_create(const struct texture_pool_options *opts);
+
+/* A free texture matching format, dimension, size, usage, sample count,
+ * mip count and view formats, or a new one. Descriptors with a chain are
+ * not pooled and return NULL. */
+struct pool_texture *texture_pool_acquire(struct texture_pool         *pool,
+                                          const WGPUTextureDescriptor *desc);
+
+/* Returns the texture to the pool. It is handed out again only after the
+ * work of the next texture_pool_submit is done. */
+void texture_pool_release(struct texture_pool *pool, struct pool_texture *t);
+
+/* Assigns a texture to every lifetime so that intermediates with matching
+ * descriptors and disjoint pass ranges share one. The textures are for the
+ * next submit only and are released by texture_pool_submit. Returns false,
+ * with nothing assigned, if a texture could not be acquired. */
+bool texture_pool_alias(struct texture_pool *pool, size_t count,
+                        struct texture_lifetime *lifetimes);
+
+/* Submits commands, and recycles the textures released since the last
+ * submit once wgpuQueueOnSubmittedWorkDone fires. */
+void texture_pool_submit(struct texture_pool *pool, size_t count,
+                         const WGPUCommandBuffer *commands);
+
+void texture_pool_stats(struct texture_pool       *pool,
+                        struct texture_pool_stats *out);
+
+/* Waits for submits in flight and destroys every pooled texture. Textures
+ * still held by the caller are destroyed too. */
+void texture_pool_destroy(struct texture_pool *pool);
+
+#endif /* ifndef WGPU_TEXTURE_POOL_H */
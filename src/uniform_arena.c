@@ -0,0 +1,297 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "phase.h"
+#include "uniform_arena.h"
+
+enum region_state {
+    REGION_FREE,
+    REGION_SEALED, /* full, waiting for the submit to upload it */
+    REGION_IN_FLIGHT,
+};
+
+struct region {
+    struct uniform_arena *arena;
+    uint64_t              cursor;
+    enum region_state     state;
+    WGPUFuture            future;
+};
+
+struct uniform_arena {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    WGPUQueue    queue;
+    WGPUBuffer   buffer;
+    uint64_t     region_size;
+    size_t       region_count;
+    uint64_t     binding_size;
+    uint64_t     alignment;
+    size_t       current;
+
+    /* CPU copy of every region, laid out like the buffer. Allocations are
+     * filled in until the submit, so each region keeps its own slice. */
+    uint8_t *shadow;
+
+    WGPUFutureWaitInfo        *waits;
+    struct uniform_arena_stats stats;
+
+    struct region regions[];
+};
+
+static void done_callback(WGPUQueueWorkDoneStatus status, void *userdata1,
+                          void *userdata2)
+{
+    struct region *region = userdata1;
+    (void)status;
+    (void)userdata2;
+
+    /* Even a failed wait means the queue will never read the region. */
+    region->cursor = 0;
+    region->state  = REGION_FREE;
+}
+
+static void poll(struct uniform_arena *arena)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < arena->region_count; ++i) {
+        if (arena->regions[i].state == REGION_IN_FLIGHT) {
+            arena->waits[count].future    = arena->regions[i].future;
+            arena->waits[count].completed = false;
+            ++count;
+        }
+    }
+    if (count > 0) {
+        wgpuInstanceWaitAny(arena->instance, count, arena->waits, 0);
+    }
+}
+
+static bool wait_free(struct uniform_arena *arena, struct region *region,
+                      uint64_t timeout_ns)
+{
+    poll(arena);
+    if (region->state != REGION_IN_FLIGHT) {
+        return region->state == REGION_FREE;
+    }
+
+    uint64_t start = phase_now_ns();
+    ++arena->stats.stalls;
+    WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+    wait.future             = region->future;
+    wgpuInstanceWaitAny(arena->instance, 1, &wait,
+                        timeout_ns == UNIFORM_WAIT_FOREVER ? UINT64_MAX
+                                                           : timeout_ns);
+    arena->stats.stall_ns += phase_now_ns() - start;
+    return region->state == REGION_FREE;
+}
+
+/* Seals the current region and moves on to the next one. */
+static void seal(struct uniform_arena *arena)
+{
+    struct region *region = &arena->regions[arena->current];
+    if (region->state != REGION_FREE || region->cursor == 0) {
+        return;
+    }
+    if (region->cursor > arena->stats.peak_region_bytes) {
+        arena->stats.peak_region_bytes = region->cursor;
+    }
+    region->state  = REGION_SEALED;
+    arena->current = (arena->current + 1) % arena->region_count;
+}
+
+struct uniform_arena *
+uniform_arena_create(const struct uniform_arena_options *opts)
+{
+    WGPULimits limits = WGPU_LIMITS_INIT;
+    if (wgpuDeviceGetLimits(opts->device, &limits) != WGPUStatus_Success ||
+        limits.maxDynamicUniformBuffersPerPipelineLayout == 0) {
+        return NULL;
+    }
+    size_t   count     = opts->region_count ? opts->region_count
+                                            : UNIFORM_REGION_COUNT_DEFAULT;
+    uint64_t binding   = opts->binding_size ? opts->binding_size
+                                            : UNIFORM_BINDING_SIZE_DEFAULT;
+    uint64_t alignment = limits.minUniformBufferOffsetAlignment;
+    /* Regions start aligned, and every offset must leave room for a full
+     * binding. */
+    uint64_t size = opts->region_size ? opts->region_size
+                                      : UNIFORM_REGION_SIZE_DEFAULT;
+    size          = (size + alignment - 1) / alignment * alignment;
+    if (binding > limits.maxUniformBufferBindingSize || binding > size ||
+        count * size > UINT32_MAX) {
+        return NULL;
+    }
+
+    struct uniform_arena *arena =
+            calloc(1, sizeof(*arena) + count * sizeof(struct region));
+    if (arena == NULL) {
+        return NULL;
+    }
+    arena->instance     = opts->instance;
+    arena->device       = opts->device;
+    arena->queue        = opts->queue;
+    arena->region_size  = size;
+    arena->region_count = count;
+    arena->binding_size = binding;
+    arena->alignment    = alignment;
+    arena->shadow       = malloc(( size_t )(count * size));
+    arena->waits        = calloc(count, sizeof(*arena->waits));
+    for (size_t i = 0; i < count; ++i) {
+        arena->regions[i].arena = arena;
+    }
+
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.label = (WGPUStringView){.data = "uniform_arena", .length = 13};
+    desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+    desc.size  = count * size;
+    if (arena->shadow == NULL || arena->waits == NULL ||
+        (arena->buffer = wgpuDeviceCreateBuffer(opts->device, &desc)) ==
+                NULL) {
+        free(arena->shadow);
+        free(arena->waits);
+        free(arena);
+        return NULL;
+    }
+    wgpuInstanceAddRef(arena->instance);
+    wgpuDeviceAddRef(arena->device);
+    wgpuQueueAddRef(arena->queue);
+    return arena;
+}
+
+bool uniform_arena_alloc(struct uniform_arena *arena, uint64_t size,
+                         struct uniform_alloc *out, uint64_t timeout_ns)
+{
+    if (size == 0 || size > arena->binding_size) {
+        return false;
+    }
+    for (;;) {
+        struct region *region = &arena->regions[arena->current];
+        if (region->state == REGION_SEALED) {
+            return false;
+        }
+        if (region->state == REGION_IN_FLIGHT &&
+            !wait_free(arena, region, timeout_ns)) {
+            return false;
+        }
+        /* The binding, not just size, has to fit. */
+        if (region->cursor + arena->binding_size > arena->region_size) {
+            seal(arena);
+            continue;
+        }
+        out->data   = arena->shadow + arena->current * arena->region_size +
+                      region->cursor;
+        out->offset = ( uint32_t )(arena->current * arena->region_size +
+                                   region->cursor);
+        region->cursor += (size + arena->alignment - 1) / arena->alignment *
+                          arena->alignment;
+        ++arena->stats.allocations;
+        arena->stats.bytes += size;
+        return true;
+    }
+}
+
+void uniform_arena_layout_entry(struct uniform_arena     *arena,
+                                uint32_t                  binding,
+                                WGPUShaderStage           visibility,
+                                WGPUBindGroupLayoutEntry *out)
+{
+    WGPUBindGroupLayoutEntry entry = WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT;
+    entry.binding                  = binding;
+    entry.visibility               = visibility;
+    entry.buffer.type              = WGPUBufferBindingType_Uniform;
+    entry.buffer.hasDynamicOffset  = true;
+    entry.buffer.minBindingSize    = arena->binding_size;
+    *out                           = entry;
+}
+
+WGPUBindGroup uniform_arena_bind_group(struct uniform_arena *arena,
+                                       WGPUBindGroupLayout   layout,
+                                       uint32_t              binding)
+{
+    WGPUBindGroupEntry entry = WGPU_BIND_GROUP_ENTRY_INIT;
+    entry.binding            = binding;
+    entry.buffer             = arena->buffer;
+    entry.size               = arena->binding_size;
+
+    WGPUBindGroupDescriptor desc = WGPU_BIND_GROUP_DESCRIPTOR_INIT;
+    desc.label      = (WGPUStringView){.data = "uniform_arena", .length = 13};
+    desc.layout     = layout;
+    desc.entryCount = 1;
+    desc.entries    = &entry;
+    return wgpuDeviceCreateBindGroup(arena->device, &desc);
+}
+
+void uniform_arena_submit(struct uniform_arena *arena, size_t count,
+                          const WGPUCommandBuffer *commands)
+{
+    seal(arena);
+    for (size_t i = 0; i < arena->region_count; ++i) {
+        struct region *region = &arena->regions[i];
+        if (region->state != REGION_SEALED) {
+            continue;
+        }
+        uint64_t offset = i * arena->region_size;
+        wgpuQueueWriteBuffer(arena->queue, arena->buffer, offset,
+                             arena->shadow + offset, ( size_t )region->cursor);
+        ++arena->stats.writes;
+    }
+    wgpuQueueSubmit(arena->queue, count, commands);
+    ++arena->stats.submits;
+
+    for (size_t i = 0; i < arena->region_count; ++i) {
+        struct region *region = &arena->regions[i];
+        if (region->state != REGION_SEALED) {
+            continue;
+        }
+        WGPUQueueWorkDoneCallbackInfo info =
+                WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+        info.mode      = WGPUCallbackMode_WaitAnyOnly;
+        info.callback  = done_callback;
+        info.userdata1 = region;
+        region->state  = REGION_IN_FLIGHT;
+        region->future = wgpuQueueOnSubmittedWorkDone(arena->queue, info);
+    }
+    poll(arena);
+}
+
+void uniform_arena_stats(struct uniform_arena       *arena,
+                         struct uniform_arena_stats *out)
+{
+    *out = arena->stats;
+}
+
+void uniform_arena_destroy(struct uniform_arena *arena)
+{
+    for (size_t i = 0; i < arena->region_count; ++i) {
+        if (arena->regions[i].state == REGION_IN_FLIGHT) {
+            wait_free(arena, &arena->regions[i], UNIFORM_WAIT_FOREVER);
+        }
+    }
+    wgpuBufferRelease(arena->buffer);
+    wgpuQueueRelease(arena->queue);
+    wgpuDeviceRelease(arena->device);
+    wgpuInstanceRelease(arena->instance);
+    free(arena->shadow);
+    free(arena->waits);
+    free(arena);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,100 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_UNIFORM_ARENA_H
+#define WGPU_UNIFORM_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define UNIFORM_REGION_SIZE_DEFAULT  (256ull * 1024)
+#define UNIFORM_REGION_COUNT_DEFAULT 3
+#define UNIFORM_BINDING_SIZE_DEFAULT 256
+#define UNIFORM_WAIT_FOREVER         UINT64_MAX
+
+struct uniform_arena_options {
+    /* Blocking on a busy region needs an instance with timed waits. */
+    WGPUInstance instance;
+    WGPUDevice   device;
+    WGPUQueue    queue;
+    uint64_t     region_size;
+    size_t       region_count;
+    /* Size of the binding each dynamic offset addresses, i.e. the largest
+     * parameter block. */
+    uint64_t binding_size;
+};
+
+struct uniform_alloc {
+    void    *data;   /* write the parameters here before the submit */
+    uint32_t offset; /* pass to wgpu*EncoderSetBindGroup */
+};
+
+struct uniform_arena_stats {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t writes; /* wgpuQueueWriteBuffer calls */
+    uint64_t submits;
+    uint64_t stalls;
+    uint64_t stall_ns;
+    uint64_t peak_region_bytes;
+};
+
+struct uniform_arena;
+
+/* One Uniform | CopyDst buffer split into region_count regions that are
+ * used in turn. Fails if the device allows no dynamic uniform buffers. */
+struct uniform_arena *
+uniform_arena_create(const struct uniform_arena_options *opts);
+
+/* Bumps size bytes, at most binding_size, out of the current region,
+ * aligned to minUniformBufferOffsetAlignment. When the region is full it
+ * is sealed and the next one taken, waiting up to timeout_ns for the queue
+ * to finish with it. Fails when every region was used since the last
+ * submit. */
+bool uniform_arena_alloc(struct uniform_arena *arena, uint64_t size,
+                         struct uniform_alloc *out, uint64_t timeout_ns);
+
+/* A dynamic uniform buffer entry of binding_size for the caller's layout. */
+void uniform_arena_layout_entry(struct uniform_arena     *arena,
+                                uint32_t                  binding,
+                                WGPUShaderStage           visibility,
+                                WGPUBindGroupLayoutEntry *out);
+
+/* Binds the whole arena at binding. One bind group serves every
+ * allocation, through its dynamic offset. */
+WGPUBindGroup uniform_arena_bind_group(struct uniform_arena *arena,
+                                       WGPUBindGroupLayout   layout,
+                                       uint32_t              binding);
+
+/* Uploads what the submit allocated with one wgpuQueueWriteBuffer per
+ * region used, submits commands and resets those regions once the queue is
+ * done. */
+void uniform_arena_submit(struct uniform_arena *arena, size_t count,
+                          const WGPUCommandBuffer *commands);
+
+void uniform_arena_stats(struct uniform_arena       *arena,
+                         struct uniform_arena_stats *out);
+
+/* Waits for regions still in flight. */
+void uniform_arena_destroy(struct uniform_arena *arena);
+
+#endif /* ifndef WGPU_UNIFORM_ARENA_H */
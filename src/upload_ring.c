@@ -0,0 +1,319 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "phase.h"
+#include "upload_ring.h"
+
+#define COPY_ALIGNMENT 4
+
+enum segment_state {
+    SEGMENT_MAPPED,    /* writable from cursor on */
+    SEGMENT_FILLED,    /* full, mapped until the next submit */
+    SEGMENT_SUBMITTED, /* waiting for the queue to finish with it */
+    SEGMENT_MAPPING,   /* MapAsync outstanding */
+    SEGMENT_FAILED,    /* the map failed; the segment is lost */
+};
+
+struct segment {
+    struct upload_ring *ring;
+    WGPUBuffer          buffer;
+    uint8_t            *data;
+    uint64_t            cursor;
+    enum segment_state  state;
+    /* The work done or map future the segment is waiting on. */
+    WGPUFuture future;
+};
+
+/* Segments are reused strictly in order, so the one after the current
+ * segment is always the oldest in flight. */
+struct upload_ring {
+    WGPUInstance instance;
+    WGPUDevice   device;
+    uint64_t     segment_size;
+    size_t       segment_count;
+    size_t       current;
+
+    WGPUFutureWaitInfo      *waits;
+    struct upload_ring_stats stats;
+
+    struct segment segments[];
+};
+
+static void map_callback(WGPUMapAsyncStatus status, WGPUStringView message,
+                         void *userdata1, void *userdata2)
+{
+    struct segment *seg = userdata1;
+    (void)message;
+    (void)userdata2;
+
+    if (status != WGPUMapAsyncStatus_Success) {
+        seg->state = SEGMENT_FAILED;
+        return;
+    }
+    seg->data   = wgpuBufferGetMappedRange(seg->buffer, 0,
+                                           ( size_t )seg->ring->segment_size);
+    seg->cursor = 0;
+    seg->state  = seg->data ? SEGMENT_MAPPED : SEGMENT_FAILED;
+}
+
+static void done_callback(WGPUQueueWorkDoneStatus status, void *userdata1,
+                          void *userdata2)
+{
+    struct segment *seg = userdata1;
+    (void)userdata2;
+
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        seg->state = SEGMENT_FAILED;
+        return;
+    }
+    WGPUBufferMapCallbackInfo info = WGPU_BUFFER_MAP_CALLBACK_INFO_INIT;
+    info.mode                      = WGPUCallbackMode_WaitAnyOnly;
+    info.callback                  = map_callback;
+    info.userdata1                 = seg;
+    seg->state                     = SEGMENT_MAPPING;
+    seg->future = wgpuBufferMapAsync(seg->buffer, WGPUMapMode_Write, 0,
+                                     ( size_t )seg->ring->segment_size, info);
+}
+
+static bool in_flight(const struct segment *seg)
+{
+    return seg->state == SEGMENT_SUBMITTED || seg->state == SEGMENT_MAPPING;
+}
+
+void upload_ring_poll(struct upload_ring *ring)
+{
+    /* Each pass can turn a finished submit into a map, so go until nothing
+     * completes. A zero timeout works on any instance. */
+    for (bool progressed = true; progressed;) {
+        size_t count = 0;
+        for (size_t i = 0; i < ring->segment_count; ++i) {
+            if (in_flight(&ring->segments[i])) {
+                ring->waits[count].future    = ring->segments[i].future;
+                ring->waits[count].completed = false;
+                ++count;
+            }
+        }
+        progressed = count > 0 &&
+                     wgpuInstanceWaitAny(ring->instance, count, ring->waits,
+                                         0) == WGPUWaitStatus_Success;
+    }
+}
+
+/* Blocks until seg is mapped again, or until timeout_ns passed. */
+static bool wait_mapped(struct upload_ring *ring, struct segment *seg,
+                        uint64_t timeout_ns)
+{
+    upload_ring_poll(ring);
+    if (seg->state == SEGMENT_MAPPED) {
+        return true;
+    }
+
+    uint64_t start = phase_now_ns();
+    ++ring->stats.stalls;
+    while (in_flight(seg)) {
+        uint64_t elapsed = phase_now_ns() - start;
+        if (timeout_ns != UPLOAD_WAIT_FOREVER && elapsed >= timeout_ns) {
+            break;
+        }
+        WGPUFutureWaitInfo wait = WGPU_FUTURE_WAIT_INFO_INIT;
+        wait.future             = seg->future;
+        if (wgpuInstanceWaitAny(ring->instance, 1, &wait,
+                                timeout_ns == UPLOAD_WAIT_FOREVER
+                                        ? UINT64_MAX
+                                        : timeout_ns - elapsed) ==
+            WGPUWaitStatus_Error) {
+            break;
+        }
+    }
+    ring->stats.stall_ns += phase_now_ns() - start;
+    return seg->state == SEGMENT_MAPPED;
+}
+
+struct upload_ring *upload_ring_create(const struct upload_ring_options *opts)
+{
+    size_t   count = opts->segment_count ? opts->segment_count
+                                         : UPLOAD_SEGMENT_COUNT_DEFAULT;
+    uint64_t size  = opts->segment_size ? opts->segment_size
+                                        : UPLOAD_SEGMENT_SIZE_DEFAULT;
+    if (size % COPY_ALIGNMENT != 0) {
+        return NULL;
+    }
+
+    struct upload_ring *ring =
+            calloc(1, sizeof(*ring) + count * sizeof(struct segment));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->instance      = opts->instance;
+    ring->device        = opts->device;
+    ring->segment_size  = size;
+    ring->segment_count = count;
+    ring->waits         = calloc(count, sizeof(*ring->waits));
+    if (ring->waits == NULL) {
+        free(ring);
+        return NULL;
+    }
+    wgpuInstanceAddRef(ring->instance);
+    wgpuDeviceAddRef(ring->device);
+
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.label = (WGPUStringView){.data = "upload_ring", .length = 11};
+    desc.usage = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc;
+    desc.size  = size;
+    desc.mappedAtCreation = true;
+    for (size_t i = 0; i < count; ++i) {
+        struct segment *seg = &ring->segments[i];
+        seg->ring           = ring;
+        seg->buffer         = wgpuDeviceCreateBuffer(ring->device, &desc);
+        seg->state          = SEGMENT_MAPPED;
+        if (seg->buffer != NULL) {
+            seg->data = wgpuBufferGetMappedRange(seg->buffer, 0, ( size_t )size);
+        }
+        if (seg->data == NULL) {
+            ring->segment_count = i + (seg->buffer != NULL);
+            upload_ring_destroy(ring);
+            return NULL;
+        }
+    }
+    return ring;
+}
+
+void *upload_ring_reserve(struct upload_ring *ring, WGPUCommandEncoder encoder,
+                          WGPUBuffer dst, uint64_t dst_offset, uint64_t size,
+                          uint64_t timeout_ns)
+{
+    if (size == 0 || size > ring->segment_size || size % COPY_ALIGNMENT ||
+        dst_offset % COPY_ALIGNMENT) {
+        return NULL;
+    }
+    for (;;) {
+        struct segment *seg = &ring->segments[ring->current];
+        if (seg->state == SEGMENT_MAPPED &&
+            seg->cursor + size <= ring->segment_size) {
+            uint8_t *data = seg->data + seg->cursor;
+            wgpuCommandEncoderCopyBufferToBuffer(encoder, seg->buffer,
+                                                 seg->cursor, dst, dst_offset,
+                                                 size);
+            seg->cursor += size;
+            ring->stats.bytes += size;
+            return data;
+        }
+        if (seg->state == SEGMENT_MAPPED) {
+            /* Full. Earlier reservations may still be filled in until the
+             * submit, which unmaps it. */
+            seg->state    = SEGMENT_FILLED;
+            ring->current = (ring->current + 1) % ring->segment_count;
+            continue;
+        }
+        /* Wrapped around to data that hasn't been submitted yet. */
+        if (seg->state == SEGMENT_FILLED || seg->state == SEGMENT_FAILED ||
+            !wait_mapped(ring, seg, timeout_ns)) {
+            return NULL;
+        }
+    }
+}
+
+bool upload_ring_write(struct upload_ring *ring, WGPUCommandEncoder encoder,
+                       WGPUBuffer dst, uint64_t dst_offset, const void *data,
+                       uint64_t size, uint64_t timeout_ns)
+{
+    const uint8_t *src = data;
+    while (size > 0) {
+        uint64_t chunk = size < ring->segment_size ? size : ring->segment_size;
+        void    *out   = upload_ring_reserve(ring, encoder, dst, dst_offset,
+                                             chunk, timeout_ns);
+        if (out == NULL) {
+            return false;
+        }
+        memcpy(out, src, ( size_t )chunk);
+        src += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+void upload_ring_submit(struct upload_ring *ring, WGPUQueue queue,
+                        size_t count, const WGPUCommandBuffer *commands)
+{
+    struct segment *current = &ring->segments[ring->current];
+    if (current->state == SEGMENT_MAPPED && current->cursor > 0) {
+        current->state = SEGMENT_FILLED;
+        ring->current  = (ring->current + 1) % ring->segment_count;
+    }
+    for (size_t i = 0; i < ring->segment_count; ++i) {
+        if (ring->segments[i].state == SEGMENT_FILLED) {
+            wgpuBufferUnmap(ring->segments[i].buffer);
+        }
+    }
+
+    wgpuQueueSubmit(queue, count, commands);
+    ++ring->stats.submits;
+
+    for (size_t i = 0; i < ring->segment_count; ++i) {
+        struct segment *seg = &ring->segments[i];
+        if (seg->state != SEGMENT_FILLED) {
+            continue;
+        }
+        WGPUQueueWorkDoneCallbackInfo info =
+                WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT;
+        info.mode      = WGPUCallbackMode_WaitAnyOnly;
+        info.callback  = done_callback;
+        info.userdata1 = seg;
+        seg->state     = SEGMENT_SUBMITTED;
+        seg->future    = wgpuQueueOnSubmittedWorkDone(queue, info);
+    }
+    upload_ring_poll(ring);
+}
+
+void upload_ring_stats(struct upload_ring *ring, struct upload_ring_stats *out)
+{
+    *out        = ring->stats;
+    out->mapped = 0;
+    for (size_t i = 0; i < ring->segment_count; ++i) {
+        out->mapped += ring->segments[i].state == SEGMENT_MAPPED;
+    }
+}
+
+uint64_t upload_ring_segment_size(const struct upload_ring *ring)
+{
+    return ring->segment_size;
+}
+
+void upload_ring_destroy(struct upload_ring *ring)
+{
+    for (size_t i = 0; i < ring->segment_count; ++i) {
+        struct segment *seg = &ring->segments[i];
+        if (in_flight(seg)) {
+            wait_mapped(ring, seg, UPLOAD_WAIT_FOREVER);
+        }
+        if (seg->buffer != NULL) {
+            wgpuBufferRelease(seg->buffer);
+        }
+    }
+    wgpuDeviceRelease(ring->device);
+    wgpuInstanceRelease(ring->instance);
+    free(ring->waits);
+    free(ring);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
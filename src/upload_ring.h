@@ -0,0 +1,88 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_UPLOAD_RING_H
+#define WGPU_UPLOAD_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#define UPLOAD_SEGMENT_SIZE_DEFAULT  (4ull * 1024 * 1024)
+#define UPLOAD_SEGMENT_COUNT_DEFAULT 8
+#define UPLOAD_WAIT_FOREVER          UINT64_MAX
+
+struct upload_ring_options {
+    /* Blocking on a full ring needs an instance with timed waits. */
+    WGPUInstance instance;
+    WGPUDevice   device;
+    uint64_t     segment_size;
+    size_t       segment_count;
+};
+
+struct upload_ring_stats {
+    uint64_t bytes;
+    uint64_t submits;
+    uint64_t stalls; /* reservations that waited for a segment to remap */
+    uint64_t stall_ns;
+    size_t   mapped; /* segments ready to be written */
+};
+
+struct upload_ring;
+
+/* Creates segment_count MapWrite | CopySrc staging buffers, mapped at
+ * creation. Returns NULL on failure. A ring is used from one thread. */
+struct upload_ring *upload_ring_create(const struct upload_ring_options *opts);
+
+/* Returns size bytes of mapped staging memory and records their copy to
+ * dst at dst_offset into encoder. The memory must be filled before the
+ * next upload_ring_submit. size and dst_offset must be multiples of 4 and
+ * size at most the segment size. When the next segment is still in flight
+ * this waits up to timeout_ns for it to remap, and it returns NULL if it
+ * doesn't or if every segment was filled since the last submit. */
+void *upload_ring_reserve(struct upload_ring *ring, WGPUCommandEncoder encoder,
+                          WGPUBuffer dst, uint64_t dst_offset, uint64_t size,
+                          uint64_t timeout_ns);
+
+/* Copies data through as many reservations as it needs. */
+bool upload_ring_write(struct upload_ring *ring, WGPUCommandEncoder encoder,
+                       WGPUBuffer dst, uint64_t dst_offset, const void *data,
+                       uint64_t size, uint64_t timeout_ns);
+
+/* Unmaps the segments written since the last submit, submits commands,
+ * which must include every encoder reservations were recorded into, and
+ * retires those segments until the queue is done with them. */
+void upload_ring_submit(struct upload_ring *ring, WGPUQueue queue,
+                        size_t count, const WGPUCommandBuffer *commands);
+
+/* Starts remapping segments the queue has finished with, without blocking.
+ * Submit and reserve already do this. */
+void upload_ring_poll(struct upload_ring *ring);
+
+void upload_ring_stats(struct upload_ring *ring, struct upload_ring_stats *out);
+
+/* The largest size a single reservation can take. */
+uint64_t upload_ring_segment_size(const struct upload_ring *ring);
+
+/* Waits for segments still in flight, then releases the staging buffers. */
+void upload_ring_destroy(struct upload_ring *ring);
+
+#endif /* ifndef WGPU_UPLOAD_RING_H */
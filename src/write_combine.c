@@ -0,0 +1,279 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "write_combine.h"
+
+#define COPY_ALIGNMENT 4
+
+struct pending {
+    WGPUBuffer dst;
+    uint64_t   offset;
+    uint64_t   size;
+    uint64_t   data; /* offset into the data arena */
+    uint64_t   seq;
+};
+
+struct write_combine {
+    WGPUDevice          device;
+    WGPUQueue           queue;
+    struct upload_ring *ring;
+
+    struct pending *pending;
+    size_t          count;
+    uint64_t        capacity;
+    uint8_t        *data;
+    uint64_t        data_size;
+    uint64_t        data_capacity;
+    uint64_t        seq;
+
+    /* Spans too large for one reservation, or written directly when the
+     * ring is full, are composed here first. */
+    uint8_t *scratch;
+    uint64_t scratch_capacity;
+
+    struct write_combine_stats stats;
+};
+
+static bool grow(void **data, uint64_t *capacity, uint64_t needed,
+                 size_t unit, uint64_t minimum)
+{
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint64_t grown = *capacity ? *capacity : minimum;
+    while (grown < needed) {
+        grown *= 2;
+    }
+    void *data_grown = realloc(*data, ( size_t )(grown * unit));
+    if (data_grown == NULL) {
+        return false;
+    }
+    *data     = data_grown;
+    *capacity = grown;
+    return true;
+}
+
+static int by_buffer_offset(const void *a, const void *b)
+{
+    const struct pending *x = a;
+    const struct pending *y = b;
+    if (x->dst != y->dst) {
+        return ( uintptr_t )x->dst < ( uintptr_t )y->dst ? -1 : 1;
+    }
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+static int by_seq(const void *a, const void *b)
+{
+    const struct pending *x = a;
+    const struct pending *y = b;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+struct write_combine *write_combine_create(WGPUDevice          device,
+                                           struct upload_ring *ring)
+{
+    struct write_combine *wc = calloc(1, sizeof(*wc));
+    if (wc == NULL) {
+        return NULL;
+    }
+    wc->device = device;
+    wc->queue  = wgpuDeviceGetQueue(device);
+    wc->ring   = ring;
+    wgpuDeviceAddRef(device);
+    return wc;
+}
+
+bool write_combine_write(struct write_combine *wc, WGPUBuffer dst,
+                         uint64_t offset, const void *data, size_t size)
+{
+    if (size == 0 || size % COPY_ALIGNMENT || offset % COPY_ALIGNMENT) {
+        return false;
+    }
+    if (!grow(( void ** )&wc->pending, &wc->capacity, wc->count + 1,
+              sizeof(*wc->pending), 64) ||
+        !grow(( void ** )&wc->data, &wc->data_capacity, wc->data_size + size,
+              1, 4096)) {
+        return false;
+    }
+
+    memcpy(wc->data + wc->data_size, data, size);
+    wgpuBufferAddRef(dst);
+    wc->pending[wc->count++] = (struct pending){
+            .dst    = dst,
+            .offset = offset,
+            .size   = size,
+            .data   = wc->data_size,
+            .seq    = wc->seq++,
+    };
+    wc->data_size += size;
+    ++wc->stats.writes;
+    wc->stats.bytes += size;
+    return true;
+}
+
+/* Lays the writes of one span over each other in submission order. */
+static void compose(struct write_combine *wc, struct pending *writes,
+                    size_t count, uint64_t start, uint8_t *out)
+{
+    qsort(writes, count, sizeof(*writes), by_seq);
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(out + (writes[i].offset - start), wc->data + writes[i].data,
+               ( size_t )writes[i].size);
+    }
+}
+
+static bool stage_span(struct write_combine *wc, WGPUCommandEncoder encoder,
+                       struct pending *writes, size_t count, uint64_t start,
+                       uint64_t end, uint64_t timeout_ns)
+{
+    WGPUBuffer dst  = writes[0].dst;
+    uint64_t   size = end - start;
+    if (size <= upload_ring_segment_size(wc->ring)) {
+        uint8_t *out = upload_ring_reserve(wc->ring, encoder, dst, start, size,
+                                           timeout_ns);
+        if (out == NULL) {
+            return false;
+        }
+        compose(wc, writes, count, start, out);
+        ++wc->stats.copies;
+    } else {
+        if (!grow(( void ** )&wc->scratch, &wc->scratch_capacity, size, 1,
+                  4096)) {
+            return false;
+        }
+        compose(wc, writes, count, start, wc->scratch);
+        if (!upload_ring_write(wc->ring, encoder, dst, start, wc->scratch,
+                               size, timeout_ns)) {
+            return false;
+        }
+        uint64_t segment = upload_ring_segment_size(wc->ring);
+        wc->stats.copies += (size + segment - 1) / segment;
+    }
+    wc->stats.staged_bytes += size;
+    return true;
+}
+
+/* The ring had no room in time: write the composed span directly, which
+ * still lands ahead of the next submit. */
+static bool write_span(struct write_combine *wc, struct pending *writes,
+                       size_t count, uint64_t start, uint64_t end)
+{
+    uint64_t size = end - start;
+    if (!grow(( void ** )&wc->scratch, &wc->scratch_capacity, size, 1, 4096)) {
+        return false;
+    }
+    compose(wc, writes, count, start, wc->scratch);
+    wgpuQueueWriteBuffer(wc->queue, writes[0].dst, start, wc->scratch,
+                         ( size_t )size);
+    ++wc->stats.fallbacks;
+    wc->stats.fallback_bytes += size;
+    return true;
+}
+
+bool write_combine_flush(struct write_combine *wc, WGPUCommandEncoder encoder,
+                         uint64_t timeout_ns)
+{
+    qsort(wc->pending, wc->count, sizeof(*wc->pending), by_buffer_offset);
+
+    bool ok = true;
+    for (size_t first = 0; first < wc->count;) {
+        struct pending *head = &wc->pending[first];
+        uint64_t        end  = head->offset + head->size;
+        size_t          last = first + 1;
+        while (last < wc->count && wc->pending[last].dst == head->dst &&
+               wc->pending[last].offset <= end) {
+            uint64_t next_end =
+                    wc->pending[last].offset + wc->pending[last].size;
+            end = next_end > end ? next_end : end;
+            ++last;
+        }
+
+        size_t writes = last - first;
+        if (!stage_span(wc, encoder, head, writes, head->offset, end,
+                        timeout_ns) &&
+            !write_span(wc, head, writes, head->offset, end)) {
+            wc->stats.dropped += writes;
+            ok = false;
+        }
+        for (size_t i = first; i < last; ++i) {
+            wgpuBufferRelease(wc->pending[i].dst);
+        }
+        first = last;
+    }
+
+    wc->count     = 0;
+    wc->data_size = 0;
+    ++wc->stats.flushes;
+    return ok;
+}
+
+bool write_combine_submit(struct write_combine *wc, WGPUQueue queue,
+                          size_t count, const WGPUCommandBuffer *commands,
+                          uint64_t timeout_ns)
+{
+    if (wc->count == 0) {
+        upload_ring_submit(wc->ring, queue, count, commands);
+        return true;
+    }
+
+    WGPUCommandBuffer *all = malloc((count + 1) * sizeof(*all));
+    if (all == NULL) {
+        return false;
+    }
+    WGPUCommandEncoder encoder =
+            wgpuDeviceCreateCommandEncoder(wc->device, NULL);
+    bool ok = write_combine_flush(wc, encoder, timeout_ns);
+    all[0]  = wgpuCommandEncoderFinish(encoder, NULL);
+    if (count > 0) {
+        memcpy(all + 1, commands, count * sizeof(*all));
+    }
+    upload_ring_submit(wc->ring, queue, count + 1, all);
+    wgpuCommandBufferRelease(all[0]);
+    wgpuCommandEncoderRelease(encoder);
+    free(all);
+    return ok;
+}
+
+void write_combine_stats(struct write_combine       *wc,
+                         struct write_combine_stats *out)
+{
+    *out = wc->stats;
+}
+
+void write_combine_destroy(struct write_combine *wc)
+{
+    for (size_t i = 0; i < wc->count; ++i) {
+        wgpuBufferRelease(wc->pending[i].dst);
+    }
+    wgpuQueueRelease(wc->queue);
+    wgpuDeviceRelease(wc->device);
+    free(wc->pending);
+    free(wc->data);
+    free(wc->scratch);
+    free(wc);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,76 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_WRITE_COMBINE_H
+#define WGPU_WRITE_COMBINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+#include "upload_ring.h"
+
+struct write_combine_stats {
+    uint64_t writes; /* write_combine_write calls */
+    uint64_t bytes;
+    uint64_t copies; /* CopyBufferToBuffer commands recorded */
+    uint64_t staged_bytes;
+    uint64_t flushes;
+    uint64_t fallbacks; /* spans written with wgpuQueueWriteBuffer */
+    uint64_t fallback_bytes;
+    uint64_t dropped; /* writes lost for want of memory */
+};
+
+struct write_combine;
+
+/* Stages through ring, which stays owned by the caller and may carry other
+ * uploads in the same submits. */
+struct write_combine *write_combine_create(WGPUDevice          device,
+                                           struct upload_ring *ring);
+
+/* Queues a write with the rules of wgpuQueueWriteBuffer: offset and size
+ * are multiples of 4. The data is copied, and dst is held until the flush.
+ */
+bool write_combine_write(struct write_combine *wc, WGPUBuffer dst,
+                         uint64_t offset, const void *data, size_t size);
+
+/* Merges the queued writes into adjacent or overlapping spans per buffer,
+ * later writes winning, packs the spans back to back in the ring and
+ * records one copy per span into encoder. A span that does not fit in the
+ * ring within timeout_ns goes out through wgpuQueueWriteBuffer on the
+ * device's queue instead. Everything queued is consumed; returns false if
+ * some of it could not be delivered at all. */
+bool write_combine_flush(struct write_combine *wc, WGPUCommandEncoder encoder,
+                         uint64_t timeout_ns);
+
+/* Flushes into a command buffer of its own and submits it ahead of
+ * commands, through upload_ring_submit. */
+bool write_combine_submit(struct write_combine *wc, WGPUQueue queue,
+                          size_t count, const WGPUCommandBuffer *commands,
+                          uint64_t timeout_ns);
+
+void write_combine_stats(struct write_combine       *wc,
+                         struct write_combine_stats *out);
+
+/* Drops writes that were never flushed. */
+void write_combine_destroy(struct write_combine *wc);
+
+#endif /* ifndef WGPU_WRITE_COMBINE_H */
@@ -0,0 +1,139 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "writer.h"
+
+void writer_init(struct writer *w, int fd)
+{
+    w->fd     = fd;
+    w->failed = false;
+    w->length = 0;
+}
+
+static void drain(struct writer *w)
+{
+    size_t done = 0;
+    while (!w->failed && done < w->length) {
+        ssize_t n = write(w->fd, w->buf + done, w->length - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        w->failed = n <= 0;
+        done += w->failed ? 0 : ( size_t )n;
+    }
+    w->length = 0;
+}
+
+void writer_bytes(struct writer *w, const void *data, size_t length)
+{
+    const char *src = data;
+    while (length > 0) {
+        if (w->length == WRITER_CAPACITY) {
+            drain(w);
+        }
+        size_t n = WRITER_CAPACITY - w->length;
+        n        = n < length ? n : length;
+        memcpy(w->buf + w->length, src, n);
+        w->length += n;
+        src += n;
+        length -= n;
+    }
+}
+
+void writer_zeros(struct writer *w, size_t length)
+{
+    static const char zeros[64];
+    while (length > 0) {
+        size_t n = length < sizeof(zeros) ? length : sizeof(zeros);
+        writer_bytes(w, zeros, n);
+        length -= n;
+    }
+}
+
+void writer_str(struct writer *w, const char *str)
+{
+    writer_bytes(w, str, strlen(str));
+}
+
+void writer_u64(struct writer *w, uint64_t value)
+{
+    char  digits[20];
+    char *end = digits + sizeof(digits);
+    char *p   = end;
+    do {
+        *--p = ( char )('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    writer_bytes(w, p, ( size_t )(end - p));
+}
+
+void writer_hex(struct writer *w, uint64_t value)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    char  digits[18];
+    char *end = digits + sizeof(digits);
+    char *p   = end;
+    do {
+        *--p = hex[value & 0xF];
+        value >>= 4;
+    } while (value != 0 || end - p < 2);
+    *--p = 'x';
+    *--p = '0';
+    writer_bytes(w, p, ( size_t )(end - p));
+}
+
+void writer_json_string(struct writer *w, const char *data, size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    writer_bytes(w, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = ( unsigned char )data[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        writer_bytes(w, data + run, i - run);
+        run = i + 1;
+        if (c == '"' || c == '\\') {
+            char escaped[2] = {'\\', ( char )c};
+            writer_bytes(w, escaped, sizeof(escaped));
+        } else {
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            writer_bytes(w, escaped, sizeof(escaped));
+        }
+    }
+    writer_bytes(w, data + run, length - run);
+    writer_bytes(w, "\"", 1);
+}
+
+bool writer_flush(struct writer *w)
+{
+    drain(w);
+    return !w->failed;
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,60 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_WRITER_H
+#define WGPU_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WRITER_CAPACITY (64 * 1024)
+
+/* Buffered output to a file descriptor. The buffer lives inside the struct,
+ * so nothing is allocated per write; it is flushed when full. Errors are
+ * sticky and reported by writer_flush(). */
+struct writer {
+    int    fd;
+    bool   failed;
+    size_t length;
+    char   buf[WRITER_CAPACITY];
+};
+
+void writer_init(struct writer *w, int fd);
+void writer_bytes(struct writer *w, const void *data, size_t length);
+void writer_zeros(struct writer *w, size_t length);
+void writer_str(struct writer *w, const char *str);
+void writer_u64(struct writer *w, uint64_t value);
+/* 0x-prefixed, at least two digits, matching printf("0x%02x"). */
+void writer_hex(struct writer *w, uint64_t value);
+
+/* Writes length bytes of data as a quoted, escaped JSON string. */
+void writer_json_string(struct writer *w, const char *data, size_t length);
+
+bool writer_flush(struct writer *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef WGPU_WRITER_H */
@@ -0,0 +1,55 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_CHECK_H
+#define WGPU_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* A failed check reports itself and the test carries on, so one run shows
+ * every failure; main returns check_status(). */
+static int check_failures;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                    #cond);                                                  \
+            ++check_failures;                                                \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                       \
+    do {                                                                     \
+        unsigned long long check_a = ( unsigned long long )(a);              \
+        unsigned long long check_b = ( unsigned long long )(b);              \
+        if (check_a != check_b) {                                            \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %llu != %llu\n", \
+                    __FILE__, __LINE__, #a, #b, check_a, check_b);           \
+            ++check_failures;                                                \
+        }                                                                    \
+    } while (0)
+
+static inline int check_status(void)
+{
+    return check_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif /* ifndef WGPU_CHECK_H */
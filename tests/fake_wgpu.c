@@ -0,0 +1,499 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fake_wgpu.h"
+
+struct WGPUBufferImpl {
+    uint64_t   size;
+    atomic_int refs;
+    uint8_t   *data;
+};
+
+struct copy {
+    WGPUBuffer src;
+    uint64_t   src_offset;
+    WGPUBuffer dst;
+    uint64_t   dst_offset;
+    uint64_t   size;
+};
+
+enum future_kind {
+    FUTURE_MAP,
+    FUTURE_WORK_DONE,
+};
+
+struct future {
+    enum future_kind              kind;
+    bool                          done;
+    WGPUBufferMapCallbackInfo     map;
+    WGPUQueueWorkDoneCallbackInfo work_done;
+};
+
+/* One object serves as both the encoder and the command buffer it finishes
+ * into, freed once both handles are released. */
+struct WGPUCommandEncoderImpl {
+    atomic_int   refs;
+    struct copy *copies;
+    size_t       copy_count;
+    char       **markers;
+    size_t       marker_count;
+};
+
+static int instance_tag;
+static int device_tag;
+static int queue_tag;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t          live_buffers;
+static size_t          queue_writes;
+static size_t          queue_submits;
+static char          **markers;
+static size_t          marker_count;
+static struct future  *futures;
+static size_t          future_count;
+
+bool fake_implicit_synchronization = true;
+
+WGPULimits fake_limits = {
+        .maxBufferSize                   = 1ull << 32,
+        .minUniformBufferOffsetAlignment = 256,
+        .minStorageBufferOffsetAlignment = 256,
+};
+
+WGPUInstance fake_instance(void)
+{
+    return ( WGPUInstance )&instance_tag;
+}
+
+WGPUDevice fake_device(void)
+{
+    return ( WGPUDevice )&device_tag;
+}
+
+WGPUQueue fake_queue(void)
+{
+    return ( WGPUQueue )&queue_tag;
+}
+
+uint8_t *fake_buffer_data(WGPUBuffer buffer)
+{
+    return buffer->data;
+}
+
+size_t fake_live_buffers(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t count = live_buffers;
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+size_t fake_queue_writes(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t count = queue_writes;
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+size_t fake_queue_submits(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t submits = queue_submits;
+    pthread_mutex_unlock(&lock);
+    return submits;
+}
+
+size_t fake_marker_count(void)
+{
+    pthread_mutex_lock(&lock);
+    size_t count = marker_count;
+    pthread_mutex_unlock(&lock);
+    return count;
+}
+
+const char *fake_marker(size_t index)
+{
+    pthread_mutex_lock(&lock);
+    const char *marker = index < marker_count ? markers[index] : NULL;
+    pthread_mutex_unlock(&lock);
+    return marker;
+}
+
+void fake_clear_markers(void)
+{
+    pthread_mutex_lock(&lock);
+    for (size_t i = 0; i < marker_count; ++i) {
+        free(markers[i]);
+    }
+    free(markers);
+    markers      = NULL;
+    marker_count = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+static WGPUFuture future_new(struct future future)
+{
+    pthread_mutex_lock(&lock);
+    struct future *grown =
+            realloc(futures, (future_count + 1) * sizeof(*futures));
+    if (grown == NULL) {
+        abort();
+    }
+    futures                 = grown;
+    futures[future_count++] = future;
+    WGPUFuture id           = {.id = future_count};
+    pthread_mutex_unlock(&lock);
+    return id;
+}
+
+WGPUWaitStatus wgpuInstanceWaitAny(WGPUInstance instance, size_t count,
+                                   WGPUFutureWaitInfo *infos,
+                                   uint64_t            timeout_ns)
+{
+    (void)instance;
+    (void)timeout_ns;
+    for (size_t i = 0; i < count; ++i) {
+        pthread_mutex_lock(&lock);
+        struct future *f    = &futures[infos[i].future.id - 1];
+        bool           fire = !f->done;
+        struct future  copy = *f;
+        f->done             = true;
+        infos[i].completed  = true;
+        pthread_mutex_unlock(&lock);
+
+        /* Callbacks run unlocked, since they may call back in. */
+        if (fire && copy.kind == FUTURE_MAP) {
+            copy.map.callback(WGPUMapAsyncStatus_Success,
+                              (WGPUStringView){.data = NULL, .length = 0},
+                              copy.map.userdata1, copy.map.userdata2);
+        } else if (fire) {
+            copy.work_done.callback(WGPUQueueWorkDoneStatus_Success,
+                                    copy.work_done.userdata1,
+                                    copy.work_done.userdata2);
+        }
+    }
+    return WGPUWaitStatus_Success;
+}
+
+WGPUStatus wgpuGetInstanceCapabilities(WGPUInstanceCapabilities *capabilities)
+{
+    capabilities->timedWaitAnyEnable   = true;
+    capabilities->timedWaitAnyMaxCount = 64;
+    return WGPUStatus_Success;
+}
+
+void wgpuInstanceAddRef(WGPUInstance instance)
+{
+    (void)instance;
+}
+
+void wgpuInstanceRelease(WGPUInstance instance)
+{
+    (void)instance;
+}
+
+/* There is no adapter; these only let caps.c link, and its queries fail. */
+void wgpuAdapterGetFeatures(WGPUAdapter adapter, WGPUSupportedFeatures *out)
+{
+    (void)adapter;
+    *out = (WGPUSupportedFeatures){0};
+}
+
+WGPUStatus wgpuAdapterGetInfo(WGPUAdapter adapter, WGPUAdapterInfo *info)
+{
+    (void)adapter;
+    (void)info;
+    return WGPUStatus_Error;
+}
+
+WGPUStatus wgpuAdapterGetLimits(WGPUAdapter adapter, WGPULimits *limits)
+{
+    (void)adapter;
+    (void)limits;
+    return WGPUStatus_Error;
+}
+
+WGPUBool wgpuAdapterHasFeature(WGPUAdapter adapter, WGPUFeatureName feature)
+{
+    (void)adapter;
+    (void)feature;
+    return false;
+}
+
+void wgpuAdapterInfoFreeMembers(WGPUAdapterInfo info)
+{
+    (void)info;
+}
+
+void wgpuAdapterPropertiesMemoryHeapsFreeMembers(
+        WGPUAdapterPropertiesMemoryHeaps heaps)
+{
+    (void)heaps;
+}
+
+void wgpuAdapterPropertiesSubgroupMatrixConfigsFreeMembers(
+        WGPUAdapterPropertiesSubgroupMatrixConfigs configs)
+{
+    (void)configs;
+}
+
+void wgpuSupportedFeaturesFreeMembers(WGPUSupportedFeatures features)
+{
+    (void)features;
+}
+
+void wgpuDeviceAddRef(WGPUDevice device)
+{
+    (void)device;
+}
+
+void wgpuDeviceRelease(WGPUDevice device)
+{
+    (void)device;
+}
+
+WGPUBool wgpuDeviceHasFeature(WGPUDevice device, WGPUFeatureName feature)
+{
+    (void)device;
+    return feature == WGPUFeatureName_ImplicitDeviceSynchronization &&
+           fake_implicit_synchronization;
+}
+
+WGPUQueue wgpuDeviceGetQueue(WGPUDevice device)
+{
+    (void)device;
+    return fake_queue();
+}
+
+WGPUStatus wgpuDeviceGetLimits(WGPUDevice device, WGPULimits *limits)
+{
+    (void)device;
+    *limits = fake_limits;
+    return WGPUStatus_Success;
+}
+
+WGPUBuffer wgpuDeviceCreateBuffer(WGPUDevice                  device,
+                                  const WGPUBufferDescriptor *descriptor)
+{
+    (void)device;
+    WGPUBuffer buffer = calloc(1, sizeof(*buffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->data = calloc(1, descriptor->size ? descriptor->size : 1);
+    if (buffer->data == NULL) {
+        free(buffer);
+        return NULL;
+    }
+    buffer->size = descriptor->size;
+    atomic_init(&buffer->refs, 1);
+    pthread_mutex_lock(&lock);
+    ++live_buffers;
+    pthread_mutex_unlock(&lock);
+    return buffer;
+}
+
+void wgpuBufferDestroy(WGPUBuffer buffer)
+{
+    (void)buffer;
+}
+
+WGPUFuture wgpuBufferMapAsync(WGPUBuffer buffer, WGPUMapMode mode,
+                              size_t offset, size_t size,
+                              WGPUBufferMapCallbackInfo callbackInfo)
+{
+    (void)buffer;
+    (void)mode;
+    (void)offset;
+    (void)size;
+    return future_new((struct future){.kind = FUTURE_MAP,
+                                      .map  = callbackInfo});
+}
+
+void *wgpuBufferGetMappedRange(WGPUBuffer buffer, size_t offset, size_t size)
+{
+    (void)size;
+    return buffer->data + offset;
+}
+
+void wgpuBufferUnmap(WGPUBuffer buffer)
+{
+    (void)buffer;
+}
+
+void wgpuBufferAddRef(WGPUBuffer buffer)
+{
+    atomic_fetch_add(&buffer->refs, 1);
+}
+
+void wgpuBufferRelease(WGPUBuffer buffer)
+{
+    if (atomic_fetch_sub(&buffer->refs, 1) > 1) {
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    --live_buffers;
+    pthread_mutex_unlock(&lock);
+    free(buffer->data);
+    free(buffer);
+}
+
+WGPUCommandEncoder
+wgpuDeviceCreateCommandEncoder(WGPUDevice                          device,
+                               const WGPUCommandEncoderDescriptor *descriptor)
+{
+    (void)device;
+    (void)descriptor;
+    WGPUCommandEncoder encoder = calloc(1, sizeof(*encoder));
+    if (encoder != NULL) {
+        atomic_init(&encoder->refs, 1);
+    }
+    return encoder;
+}
+
+void wgpuCommandEncoderCopyBufferToBuffer(WGPUCommandEncoder encoder,
+                                          WGPUBuffer src, uint64_t src_offset,
+                                          WGPUBuffer dst, uint64_t dst_offset,
+                                          uint64_t size)
+{
+    struct copy *copies = realloc(encoder->copies, (encoder->copy_count + 1) *
+                                                           sizeof(*copies));
+    if (copies == NULL) {
+        abort();
+    }
+    copies[encoder->copy_count++] = (struct copy){
+            .src        = src,
+            .src_offset = src_offset,
+            .dst        = dst,
+            .dst_offset = dst_offset,
+            .size       = size,
+    };
+    encoder->copies = copies;
+}
+
+void wgpuCommandEncoderInsertDebugMarker(WGPUCommandEncoder encoder,
+                                        WGPUStringView     markerLabel)
+{
+    size_t length = markerLabel.length == WGPU_STRLEN
+                            ? strlen(markerLabel.data)
+                            : markerLabel.length;
+    char **list   = realloc(encoder->markers,
+                            (encoder->marker_count + 1) * sizeof(*list));
+    char  *marker = malloc(length + 1);
+    if (list == NULL || marker == NULL) {
+        abort();
+    }
+    memcpy(marker, markerLabel.data, length);
+    marker[length]                = '\0';
+    list[encoder->marker_count++] = marker;
+    encoder->markers              = list;
+}
+
+WGPUCommandBuffer
+wgpuCommandEncoderFinish(WGPUCommandEncoder                  encoder,
+                         const WGPUCommandBufferDescriptor *descriptor)
+{
+    (void)descriptor;
+    atomic_fetch_add(&encoder->refs, 1);
+    return ( WGPUCommandBuffer )encoder;
+}
+
+void wgpuCommandEncoderRelease(WGPUCommandEncoder encoder)
+{
+    if (atomic_fetch_sub(&encoder->refs, 1) == 1) {
+        for (size_t i = 0; i < encoder->marker_count; ++i) {
+            free(encoder->markers[i]);
+        }
+        free(encoder->markers);
+        free(encoder->copies);
+        free(encoder);
+    }
+}
+
+void wgpuCommandBufferRelease(WGPUCommandBuffer commands)
+{
+    wgpuCommandEncoderRelease(( WGPUCommandEncoder )commands);
+}
+
+void wgpuQueueAddRef(WGPUQueue queue)
+{
+    (void)queue;
+}
+
+void wgpuQueueRelease(WGPUQueue queue)
+{
+    (void)queue;
+}
+
+void wgpuQueueWriteBuffer(WGPUQueue queue, WGPUBuffer buffer,
+                          uint64_t offset, const void *data, size_t size)
+{
+    (void)queue;
+    memcpy(buffer->data + offset, data, size);
+    pthread_mutex_lock(&lock);
+    ++queue_writes;
+    pthread_mutex_unlock(&lock);
+}
+
+WGPUFuture
+wgpuQueueOnSubmittedWorkDone(WGPUQueue                     queue,
+                             WGPUQueueWorkDoneCallbackInfo callbackInfo)
+{
+    (void)queue;
+    return future_new((struct future){.kind      = FUTURE_WORK_DONE,
+                                      .work_done = callbackInfo});
+}
+
+void wgpuQueueSubmit(WGPUQueue queue, size_t count,
+                     const WGPUCommandBuffer *commands)
+{
+    (void)queue;
+    pthread_mutex_lock(&lock);
+    ++queue_submits;
+    for (size_t i = 0; i < count; ++i) {
+        WGPUCommandEncoder encoder = ( WGPUCommandEncoder )commands[i];
+        for (size_t j = 0; j < encoder->copy_count; ++j) {
+            const struct copy *c = &encoder->copies[j];
+            memmove(c->dst->data + c->dst_offset, c->src->data + c->src_offset,
+                    c->size);
+        }
+        char **list = realloc(markers, (marker_count + encoder->marker_count) *
+                                               sizeof(*list));
+        if (list == NULL && marker_count + encoder->marker_count > 0) {
+            abort();
+        }
+        for (size_t j = 0; j < encoder->marker_count; ++j) {
+            list[marker_count++] = encoder->markers[j];
+        }
+        markers = list;
+        free(encoder->markers);
+        encoder->markers      = NULL;
+        encoder->marker_count = 0;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
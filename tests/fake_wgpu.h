@@ -0,0 +1,66 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef WGPU_FAKE_WGPU_H
+#define WGPU_FAKE_WGPU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <dawn/webgpu.h>
+
+/* A host memory stand-in for the parts of webgpu.h the modules under test
+ * call, so the unit tests build and run without Dawn or a GPU. Buffers are
+ * plain allocations and the copies recorded into an encoder run when its
+ * command buffer is submitted. Work is done as soon as it is submitted, so
+ * every future completes the first time it is waited on. */
+
+/* Whether the device reports ImplicitDeviceSynchronization; true unless a
+ * test clears it. */
+extern bool fake_implicit_synchronization;
+
+/* What wgpuDeviceGetLimits reports; a test may change it before creating
+ * the module under test. */
+extern WGPULimits fake_limits;
+
+WGPUInstance fake_instance(void);
+WGPUDevice   fake_device(void);
+WGPUQueue    fake_queue(void);
+
+/* The contents of a buffer made by wgpuDeviceCreateBuffer. */
+uint8_t *fake_buffer_data(WGPUBuffer buffer);
+
+/* Buffers created and not yet released. */
+size_t fake_live_buffers(void);
+
+/* wgpuQueueWriteBuffer calls so far. */
+size_t fake_queue_writes(void);
+
+/* wgpuQueueSubmit calls so far. */
+size_t fake_queue_submits(void);
+
+/* The debug markers of every submitted command buffer, in submission
+ * order, until fake_clear_markers(). fake_marker() returns NULL past the
+ * end. */
+size_t      fake_marker_count(void);
+const char *fake_marker(size_t index);
+void        fake_clear_markers(void);
+
+#endif /* ifndef WGPU_FAKE_WGPU_H */
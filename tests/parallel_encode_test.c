@@ -0,0 +1,207 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "fake_wgpu.h"
+#include "parallel_encode.h"
+
+#define MAX_PASSES 300
+#define MAX_DEPS   3
+#define THREADS    5
+
+struct pass {
+    char name[16];
+};
+
+static struct pass passes[MAX_PASSES];
+
+/* Each pass leaves a marker with its id, so the submitted order can be read
+ * back from the fake. */
+static void encode(WGPUCommandEncoder encoder, void *userdata)
+{
+    const struct pass *p = userdata;
+    wgpuCommandEncoderInsertDebugMarker(
+            encoder, (WGPUStringView){.data = p->name, .length = WGPU_STRLEN});
+}
+
+static struct parallel_encoder *create(void)
+{
+    for (int i = 0; i < MAX_PASSES; ++i) {
+        snprintf(passes[i].name, sizeof(passes[i].name), "%d", i);
+    }
+    struct parallel_encoder *pe =
+            parallel_encoder_create(&(struct parallel_encoder_options){
+                    .device  = fake_device(),
+                    .queue   = fake_queue(),
+                    .threads = THREADS,
+            });
+    CHECK(pe != NULL);
+    return pe;
+}
+
+/* Where each pass id landed in the last submission, or -1. */
+static bool submitted_order(int count, int *where)
+{
+    for (int i = 0; i < count; ++i) {
+        where[i] = -1;
+    }
+    bool ok = ( int )fake_marker_count() == count;
+    for (size_t i = 0; ok && i < fake_marker_count(); ++i) {
+        int id = atoi(fake_marker(i));
+        ok     = id >= 0 && id < count && where[id] == -1;
+        if (ok) {
+            where[id] = ( int )i;
+        }
+    }
+    fake_clear_markers();
+    return ok;
+}
+
+/* Random DAGs, with dependencies on passes added later as well as earlier,
+ * go out in one submit in an order that respects every edge. */
+static void test_random_dag(void)
+{
+    struct parallel_encoder *pe      = create();
+    bool                     ordered = true;
+    srand(1);
+    for (int round = 0; round < 200; ++round) {
+        int n = 1 + rand() % MAX_PASSES;
+        int perm[MAX_PASSES], rank[MAX_PASSES];
+        int deps[MAX_PASSES][MAX_DEPS], dep_count[MAX_PASSES];
+        for (int i = 0; i < n; ++i) {
+            perm[i] = i;
+        }
+        for (int i = n - 1; i > 0; --i) {
+            int j   = rand() % (i + 1);
+            int t   = perm[i];
+            perm[i] = perm[j];
+            perm[j] = t;
+        }
+        for (int i = 0; i < n; ++i) {
+            rank[perm[i]] = i;
+        }
+        for (int i = 0; i < n; ++i) {
+            dep_count[i] = 0;
+            for (int k = 0; k < MAX_DEPS && rank[i] > 0; ++k) {
+                deps[i][dep_count[i]++] = perm[rand() % rank[i]];
+            }
+            int id = parallel_encoder_add(pe, encode, &passes[i],
+                                          ( uint64_t )(rand() % 5),
+                                          ( size_t )dep_count[i], deps[i]);
+            CHECK_EQ(id, i);
+        }
+
+        size_t                     submits = fake_queue_submits();
+        struct parallel_encode_run run;
+        CHECK(parallel_encoder_run(pe, &run));
+        CHECK_EQ(fake_queue_submits() - submits, 1);
+        CHECK_EQ(run.passes, ( size_t )n);
+        CHECK(run.command_buffers >= 1 && run.command_buffers <= THREADS);
+
+        int where[MAX_PASSES];
+        CHECK(submitted_order(n, where));
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < dep_count[i]; ++k) {
+                ordered = ordered && where[deps[i][k]] < where[i];
+            }
+        }
+    }
+    CHECK(ordered);
+    parallel_encoder_destroy(pe);
+}
+
+/* Equal passes without dependencies are spread over every worker. */
+static void test_split(void)
+{
+    struct parallel_encoder *pe = create();
+    for (int i = 0; i < 4 * THREADS; ++i) {
+        CHECK_EQ(parallel_encoder_add(pe, encode, &passes[i], 1, 0, NULL), i);
+    }
+    struct parallel_encode_run run;
+    CHECK(parallel_encoder_run(pe, &run));
+    CHECK_EQ(run.command_buffers, THREADS);
+
+    int where[MAX_PASSES];
+    CHECK(submitted_order(4 * THREADS, where));
+    parallel_encoder_destroy(pe);
+}
+
+/* Cycles and unknown dependencies are refused without recording anything,
+ * and the passes are cleared for the next run. */
+static void test_rejected(void)
+{
+    struct parallel_encoder *pe      = create();
+    size_t                   submits = fake_queue_submits();
+
+    int a = 1, b = 0;
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[0], 1, 1, &a), 0);
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[1], 1, 1, &b), 1);
+    struct parallel_encode_run run;
+    CHECK(!parallel_encoder_run(pe, &run));
+    CHECK_EQ(run.passes, 0);
+
+    int self = 0;
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[0], 1, 1, &self), 0);
+    CHECK(!parallel_encoder_run(pe, NULL));
+
+    int unknown = 5;
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[0], 1, 1, &unknown), 0);
+    CHECK(!parallel_encoder_run(pe, NULL));
+
+    int negative = -1;
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[0], 1, 1, &negative), 0);
+    CHECK(!parallel_encoder_run(pe, NULL));
+
+    CHECK_EQ(fake_queue_submits(), submits);
+    CHECK_EQ(fake_marker_count(), 0);
+
+    CHECK(parallel_encoder_run(pe, NULL));
+    CHECK_EQ(parallel_encoder_add(pe, encode, &passes[0], 1, 0, NULL), 0);
+    CHECK(parallel_encoder_run(pe, NULL));
+    CHECK_EQ(fake_marker_count(), 1);
+    fake_clear_markers();
+    parallel_encoder_destroy(pe);
+}
+
+/* Encoding from several threads needs ImplicitDeviceSynchronization. */
+static void test_requires_synchronization(void)
+{
+    fake_implicit_synchronization = false;
+    CHECK(parallel_encoder_create(&(struct parallel_encoder_options){
+                  .device  = fake_device(),
+                  .queue   = fake_queue(),
+                  .threads = THREADS,
+          }) == NULL);
+    fake_implicit_synchronization = true;
+}
+
+int main(void)
+{
+    test_random_dag();
+    test_split();
+    test_rejected();
+    test_requires_synchronization();
+    return check_status();
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
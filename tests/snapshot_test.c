@@ -0,0 +1,260 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "fake_wgpu.h"
+#include "snapshot.h"
+
+static const WGPUFeatureName features[] = {
+        WGPUFeatureName_ShaderF16,
+        WGPUFeatureName_TimestampQuery,
+        WGPUFeatureName_Subgroups,
+};
+
+static const WGPUMemoryHeapInfo heaps[] = {
+        {WGPUHeapProperty_DeviceLocal, 8ull << 30},
+        {WGPUHeapProperty_HostVisible | WGPUHeapProperty_HostCoherent,
+         16ull << 30},
+};
+
+static const WGPUSubgroupMatrixConfig configs[] = {
+        {WGPUSubgroupMatrixComponentType_F16,
+         WGPUSubgroupMatrixComponentType_F32, 8, 8, 8},
+};
+
+static WGPUStringView view(const char *s)
+{
+    return (WGPUStringView){.data = s, .length = strlen(s)};
+}
+
+static WGPUAdapterInfo adapter_info(void)
+{
+    WGPUAdapterInfo info = WGPU_ADAPTER_INFO_INIT;
+    info.vendor          = view("fake");
+    info.architecture    = view("arch");
+    info.device          = view("Fake GPU");
+    info.description     = view("fake driver 1.2.3");
+    info.backendType     = WGPUBackendType_Vulkan;
+    info.adapterType     = WGPUAdapterType_DiscreteGPU;
+    info.vendorID        = 0x1234;
+    info.deviceID        = 0x5678;
+    return info;
+}
+
+static struct adapter_caps adapter_caps(const WGPUAdapterInfo *info)
+{
+    struct adapter_caps caps = {
+            .vendor_id         = info->vendorID,
+            .device_id         = info->deviceID,
+            .backend_type      = info->backendType,
+            .adapter_type      = info->adapterType,
+            .subgroup_min_size = 16,
+            .subgroup_max_size = 64,
+            .power_preference  = WGPUPowerPreference_HighPerformance,
+            .vendor            = info->vendor,
+            .architecture      = info->architecture,
+            .device            = info->device,
+            .description       = info->description,
+            .feature_count     = sizeof(features) / sizeof(features[0]),
+            .features          = features,
+            .heap_count        = sizeof(heaps) / sizeof(heaps[0]),
+            .heaps             = heaps,
+            .config_count      = sizeof(configs) / sizeof(configs[0]),
+            .configs           = configs,
+    };
+    caps.limits.maxBufferSize                   = 1ull << 34;
+    caps.limits.maxBindGroups                   = 4;
+    caps.limits.maxComputeWorkgroupSizeX        = 1024;
+    caps.limits.minStorageBufferOffsetAlignment = 256;
+    return caps;
+}
+
+static bool view_equal(WGPUStringView a, WGPUStringView b)
+{
+    return a.length == b.length && memcmp(a.data, b.data, a.length) == 0 &&
+           a.data[a.length] == '\0';
+}
+
+static char dir[]  = "/tmp/snapshot_test.XXXXXX";
+static char path[sizeof(dir) + 16];
+static char driver[sizeof(dir) + 16];
+
+/* Everything written comes back from the mapping unchanged. */
+static void test_round_trip(void)
+{
+    WGPUAdapterInfo     info        = adapter_info();
+    struct adapter_caps caps        = adapter_caps(&info);
+    uint64_t            fingerprint = snapshot_fingerprint();
+    CHECK(snapshot_write(path, fingerprint, &caps));
+
+    struct snapshot snap;
+    CHECK(snapshot_map(&snap, path, fingerprint));
+    const struct adapter_caps *got = &snap.caps;
+    CHECK_EQ(got->vendor_id, caps.vendor_id);
+    CHECK_EQ(got->device_id, caps.device_id);
+    CHECK_EQ(got->backend_type, caps.backend_type);
+    CHECK_EQ(got->adapter_type, caps.adapter_type);
+    CHECK_EQ(got->subgroup_min_size, caps.subgroup_min_size);
+    CHECK_EQ(got->subgroup_max_size, caps.subgroup_max_size);
+    CHECK_EQ(got->power_preference, caps.power_preference);
+    CHECK(view_equal(got->vendor, caps.vendor));
+    CHECK(view_equal(got->architecture, caps.architecture));
+    CHECK(view_equal(got->device, caps.device));
+    CHECK(view_equal(got->description, caps.description));
+    CHECK_EQ(got->feature_count, caps.feature_count);
+    CHECK(got->feature_count == caps.feature_count &&
+          memcmp(got->features, features, sizeof(features)) == 0);
+    CHECK(memcmp(&got->limits, &caps.limits, sizeof(WGPULimits)) == 0);
+    CHECK_EQ(got->heap_count, caps.heap_count);
+    CHECK(got->heap_count == caps.heap_count &&
+          memcmp(got->heaps, heaps, sizeof(heaps)) == 0);
+    CHECK_EQ(got->config_count, caps.config_count);
+    CHECK(got->config_count == caps.config_count &&
+          memcmp(got->configs, configs, sizeof(configs)) == 0);
+    CHECK(caps_has_feature(got, WGPUFeatureName_Subgroups));
+    CHECK(!caps_has_feature(got, WGPUFeatureName_DepthClipControl));
+    CHECK(( uintptr_t )got->features % 8 == 0);
+    CHECK(( uintptr_t )got->heaps % 8 == 0);
+    snapshot_unmap(&snap);
+    CHECK(snap.addr == NULL);
+}
+
+static bool write_file(const char *name, const char *contents)
+{
+    FILE *f = fopen(name, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fputs(contents, f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+
+/* The fingerprint changes with the driver files named in the environment,
+ * and a snapshot is refused under any other fingerprint. */
+static void test_mismatch(void)
+{
+    WGPUAdapterInfo     info        = adapter_info();
+    struct adapter_caps caps        = adapter_caps(&info);
+    uint64_t            fingerprint = snapshot_fingerprint();
+    CHECK_EQ(snapshot_fingerprint(), fingerprint);
+    CHECK(snapshot_write(path, fingerprint, &caps));
+
+    struct snapshot snap;
+    CHECK(!snapshot_map(&snap, path, fingerprint + 1));
+    CHECK(snap.addr == NULL);
+
+    CHECK(write_file(driver, "driver 1.2.3"));
+    CHECK(setenv(SNAPSHOT_DRIVER_FILES_ENV, driver, 1) == 0);
+    uint64_t with_driver = snapshot_fingerprint();
+    CHECK(with_driver != fingerprint);
+    CHECK(!snapshot_map(&snap, path, with_driver));
+
+    CHECK(write_file(driver, "driver 1.2.3.4"));
+    CHECK(snapshot_fingerprint() != with_driver);
+    CHECK(unsetenv(SNAPSHOT_DRIVER_FILES_ENV) == 0);
+    CHECK_EQ(snapshot_fingerprint(), fingerprint);
+    unlink(driver);
+
+    CHECK(!snapshot_map(&snap, "/nonexistent/snapshot", fingerprint));
+}
+
+static bool rewrite(const char *contents, long size)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fwrite(contents, 1, size, f) == ( size_t )size;
+    return fclose(f) == 0 && ok;
+}
+
+/* Files altered after they were written are refused. */
+static void test_corrupt(void)
+{
+    WGPUAdapterInfo     info        = adapter_info();
+    struct adapter_caps caps        = adapter_caps(&info);
+    uint64_t            fingerprint = snapshot_fingerprint();
+    CHECK(snapshot_write(path, fingerprint, &caps));
+
+    static char contents[1 << 16];
+    FILE       *f    = fopen(path, "rb");
+    long        size = 0;
+    CHECK(f != NULL);
+    if (f != NULL) {
+        size = ( long )fread(contents, 1, sizeof(contents), f);
+        fclose(f);
+    }
+    CHECK(size > ( long )sizeof(struct snapshot_header));
+
+    struct snapshot_header header;
+    memcpy(&header, contents, sizeof(header));
+    struct snapshot snap;
+
+    contents[header.description.offset] ^= 1;
+    CHECK(rewrite(contents, size));
+    CHECK(!snapshot_map(&snap, path, fingerprint));
+    contents[header.description.offset] ^= 1;
+
+    CHECK(rewrite(contents, size));
+    CHECK(snapshot_map(&snap, path, fingerprint));
+    snapshot_unmap(&snap);
+
+    CHECK(rewrite(contents, size - 8));
+    CHECK(!snapshot_map(&snap, path, fingerprint));
+
+    struct snapshot_header bad = header;
+    bad.features.count         = 1 << 20;
+    memcpy(contents, &bad, sizeof(bad));
+    CHECK(rewrite(contents, size));
+    CHECK(!snapshot_map(&snap, path, fingerprint));
+
+    bad         = header;
+    bad.version = SNAPSHOT_VERSION + 1;
+    memcpy(contents, &bad, sizeof(bad));
+    CHECK(rewrite(contents, size));
+    CHECK(!snapshot_map(&snap, path, fingerprint));
+}
+
+int main(void)
+{
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/snapshot", dir);
+    snprintf(driver, sizeof(driver), "%s/driver", dir);
+
+    test_round_trip();
+    test_mismatch();
+    test_corrupt();
+
+    unlink(path);
+    unlink(driver);
+    rmdir(dir);
+    return check_status();
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,235 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "fake_wgpu.h"
+#include "suballoc.h"
+
+#define BLOCK_SIZE (16 * SUBALLOC_CHUNK_SIZE)
+
+static struct suballoc *create(WGPUBufferUsage usage)
+{
+    struct suballoc *a = suballoc_create(&(struct suballoc_options){
+            .device     = fake_device(),
+            .usage      = usage,
+            .block_size = BLOCK_SIZE,
+    });
+    CHECK(a != NULL);
+    return a;
+}
+
+/* Frees chunk-sized buddies out of order and checks they merge back into
+ * one free block. */
+static void test_buddy_merge(void)
+{
+    struct suballoc             *a = create(WGPUBufferUsage_Vertex);
+    const struct suballoc_range *ranges[16];
+    for (int i = 0; i < 16; ++i) {
+        ranges[i] = suballoc_alloc(a, SUBALLOC_CHUNK_SIZE);
+        CHECK(ranges[i] != NULL);
+        CHECK_EQ(ranges[i]->offset % SUBALLOC_CHUNK_SIZE, 0);
+    }
+
+    struct suballoc_report r;
+    suballoc_report(a, &r);
+    CHECK_EQ(r.blocks, 1);
+    CHECK_EQ(r.free, 0);
+    CHECK_EQ(r.largest_free, 0);
+
+    /* The chunks at 64K and 128K aren't buddies, so they stay apart... */
+    const struct suballoc_range *first = NULL;
+    for (int i = 0; i < 16; ++i) {
+        if (ranges[i]->offset == SUBALLOC_CHUNK_SIZE ||
+            ranges[i]->offset == 2 * SUBALLOC_CHUNK_SIZE) {
+            suballoc_free(a, ranges[i]);
+            ranges[i] = NULL;
+        } else if (ranges[i]->offset == 0) {
+            first = ranges[i];
+        }
+    }
+    suballoc_report(a, &r);
+    CHECK_EQ(r.free, 2 * SUBALLOC_CHUNK_SIZE);
+    CHECK_EQ(r.largest_free, SUBALLOC_CHUNK_SIZE);
+    CHECK_EQ(r.external_permille, 500);
+
+    /* ...until the chunk at 0 is freed and merges with the one at 64K. */
+    for (int i = 0; i < 16; ++i) {
+        if (ranges[i] == first) {
+            suballoc_free(a, ranges[i]);
+            ranges[i] = NULL;
+        }
+    }
+    suballoc_report(a, &r);
+    CHECK_EQ(r.largest_free, 2 * SUBALLOC_CHUNK_SIZE);
+
+    static const int order[] = {15, 3, 9, 4, 12, 6, 7, 5, 14, 8, 13, 10, 11,
+                                0,  1, 2};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+        if (ranges[order[i]] != NULL) {
+            suballoc_free(a, ranges[order[i]]);
+        }
+    }
+    suballoc_report(a, &r);
+    CHECK_EQ(r.free, BLOCK_SIZE);
+    CHECK_EQ(r.largest_free, BLOCK_SIZE);
+    CHECK_EQ(r.external_permille, 0);
+    CHECK_EQ(r.ranges, 0);
+
+    /* Fully merged, the block serves its whole size again. */
+    const struct suballoc_range *whole = suballoc_alloc(a, BLOCK_SIZE);
+    CHECK(whole != NULL);
+    suballoc_report(a, &r);
+    CHECK_EQ(r.blocks, 1);
+    suballoc_free(a, whole);
+    suballoc_destroy(a);
+    CHECK_EQ(fake_live_buffers(), 0);
+}
+
+/* Small ranges share slabs, and a slab's chunk goes back to its buddy
+ * allocator once the slab is empty. */
+static void test_slab(void)
+{
+    struct suballoc             *a = create(WGPUBufferUsage_Vertex);
+    const struct suballoc_range *ranges[300];
+    for (int i = 0; i < 300; ++i) {
+        ranges[i] = suballoc_alloc(a, 100);
+        CHECK(ranges[i] != NULL);
+        CHECK_EQ(ranges[i]->offset % 256, 0);
+        for (int j = 0; j < i; ++j) {
+            CHECK(ranges[j]->offset != ranges[i]->offset);
+        }
+    }
+
+    struct suballoc_report r;
+    suballoc_report(a, &r);
+    CHECK_EQ(r.slabs, 2);
+    CHECK_EQ(r.requested, 300 * 100);
+    CHECK_EQ(r.allocated, 300 * 256);
+    CHECK_EQ(r.free, BLOCK_SIZE - 2 * SUBALLOC_CHUNK_SIZE);
+
+    for (int i = 0; i < 300; i += 2) {
+        suballoc_free(a, ranges[i]);
+    }
+    for (int i = 299; i > 0; i -= 2) {
+        suballoc_free(a, ranges[i]);
+    }
+    suballoc_report(a, &r);
+    CHECK_EQ(r.slabs, 0);
+    CHECK_EQ(r.allocated, 0);
+    CHECK_EQ(r.free, BLOCK_SIZE);
+    CHECK_EQ(r.largest_free, BLOCK_SIZE);
+    suballoc_destroy(a);
+}
+
+/* Every offset honours the storage alignment the device reports. */
+static void test_alignment(void)
+{
+    WGPULimits saved                            = fake_limits;
+    fake_limits.minStorageBufferOffsetAlignment = 1024;
+    struct suballoc *a = create(WGPUBufferUsage_Storage);
+    fake_limits        = saved;
+
+    static const uint64_t sizes[] = {4, 300, 1024, 5000, 20000, 70000};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            const struct suballoc_range *range = suballoc_alloc(a, sizes[i]);
+            CHECK(range != NULL);
+            CHECK_EQ(range->offset % 1024, 0);
+            CHECK(range->size == sizes[i]);
+        }
+    }
+    CHECK(suballoc_alloc(a, BLOCK_SIZE + 1) == NULL);
+    suballoc_destroy(a);
+}
+
+struct moves {
+    int        count;
+    WGPUBuffer old_buffer;
+};
+
+static void moved(const struct suballoc_range *range, WGPUBuffer old_buffer,
+                  uint64_t old_offset, void *userdata)
+{
+    struct moves *m = userdata;
+    (void)range;
+    (void)old_offset;
+    ++m->count;
+    m->old_buffer = old_buffer;
+}
+
+/* A sparse block is emptied into the fullest one, contents included. */
+static void test_defrag(void)
+{
+    struct suballoc             *a = create(WGPUBufferUsage_Vertex);
+    const struct suballoc_range *full[16];
+    for (int i = 0; i < 16; ++i) {
+        full[i] = suballoc_alloc(a, SUBALLOC_CHUNK_SIZE);
+    }
+    const struct suballoc_range *sparse[2];
+    for (int i = 0; i < 2; ++i) {
+        sparse[i] = suballoc_alloc(a, 1000 + i);
+        CHECK(sparse[i] != NULL);
+        CHECK(sparse[i]->buffer != full[0]->buffer);
+        memset(fake_buffer_data(sparse[i]->buffer) + sparse[i]->offset,
+               0xA0 + i, sparse[i]->size);
+    }
+    WGPUBuffer sparse_buffer = sparse[0]->buffer;
+    for (int i = 0; i < 16; i += 4) {
+        suballoc_free(a, full[i]);
+    }
+
+    struct moves m = {0};
+    CHECK_EQ(suballoc_defrag(a, fake_queue(), 500, moved, &m), 2);
+    CHECK_EQ(m.count, 2);
+    CHECK(m.old_buffer == sparse_buffer);
+
+    struct suballoc_report r;
+    suballoc_report(a, &r);
+    CHECK_EQ(r.blocks, 1);
+    CHECK_EQ(fake_live_buffers(), 1);
+    for (int i = 0; i < 2; ++i) {
+        CHECK(sparse[i]->buffer == full[1]->buffer);
+        const uint8_t *data =
+                fake_buffer_data(sparse[i]->buffer) + sparse[i]->offset;
+        bool intact = true;
+        for (uint64_t j = 0; j < sparse[i]->size; ++j) {
+            intact = intact && data[j] == 0xA0 + i;
+        }
+        CHECK(intact);
+    }
+
+    /* Nothing sparse is left, so a second pass moves nothing. */
+    CHECK_EQ(suballoc_defrag(a, fake_queue(), 500, moved, &m), 0);
+    suballoc_destroy(a);
+    CHECK_EQ(fake_live_buffers(), 0);
+}
+
+int main(void)
+{
+    test_buddy_merge();
+    test_slab();
+    test_alignment();
+    test_defrag();
+    return check_status();
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
@@ -0,0 +1,176 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "fake_wgpu.h"
+#include "submit_scheduler.h"
+
+#define COMMANDS    100
+#define BATCH_COUNT 8
+
+#define US  1000ull
+#define MAX 3600000000000ull
+
+/* Bucket i of the histogram holds latencies below 2^(i + 1) microseconds. */
+static uint64_t bound(size_t bucket)
+{
+    return (2ull << bucket) * US;
+}
+
+static void test_percentile_empty(void)
+{
+    struct submit_scheduler_stats stats = {0};
+    CHECK_EQ(submit_latency_percentile(&stats, 50), 0);
+    CHECK_EQ(submit_latency_percentile(&stats, 100), 0);
+}
+
+/* The percentile is the upper bound of the bucket holding that rank, but
+ * never more than the largest latency seen. */
+static void test_percentile_buckets(void)
+{
+    struct submit_scheduler_stats stats = {0};
+    stats.latency[0]                    = 50;
+    stats.latency[3]                    = 45;
+    stats.latency[10]                   = 5;
+    stats.latency_max_ns                = 1500 * US;
+
+    CHECK_EQ(submit_latency_percentile(&stats, 0), bound(0));
+    CHECK_EQ(submit_latency_percentile(&stats, 1), bound(0));
+    CHECK_EQ(submit_latency_percentile(&stats, 50), bound(0));
+    CHECK_EQ(submit_latency_percentile(&stats, 50.5), bound(3));
+    CHECK_EQ(submit_latency_percentile(&stats, 95), bound(3));
+    CHECK_EQ(submit_latency_percentile(&stats, 96), 1500 * US);
+    CHECK_EQ(submit_latency_percentile(&stats, 99), 1500 * US);
+    CHECK_EQ(submit_latency_percentile(&stats, 100), 1500 * US);
+
+    stats.latency_max_ns = 10 * US;
+    CHECK_EQ(submit_latency_percentile(&stats, 50), bound(0));
+    CHECK_EQ(submit_latency_percentile(&stats, 60), 10 * US);
+}
+
+/* The last bucket has no upper bound of its own, so it reports the
+ * largest latency seen. */
+static void test_percentile_last_bucket(void)
+{
+    struct submit_scheduler_stats stats       = {0};
+    stats.latency[SUBMIT_LATENCY_BUCKETS - 1] = 1;
+    stats.latency_max_ns                      = MAX;
+    CHECK_EQ(submit_latency_percentile(&stats, 50), MAX);
+
+    stats.latency[0] = 99;
+    CHECK_EQ(submit_latency_percentile(&stats, 99), bound(0));
+    CHECK_EQ(submit_latency_percentile(&stats, 99.5), MAX);
+}
+
+static int ids[COMMANDS];
+static int completed[COMMANDS];
+static int completed_count;
+static int failed;
+
+/* Only the scheduler thread runs these, and flush orders them before the
+ * test reads the results. */
+static void done(WGPUQueueWorkDoneStatus status, void *userdata)
+{
+    failed += status != WGPUQueueWorkDoneStatus_Success;
+    completed[completed_count++] = *( int * )userdata;
+}
+
+static WGPUCommandBuffer command(int id)
+{
+    char               name[16];
+    WGPUCommandEncoder encoder =
+            wgpuDeviceCreateCommandEncoder(fake_device(), NULL);
+    snprintf(name, sizeof(name), "%d", id);
+    wgpuCommandEncoderInsertDebugMarker(
+            encoder, (WGPUStringView){.data = name, .length = WGPU_STRLEN});
+    WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuCommandEncoderRelease(encoder);
+    return cmd;
+}
+
+/* Command buffers go out in enqueue order, in batches of at most
+ * BATCH_COUNT, and complete in that order with every batch timed. */
+static void test_scheduler(void)
+{
+    struct submit_scheduler *s =
+            submit_scheduler_create(&(struct submit_scheduler_options){
+                    .instance        = fake_instance(),
+                    .queue           = fake_queue(),
+                    .max_batch_count = BATCH_COUNT,
+                    .max_delay_ns    = 1000 * US,
+            });
+    CHECK(s != NULL);
+    fake_clear_markers();
+
+    for (int i = 0; i < COMMANDS; ++i) {
+        ids[i] = i;
+        CHECK(submit_scheduler_enqueue(s, command(i), 1, done, &ids[i],
+                                       SUBMIT_WAIT_FOREVER));
+    }
+    CHECK(submit_scheduler_flush(s, SUBMIT_WAIT_FOREVER));
+
+    CHECK_EQ(completed_count, COMMANDS);
+    CHECK_EQ(failed, 0);
+    CHECK_EQ(fake_marker_count(), COMMANDS);
+    bool ordered = true;
+    for (int i = 0; i < COMMANDS; ++i) {
+        const char *marker = fake_marker(( size_t )i);
+        char        name[16];
+        snprintf(name, sizeof(name), "%d", i);
+        ordered = ordered && completed[i] == i && marker != NULL &&
+                  strcmp(marker, name) == 0;
+    }
+    CHECK(ordered);
+    fake_clear_markers();
+
+    struct submit_scheduler_stats stats;
+    submit_scheduler_stats(s, &stats);
+    CHECK_EQ(stats.enqueued, COMMANDS);
+    CHECK_EQ(stats.completed, COMMANDS);
+    CHECK(stats.submits >= (COMMANDS + BATCH_COUNT - 1) / BATCH_COUNT);
+    CHECK_EQ(stats.in_flight, 0);
+    CHECK_EQ(stats.queued, 0);
+
+    uint64_t flushes = 0, samples = 0;
+    for (int i = 0; i < SUBMIT_FLUSH_REASONS; ++i) {
+        flushes += stats.flushes[i];
+    }
+    for (int i = 0; i < SUBMIT_LATENCY_BUCKETS; ++i) {
+        samples += stats.latency[i];
+    }
+    CHECK_EQ(flushes, stats.submits);
+    CHECK_EQ(samples, stats.submits);
+    CHECK(submit_latency_percentile(&stats, 100) == stats.latency_max_ns);
+
+    submit_scheduler_destroy(s);
+}
+
+int main(void)
+{
+    test_percentile_empty();
+    test_percentile_buckets();
+    test_percentile_last_bucket();
+    test_scheduler();
+    return check_status();
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
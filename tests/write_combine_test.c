@@ -0,0 +1,196 @@
+/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "fake_wgpu.h"
+#include "write_combine.h"
+
+#define BUFFER_SIZE 4096
+
+struct fixture {
+    struct upload_ring   *ring;
+    struct write_combine *wc;
+};
+
+static struct fixture setup(uint64_t segment_size, size_t segment_count)
+{
+    struct fixture f;
+    f.ring = upload_ring_create(&(struct upload_ring_options){
+            .instance      = fake_instance(),
+            .device        = fake_device(),
+            .segment_size  = segment_size,
+            .segment_count = segment_count,
+    });
+    CHECK(f.ring != NULL);
+    f.wc = write_combine_create(fake_device(), f.ring);
+    CHECK(f.wc != NULL);
+    return f;
+}
+
+static void teardown(struct fixture *f)
+{
+    write_combine_destroy(f->wc);
+    upload_ring_destroy(f->ring);
+}
+
+static WGPUBuffer buffer(void)
+{
+    WGPUBufferDescriptor desc = WGPU_BUFFER_DESCRIPTOR_INIT;
+    desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Storage;
+    desc.size  = BUFFER_SIZE;
+    return wgpuDeviceCreateBuffer(fake_device(), &desc);
+}
+
+static void fill(uint8_t *data, size_t size, uint8_t value)
+{
+    memset(data, value, size);
+}
+
+/* Overlapping and touching writes become one copy, later writes winning;
+ * a gap starts a new span. */
+static void test_merge_order(void)
+{
+    struct fixture f   = setup(1024, 4);
+    WGPUBuffer     dst = buffer();
+    uint8_t        a[16], b[16], c[16], d[4];
+    fill(a, sizeof(a), 0xAA);
+    fill(b, sizeof(b), 0xBB);
+    fill(c, sizeof(c), 0xCC);
+    fill(d, sizeof(d), 0xDD);
+
+    CHECK(write_combine_write(f.wc, dst, 16, b, sizeof(b)));
+    CHECK(write_combine_write(f.wc, dst, 0, a, sizeof(a)));
+    CHECK(write_combine_write(f.wc, dst, 8, c, sizeof(c)));
+    CHECK(write_combine_write(f.wc, dst, 100, d, sizeof(d)));
+    CHECK(!write_combine_write(f.wc, dst, 2, d, sizeof(d)));
+    CHECK(write_combine_submit(f.wc, fake_queue(), 0, NULL,
+                               UPLOAD_WAIT_FOREVER));
+
+    const uint8_t *data = fake_buffer_data(dst);
+    for (int i = 0; i < 32; ++i) {
+        uint8_t want = i < 8 ? 0xAA : i < 24 ? 0xCC : 0xBB;
+        CHECK_EQ(data[i], want);
+    }
+    CHECK_EQ(data[32], 0);
+    CHECK_EQ(data[99], 0);
+    CHECK_EQ(data[100], 0xDD);
+    CHECK_EQ(data[104], 0);
+
+    struct write_combine_stats s;
+    write_combine_stats(f.wc, &s);
+    CHECK_EQ(s.writes, 4);
+    CHECK_EQ(s.copies, 2);
+    CHECK_EQ(s.staged_bytes, 32 + 4);
+    CHECK_EQ(s.fallbacks, 0);
+    CHECK_EQ(s.dropped, 0);
+
+    wgpuBufferRelease(dst);
+    teardown(&f);
+}
+
+/* Random writes over two buffers end up exactly as if each had been
+ * written in order, in fewer copies. */
+static void test_random(void)
+{
+    struct fixture  f        = setup(8192, 4);
+    WGPUBuffer      dst[2]   = {buffer(), buffer()};
+    static uint8_t  want[2][BUFFER_SIZE];
+    uint64_t        writes   = 0;
+    bool            matching = true;
+    srand(1);
+    for (int round = 0; round < 50; ++round) {
+        for (int k = 0; k < 100; ++k) {
+            int      which = rand() % 2;
+            uint64_t size  = 4 * (1 + rand() % 8);
+            uint64_t off   = 4 * (rand() % ((BUFFER_SIZE - size) / 4));
+            uint8_t  data[32];
+            for (uint64_t j = 0; j < size; ++j) {
+                data[j] = ( uint8_t )rand();
+            }
+            memcpy(want[which] + off, data, size);
+            CHECK(write_combine_write(f.wc, dst[which], off, data, size));
+            ++writes;
+        }
+        CHECK(write_combine_submit(f.wc, fake_queue(), 0, NULL,
+                                   UPLOAD_WAIT_FOREVER));
+        for (int i = 0; i < 2; ++i) {
+            matching = matching && memcmp(fake_buffer_data(dst[i]), want[i],
+                                          BUFFER_SIZE) == 0;
+        }
+    }
+    CHECK(matching);
+
+    struct write_combine_stats s;
+    write_combine_stats(f.wc, &s);
+    CHECK_EQ(s.writes, writes);
+    CHECK(s.copies < s.writes);
+    CHECK_EQ(s.flushes, 50);
+    CHECK_EQ(s.dropped, 0);
+
+    wgpuBufferRelease(dst[0]);
+    wgpuBufferRelease(dst[1]);
+    teardown(&f);
+}
+
+/* Spans the full ring has no room for go out through WriteBuffer rather
+ * than being dropped. */
+static void test_fallback(void)
+{
+    struct fixture f   = setup(256, 2);
+    WGPUBuffer     dst = buffer();
+    uint8_t        data[256];
+    size_t         before = fake_queue_writes();
+    for (int i = 0; i < 3; ++i) {
+        fill(data, sizeof(data), ( uint8_t )(1 + i));
+        CHECK(write_combine_write(f.wc, dst, 1024 * ( uint64_t )i, data,
+                                  sizeof(data)));
+    }
+    CHECK(write_combine_submit(f.wc, fake_queue(), 0, NULL, 0));
+
+    const uint8_t *out = fake_buffer_data(dst);
+    for (int i = 0; i < 3; ++i) {
+        CHECK_EQ(out[1024 * i], 1 + i);
+        CHECK_EQ(out[1024 * i + 255], 1 + i);
+    }
+    struct write_combine_stats s;
+    write_combine_stats(f.wc, &s);
+    CHECK_EQ(s.copies, 2);
+    CHECK_EQ(s.fallbacks, 1);
+    CHECK_EQ(s.fallback_bytes, 256);
+    CHECK_EQ(s.dropped, 0);
+    CHECK_EQ(fake_queue_writes() - before, 1);
+
+    wgpuBufferRelease(dst);
+    teardown(&f);
+}
+
+int main(void)
+{
+    test_merge_order();
+    test_random();
+    test_fallback();
+    CHECK_EQ(fake_live_buffers(), 0);
+    return check_status();
+}
+
+// vim: set ft=c ts=4 sts=4 sw=4 et cin ai nospell
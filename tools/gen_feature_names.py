@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 h5law <dev@h5law.com>
+#
+# Regenerates src/feature_names.h from the WGPUFeatureName enum in the
+# vendored <dawn/webgpu.h>. Run from the repository root after updating
+# extern/dawn:
+#
+#   python3 tools/gen_feature_names.py > src/feature_names.h
+
+import re
+import sys
+
+HEADER = "extern/dawn/include/dawn/webgpu.h"
+CORE_BASE = 0x00000000
+DAWN_BASE = 0x00050000
+SLOT_BITS = 9
+
+LICENSE = """/* Copyright (c) 2025 h5law <dev@h5law.com>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgement in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */"""
+
+
+def parse(path):
+    text = open(path).read()
+    body = re.search(r"typedef enum WGPUFeatureName \{(.*?)\}", text, re.S)
+    features = []
+    for name, value in re.findall(r"WGPUFeatureName_(\w+) = (0x[0-9A-Fa-f]+)",
+                                  body.group(1)):
+        if name != "Force32":
+            features.append((name, int(value, 16)))
+    return features
+
+
+# Must match feature_hash() in the generated header.
+def fnv1a(seed, name):
+    h = (0x811C9DC5 ^ seed) & 0xFFFFFFFF
+    for c in name.encode():
+        h ^= c
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def find_seed(names):
+    mask = (1 << SLOT_BITS) - 1
+    for seed in range(1 << 24):
+        slots = {fnv1a(seed, n) & mask for n in names}
+        if len(slots) == len(names):
+            return seed
+    sys.exit("no perfect hash seed found; raise SLOT_BITS")
+
+
+def main():
+    features = parse(sys.argv[1] if len(sys.argv) > 1 else HEADER)
+    core = [(n, v - CORE_BASE) for n, v in features if v < DAWN_BASE]
+    dawn = [(n, v - DAWN_BASE) for n, v in features if v >= DAWN_BASE]
+    assert all(0 <= i < 0x10000 for _, i in core + dawn)
+    assert len(features) < 0xFF
+
+    seed = find_seed([n for n, _ in features])
+    mask = (1 << SLOT_BITS) - 1
+    slots = [0] * (1 << SLOT_BITS)
+    for i, (name, _) in enumerate(features):
+        slots[fnv1a(seed, name) & mask] = i + 1
+
+    out = [LICENSE, "", "/* Generated by tools/gen_feature_names.py; do not edit. */", ""]
+    out += ["#ifndef WGPU_FEATURES_H", "#define WGPU_FEATURES_H", ""]
+    out += ["#include <stddef.h>", "#include <stdint.h>", "#include <string.h>", ""]
+    out += ["#include <dawn/webgpu.h>", ""]
+    out += ["#define FEATURE_CORE_BASE  0x%08Xu" % CORE_BASE,
+            "#define FEATURE_CORE_COUNT %d" % (max(i for _, i in core) + 1),
+            "#define FEATURE_DAWN_BASE  0x%08Xu" % DAWN_BASE,
+            "#define FEATURE_DAWN_COUNT %d" % (max(i for _, i in dawn) + 1),
+            "#define FEATURE_COUNT      %d" % len(features),
+            "#define FEATURE_HASH_SEED  0x%08Xu" % seed,
+            "#define FEATURE_HASH_BITS  %d" % SLOT_BITS,
+            ""]
+
+    out.append("/* Forward tables, indexed by code - base; gaps are NULL. */")
+    for tag, entries in (("core", core), ("dawn", dawn)):
+        out.append("static const char *const feature_names_%s[FEATURE_%s_COUNT] = {"
+                   % (tag, tag.upper()))
+        for name, i in entries:
+            out.append('    [0x%02X] = "%s",' % (i, name))
+        out += ["};", ""]
+
+    out.append("struct feature_entry {")
+    out.append("    const char     *name;")
+    out.append("    uint8_t         length;")
+    out.append("    WGPUFeatureName code;")
+    out += ["};", ""]
+    out.append("static const struct feature_entry feature_entries[FEATURE_COUNT] = {")
+    for name, value in features:
+        out.append('    {"%s", %d, WGPUFeatureName_%s},' % (name, len(name), name))
+    out += ["};", ""]
+
+    out.append("/* Perfect hash over the names above: slot -> entry index + 1. */")
+    out.append("static const uint8_t feature_slots[1u << FEATURE_HASH_BITS] = {")
+    row = []
+    for i, s in enumerate(slots):
+        if s:
+            row.append("[%d] = %d" % (i, s))
+    line = "   "
+    for item in row:
+        if len(line) + len(item) + 2 > 80:
+            out.append(line)
+            line = "   "
+        line += " " + item + ","
+    out.append(line)
+    out += ["};", ""]
+
+    out += ["""static inline uint32_t feature_hash(const char *name, size_t length)
+{
+    uint32_t h = 0x811C9DC5u ^ FEATURE_HASH_SEED;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= ( uint8_t )name[i];
+        h *= 0x01000193u;
+    }
+    return h;
+}
+
+/* Returns the feature name for code, or "" when the code is unknown. */
+static inline const char *feature_name(uint32_t code)
+{
+    const char *name = NULL;
+    if (code - FEATURE_CORE_BASE < FEATURE_CORE_COUNT) {
+        name = feature_names_core[code - FEATURE_CORE_BASE];
+    } else if (code - FEATURE_DAWN_BASE < FEATURE_DAWN_COUNT) {
+        name = feature_names_dawn[code - FEATURE_DAWN_BASE];
+    }
+    return name != NULL ? name : "";
+}
+
+/* Returns the code for the length bytes at name, or 0 when there is none. */
+static inline WGPUFeatureName feature_from_name(const char *name,
+                                                size_t      length)
+{
+    uint32_t slot = feature_hash(name, length) &
+                    ((1u << FEATURE_HASH_BITS) - 1);
+    uint8_t  index = feature_slots[slot];
+    if (index == 0) {
+        return ( WGPUFeatureName )0;
+    }
+    const struct feature_entry *entry = &feature_entries[index - 1];
+    if (entry->length != length || memcmp(entry->name, name, length) != 0) {
+        return ( WGPUFeatureName )0;
+    }
+    return entry->code;
+}
+
+#define _FEATURE_NAME_FROM_CODE(code) feature_name(code)
+
+#endif /* ifndef WGPU_FEATURES_H */"""]
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()